@@ -0,0 +1,74 @@
+/*
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include <osmium/io/any_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/entity.hpp>
+
+template <typename TFunc>
+void run(const char* name, TFunc&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto cpu_start = std::clock();
+    const auto result = func();
+    const auto cpu_stop = std::clock();
+    const auto stop = std::chrono::steady_clock::now();
+    std::cout << name
+              << " wall=" << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms"
+              << " cpu=" << (1000 * (cpu_stop - cpu_start) / CLOCKS_PER_SEC) << "ms"
+              << " (" << result << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3 || (std::strcmp(argv[2], "new") && std::strcmp(argv[2], "pool"))) {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE new|pool\n";
+        std::exit(1);
+    }
+
+    const osmium::io::File input_file{argv[1]};
+
+    if (!std::strcmp(argv[2], "new")) {
+        run("read", [&]{
+            uint64_t count = 0;
+            osmium::io::Reader reader{input_file};
+            while (osmium::memory::Buffer buffer = reader.read()) {
+                for (const auto& entity : buffer.select<osmium::OSMEntity>()) {
+                    count += entity.byte_size();
+                }
+            }
+            reader.close();
+            return count;
+        });
+    } else {
+        osmium::memory::BufferPool pool;
+        run("read", [&]{
+            uint64_t count = 0;
+            osmium::io::Reader reader{input_file, pool};
+            while (osmium::memory::Buffer buffer = reader.read()) {
+                for (const auto& entity : buffer.select<osmium::OSMEntity>()) {
+                    count += entity.byte_size();
+                }
+                pool.put(std::move(buffer));
+            }
+            reader.close();
+            return count;
+        });
+        const auto stats = pool.stats();
+        std::cout << "buffers allocated=" << stats.allocated
+                  << " reused=" << stats.reused
+                  << " returned=" << stats.returned
+                  << " dropped=" << stats.dropped << '\n';
+    }
+}
+
@@ -0,0 +1,116 @@
+/*
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <osmium/area/detail/segment_list.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/relations/relations_manager.hpp>
+#include <osmium/visitor.hpp>
+
+using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+
+struct relation_result {
+    osmium::object_id_type id;
+    std::size_t segments;
+    uint32_t intersections;
+    int64_t microseconds;
+};
+
+// Builds the segment lists for all multipolygon and boundary relations
+// and times the intersection search on them.
+class IntersectionsManager : public osmium::relations::RelationsManager<IntersectionsManager, false, true, false> {
+
+    std::vector<relation_result> m_results;
+
+public:
+
+    bool new_relation(const osmium::Relation& relation) const {
+        const char* type = relation.tags().get_value_by_key("type");
+        return type && (!std::strcmp(type, "multipolygon") || !std::strcmp(type, "boundary"));
+    }
+
+    void complete_relation(const osmium::Relation& relation) {
+        std::vector<const osmium::Way*> ways;
+        for (const auto& member : relation.members()) {
+            if (member.ref() != 0) {
+                ways.push_back(this->get_member_way(member.ref()));
+            }
+        }
+
+        osmium::area::detail::SegmentList segment_list{false};
+        uint64_t duplicate_nodes = 0;
+        uint64_t duplicate_ways = 0;
+        uint64_t duplicate_segments = 0;
+        uint64_t overlapping_segments = 0;
+        segment_list.extract_segments_from_ways(nullptr, duplicate_nodes, duplicate_ways, relation, ways);
+        segment_list.sort();
+        segment_list.erase_duplicate_segments(nullptr, duplicate_segments, overlapping_segments);
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto intersections = segment_list.find_intersections(nullptr);
+        const auto stop = std::chrono::steady_clock::now();
+
+        m_results.push_back(relation_result{relation.id(),
+                                            segment_list.size(),
+                                            intersections,
+                                            std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()});
+    }
+
+    std::vector<relation_result>& results() noexcept {
+        return m_results;
+    }
+
+}; // class IntersectionsManager
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE [NUM_RELATIONS]\n";
+        std::exit(1);
+    }
+
+    const osmium::io::File input_file{argv[1]};
+    const std::size_t num_relations = argc == 3 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+    IntersectionsManager manager;
+    osmium::relations::read_relations(input_file, manager);
+
+    index_type index;
+    location_handler_type location_handler{index};
+    location_handler.ignore_errors();
+
+    osmium::io::Reader reader{input_file, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way};
+    osmium::apply(reader, location_handler, manager.handler());
+    reader.close();
+
+    auto& results = manager.results();
+    std::sort(results.begin(), results.end(), [](const relation_result& a, const relation_result& b) {
+        return a.segments > b.segments;
+    });
+
+    if (results.size() > num_relations) {
+        results.resize(num_relations);
+    }
+
+    int64_t total = 0;
+    for (const auto& result : results) {
+        std::cout << "r" << result.id
+                  << " segments=" << result.segments
+                  << " intersections=" << result.intersections
+                  << " time=" << result.microseconds << "us\n";
+        total += result.microseconds;
+    }
+    std::cout << "total time=" << total << "us\n";
+}
@@ -14,19 +14,21 @@
 
 #include <osmium/io/any_input.hpp>
 #include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
 
 using index_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
 
 using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " OSMFILE FORMAT\n";
+    if (argc != 3 && argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE FORMAT [batch]\n";
         std::exit(1);
     }
 
     const std::string input_filename{argv[1]};
     const std::string location_store{argv[2]};
+    const bool batch = argc == 4 && std::string{argv[3]} == "batch";
 
     osmium::io::Reader reader{input_filename};
 
@@ -35,7 +37,14 @@ int main(int argc, char* argv[]) {
     location_handler_type location_handler{*index};
     location_handler.ignore_errors();
 
-    osmium::apply(reader, location_handler);
+    if (batch) {
+        // Look up the node locations of all ways in a buffer together.
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            location_handler.process_buffer(buffer);
+        }
+    } else {
+        osmium::apply(reader, location_handler);
+    }
     reader.close();
 }
 
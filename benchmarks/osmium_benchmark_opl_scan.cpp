@@ -0,0 +1,125 @@
+/*
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <osmium/io/any_input.hpp>
+#include <osmium/io/detail/opl_output_format.hpp>
+#include <osmium/io/detail/string_scan.hpp>
+#include <osmium/osm/location.hpp>
+
+namespace oid = osmium::io::detail;
+
+// Split the text into lines, return number of lines.
+template <bool TSimd>
+uint64_t count_lines(const std::string& text) {
+    const char* s = text.data();
+    const char* const end = s + text.size();
+    uint64_t count = 0;
+    while (s != end) {
+        s = TSimd ? oid::find_first_of_in_range<'\n', '\r'>(s, end)
+                  : oid::find_first_of_in_range_scalar<'\n', '\r'>(s, end);
+        if (s != end) {
+            ++s;
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Split the lines into fields and the fields into strings the way the
+// OPL parser does, return number of strings.
+template <bool TSimd>
+uint64_t count_strings(const std::vector<std::string>& lines) {
+    uint64_t count = 0;
+    for (const auto& line : lines) {
+        const char* s = line.c_str();
+        while (*s != '\0') {
+            s = TSimd ? oid::find_first_of_or_end<' ', '\t', ',', '=', '%'>(s)
+                      : oid::find_first_of_or_end_scalar<' ', '\t', ',', '=', '%'>(s);
+            ++count;
+            if (*s != '\0') {
+                ++s;
+            }
+        }
+    }
+    return count;
+}
+
+// Parse all x and y fields in the lines, return sum of coordinates.
+template <bool TFast>
+int64_t parse_coordinates(const std::vector<std::string>& lines) {
+    int64_t sum = 0;
+    for (const auto& line : lines) {
+        for (const char* s = std::strchr(line.c_str(), ' '); s; s = std::strchr(s, ' ')) {
+            ++s;
+            if ((*s == 'x' || *s == 'y') && s[1] != ' ' && s[1] != '\0') {
+                ++s;
+                int32_t value = 0;
+                if (!TFast || !osmium::detail::fast_string_to_location_coordinate(&s, &value)) {
+                    value = osmium::detail::general_string_to_location_coordinate(&s);
+                }
+                sum += value;
+            }
+        }
+    }
+    return sum;
+}
+
+template <typename TFunc>
+void run(const char* name, TFunc&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = func();
+    const auto stop = std::chrono::steady_clock::now();
+    std::cout << name << ' ' << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms (" << result << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3 || (std::strcmp(argv[2], "scalar") && std::strcmp(argv[2], "simd"))) {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE scalar|simd\n";
+        std::exit(1);
+    }
+
+    const std::string input_filename{argv[1]};
+    const bool simd = !std::strcmp(argv[2], "simd");
+
+    // Convert input into OPL format in memory.
+    oid::opl_output_options options;
+    options.add_metadata = true;
+    options.locations_on_ways = false;
+    options.format_as_diff = false;
+
+    std::string text;
+    osmium::io::Reader reader{input_filename};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        text += oid::OPLOutputBlock{std::move(buffer), options}();
+    }
+    reader.close();
+
+    std::vector<std::string> lines;
+    std::string::size_type pos = 0;
+    for (auto next = text.find('\n'); next != std::string::npos; next = text.find('\n', pos)) {
+        lines.emplace_back(text, pos, next - pos);
+        pos = next + 1;
+    }
+
+    if (simd) {
+        run("lines", [&]{ return count_lines<true>(text); });
+        run("strings", [&]{ return count_strings<true>(lines); });
+        run("coordinates", [&]{ return parse_coordinates<true>(lines); });
+    } else {
+        run("lines", [&]{ return count_lines<false>(text); });
+        run("strings", [&]{ return count_strings<false>(lines); });
+        run("coordinates", [&]{ return parse_coordinates<false>(lines); });
+    }
+}
+
@@ -0,0 +1,131 @@
+/*
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <osmium/handler.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/visitor.hpp>
+
+struct TimestampCollector : public osmium::handler::Handler {
+
+    std::vector<uint32_t> timestamps;
+
+    void osm_object(const osmium::OSMObject& object) {
+        timestamps.push_back(uint32_t(object.timestamp()));
+    }
+
+}; // struct TimestampCollector
+
+// This is how timestamps were formatted and parsed before.
+
+std::string libc_format(uint32_t timestamp) {
+    const time_t sse = timestamp;
+    struct tm tm;
+#ifndef _WIN32
+    gmtime_r(&sse, &tm);
+#else
+    gmtime_s(&tm, &sse);
+#endif
+    std::string s(21, '\0');
+    s.resize(strftime(&s[0], 21, "%Y-%m-%dT%H:%M:%SZ", &tm));
+    return s;
+}
+
+time_t libc_parse(const char* str) {
+    struct tm tm;
+    tm.tm_year = (str[0] - '0') * 1000 + (str[1] - '0') * 100 + (str[2] - '0') * 10 + (str[3] - '0') - 1900;
+    tm.tm_mon  = (str[ 5] - '0') * 10 + (str[ 6] - '0') - 1;
+    tm.tm_mday = (str[ 8] - '0') * 10 + (str[ 9] - '0');
+    tm.tm_hour = (str[11] - '0') * 10 + (str[12] - '0');
+    tm.tm_min  = (str[14] - '0') * 10 + (str[15] - '0');
+    tm.tm_sec  = (str[17] - '0') * 10 + (str[18] - '0');
+    tm.tm_wday = 0;
+    tm.tm_yday = 0;
+    tm.tm_isdst = 0;
+#ifndef _WIN32
+    return timegm(&tm);
+#else
+    return _mkgmtime(&tm);
+#endif
+}
+
+template <typename TFunc>
+void run(const char* name, TFunc&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = func();
+    const auto stop = std::chrono::steady_clock::now();
+    std::cout << name << ' ' << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << "ms (" << result << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3 || (std::strcmp(argv[2], "libc") && std::strcmp(argv[2], "osmium"))) {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE libc|osmium\n";
+        std::exit(1);
+    }
+
+    const std::string input_filename{argv[1]};
+    const bool use_libc = !std::strcmp(argv[2], "libc");
+
+    TimestampCollector collector;
+    osmium::io::Reader reader{input_filename, osmium::osm_entity_bits::nwr};
+    osmium::apply(reader, collector);
+    reader.close();
+
+    std::vector<std::string> strings;
+    strings.reserve(collector.timestamps.size());
+    for (const auto t : collector.timestamps) {
+        if (t != 0) {
+            strings.push_back(osmium::Timestamp{t}.to_iso());
+        }
+    }
+
+    if (use_libc) {
+        run("format", [&]{
+            uint64_t sum = 0;
+            for (const auto t : collector.timestamps) {
+                sum += libc_format(t).size();
+            }
+            return sum;
+        });
+        run("parse", [&]{
+            uint64_t sum = 0;
+            for (const auto& s : strings) {
+                sum += static_cast<uint64_t>(libc_parse(s.c_str()));
+            }
+            return sum;
+        });
+    } else {
+        run("format", [&]{
+            uint64_t sum = 0;
+            std::string out;
+            for (const auto t : collector.timestamps) {
+                out.clear();
+                osmium::Timestamp{t}.to_iso(std::back_inserter(out));
+                sum += out.size();
+            }
+            return sum;
+        });
+        run("parse", [&]{
+            uint64_t sum = 0;
+            for (const auto& s : strings) {
+                sum += static_cast<uint64_t>(osmium::detail::parse_timestamp(s.c_str()));
+            }
+            return sum;
+        });
+    }
+}
+
@@ -12,16 +12,17 @@
 #include <osmium/io/any_output.hpp>
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " INPUT-FILE OUTPUT-FILE\n";
+    if (argc != 3 && argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " INPUT-FILE OUTPUT-FILE [OUTPUT-FORMAT]\n";
         std::exit(1);
     }
 
     std::string input_filename{argv[1]};
     std::string output_filename{argv[2]};
+    std::string output_format{argc == 4 ? argv[3] : "pbf"};
 
     osmium::io::Reader reader{input_filename};
-    osmium::io::File output_file{output_filename, "pbf"};
+    osmium::io::File output_file{output_filename, output_format};
     osmium::io::Header header;
     osmium::io::Writer writer{output_file, header, osmium::io::overwrite::allow};
 
@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+#  run_benchmark_buffer_pool.sh
+#
+#  Will read the input file twice, once allocating a new buffer for each
+#  block of data decoded and once getting the buffers from a BufferPool and
+#  putting them back after use. Wall clock and CPU time are reported by the
+#  benchmark program itself, the difference in CPU time is mostly the time
+#  spent in the allocator and on page faults.
+#
+
+set -e
+
+BENCHMARK_NAME=buffer_pool
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+echo "# file size num mode kernel time (result)"
+for data in $OB_DATA_FILES; do
+    filename=`basename $data`
+    filesize=`stat --format="%s" --dereference $data`
+    for mode in new pool; do
+        for n in $OB_SEQ; do
+            $CMD $data $mode | sed -e "s%^%$filename $filesize $n $mode %"
+        done
+    done
+done
+
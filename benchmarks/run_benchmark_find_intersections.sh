@@ -0,0 +1,27 @@
+#!/bin/sh
+#
+#  run_benchmark_find_intersections.sh
+#
+#  Will read the input file twice to assemble the segments of all
+#  multipolygon and boundary relations, and time the search for
+#  intersections between the segments on the biggest of them. The times
+#  are reported by the benchmark program itself.
+#
+
+set -e
+
+BENCHMARK_NAME=find_intersections
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+echo "# file size num relation segments intersections time"
+for data in $OB_DATA_FILES; do
+    filename=`basename $data`
+    filesize=`stat --format="%s" --dereference $data`
+    for n in $OB_SEQ; do
+        $CMD $data | sed -e "s%^%$filename $filesize $n %"
+    done
+done
+
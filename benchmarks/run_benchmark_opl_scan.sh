@@ -0,0 +1,31 @@
+#!/bin/sh
+#
+#  run_benchmark_opl_scan.sh
+#
+#  Will read the input file and convert it into OPL format in memory. Then
+#  it will time scanning the OPL text for line ends and separators and
+#  parsing the coordinates, once with the scalar code and the general
+#  coordinate parser and once with the vectorized code and the fast
+#  coordinate parser. The timings are reported by the benchmark program
+#  itself.
+#
+
+set -e
+
+BENCHMARK_NAME=opl_scan
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+echo "# file size num mode kernel time (result)"
+for data in $OB_DATA_FILES; do
+    filename=`basename $data`
+    filesize=`stat --format="%s" --dereference $data`
+    for mode in scalar simd; do
+        for n in $OB_SEQ; do
+            $CMD $data $mode | sed -e "s%^%$filename $filesize $n $mode %"
+        done
+    done
+done
+
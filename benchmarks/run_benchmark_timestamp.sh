@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+#  run_benchmark_timestamp.sh
+#
+#  Will read the input file and collect the timestamps of all objects in
+#  memory. Then it will time formatting them as ISO strings and parsing those
+#  strings again, once with the libc functions (gmtime_r/strftime and timegm)
+#  and once with the Osmium code. The timings are reported by the benchmark
+#  program itself.
+#
+
+set -e
+
+BENCHMARK_NAME=timestamp
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+echo "# file size num mode kernel time (result)"
+for data in $OB_DATA_FILES; do
+    filename=`basename $data`
+    filesize=`stat --format="%s" --dereference $data`
+    for mode in libc osmium; do
+        for n in $OB_SEQ; do
+            $CMD $data $mode | sed -e "s%^%$filename $filesize $n $mode %"
+        done
+    done
+done
+
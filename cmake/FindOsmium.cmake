@@ -28,6 +28,7 @@
 #    following components:
 #
 #      pbf        - include libraries needed for PBF input and output
+#                   (lz4 and zstd are used if they are found)
 #      xml        - include libraries needed for XML input and output
 #      io         - include libraries needed for any type of input/output
 #      geos       - include if you want to use any of the GEOS functions
@@ -138,6 +139,25 @@ if(Osmium_USE_PBF)
     else()
         message(WARNING "Osmium: Can not find some libraries for PBF input/output, please install them or configure the paths.")
     endif()
+
+    # Optional support for lz4 and zstd compressed PBF blobs
+    find_path(LZ4_INCLUDE_DIR lz4hc.h)
+    find_library(LZ4_LIBRARY NAMES lz4)
+    if(LZ4_INCLUDE_DIR AND LZ4_LIBRARY)
+        set(LZ4_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_LZ4)
+        list(APPEND OSMIUM_PBF_LIBRARIES ${LZ4_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${LZ4_INCLUDE_DIR})
+    endif()
+
+    find_path(ZSTD_INCLUDE_DIR zstd.h)
+    find_library(ZSTD_LIBRARY NAMES zstd)
+    if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+        set(ZSTD_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_ZSTD)
+        list(APPEND OSMIUM_PBF_LIBRARIES ${ZSTD_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+    endif()
 endif()
 
 #----------------------------------------------------------------------
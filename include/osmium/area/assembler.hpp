@@ -33,13 +33,18 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
 #include <osmium/area/assembler_config.hpp>
 #include <osmium/area/detail/basic_assembler_with_tags.hpp>
+#include <osmium/area/detail/node_ref_segment.hpp>
 #include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/detail/vector.hpp>
 #include <osmium/area/problem_reporter.hpp>
 #include <osmium/area/stats.hpp>
 #include <osmium/builder/osm_object_builder.hpp>
@@ -60,6 +65,113 @@ namespace osmium {
          */
         class Assembler : public detail::BasicAssemblerWithTags {
 
+            enum constant_simple_ring : std::size_t {
+                // Closed ways with up to this many nodes are checked for
+                // being simple rings which don't need the full assembly.
+                max_nodes_simple_ring = 32
+            };
+
+            /**
+             * Check whether the nodes form a simple ring: The first and last
+             * node are the same, all other locations are valid and
+             * different, and no segments intersect, overlap, or touch
+             * (except neighbouring segments in their common node). This
+             * compares all pairs of segments, so it is only used for small
+             * rings.
+             *
+             * @returns Twice the signed area of the ring (positive if the
+             *          nodes are in counter-clockwise order) or 0 if this is
+             *          not a simple ring or the area is zero.
+             */
+            static int64_t simple_ring_sum(const osmium::WayNodeList& nodes) noexcept {
+                if (nodes.size() < 4 || nodes.size() > max_nodes_simple_ring ||
+                    nodes.front().ref() != nodes.back().ref() ||
+                    nodes.front().location() != nodes.back().location()) {
+                    return 0;
+                }
+
+                const std::size_t num_segments = nodes.size() - 1;
+                std::array<detail::NodeRefSegment, max_nodes_simple_ring - 1> segments;
+                int64_t sum = 0;
+
+                for (std::size_t i = 0; i < num_segments; ++i) {
+                    if (!nodes[i].location().valid()) {
+                        return 0;
+                    }
+                    for (std::size_t j = 0; j < i; ++j) {
+                        if (nodes[j].location() == nodes[i].location()) {
+                            return 0;
+                        }
+                    }
+                    segments[i] = detail::NodeRefSegment{nodes[i], nodes[i + 1], detail::role_type::unknown, nullptr};
+                    sum += detail::vec{nodes[i]} * detail::vec{nodes[i + 1]};
+                }
+
+                for (std::size_t i = 0; i < num_segments; ++i) {
+                    const auto& s1 = segments[i];
+                    for (std::size_t j = i + 1; j < num_segments; ++j) {
+                        const auto& s2 = segments[j];
+                        if (!detail::outside_x_range(s1, s2) &&
+                            !detail::outside_x_range(s2, s1) &&
+                            detail::y_range_overlap(s1, s2) &&
+                            detail::calculate_intersection(s1, s2)) {
+                            return 0;
+                        }
+                    }
+                }
+
+                return sum;
+            }
+
+            /**
+             * Create an area from a way which is a simple ring (see
+             * simple_ring_sum()) without going through create_rings(). The
+             * result and the statistics are the same: The outer ring is
+             * written counter-clockwise starting at the smallest location.
+             */
+            bool create_simple_area(osmium::memory::Buffer& out_buffer, const osmium::Way& way, int64_t sum) {
+                const auto& nodes = way.nodes();
+                const std::size_t num_segments = nodes.size() - 1;
+
+                if (config().debug_level > 0) {
+                    std::cerr << "\nAssembling way " << way.id() << " containing " << num_segments << " nodes as simple ring\n";
+                }
+
+                stats().invalid_locations = 0;
+                stats().nodes += num_segments;
+                stats().intersections = 0;
+                ++stats().area_simple_case;
+                stats().outer_rings = 1;
+                stats().inner_rings = 0;
+
+                std::size_t start = 0;
+                for (std::size_t i = 1; i < num_segments; ++i) {
+                    if (nodes[i].location() < nodes[start].location()) {
+                        start = i;
+                    }
+                }
+
+                {
+                    osmium::builder::AreaBuilder builder{out_buffer};
+                    builder.initialize_from_object(way);
+                    builder.add_item(way.tags());
+
+                    osmium::builder::OuterRingBuilder ring_builder{builder};
+                    for (std::size_t n = 0; n <= num_segments; ++n) {
+                        const std::size_t i = sum > 0 ? start + n : start + num_segments - n;
+                        ring_builder.add_node_ref(nodes[i % num_segments]);
+                    }
+                }
+
+                if (report_ways()) {
+                    config().problem_reporter->report_way(way);
+                }
+
+                out_buffer.commit();
+
+                return true;
+            }
+
             bool create_area(osmium::memory::Buffer& out_buffer, const osmium::Way& way) {
                 osmium::builder::AreaBuilder builder{out_buffer};
                 builder.initialize_from_object(way);
@@ -144,6 +256,15 @@ namespace osmium {
                 }
 
                 ++stats().from_ways;
+
+                // Most closed ways are small simple rings, those are
+                // written directly.
+                const int64_t sum = simple_ring_sum(way.nodes());
+                if (sum != 0) {
+                    return create_simple_area(out_buffer, way, sum);
+                }
+
+                reset();
                 stats().invalid_locations = segment_list().extract_segments_from_way(config().problem_reporter,
                                                                                      stats().duplicate_nodes,
                                                                                      way);
@@ -195,6 +316,7 @@ namespace osmium {
                 }
 
                 ++stats().from_relations;
+                reset();
                 stats().invalid_locations = segment_list().extract_segments_from_ways(config().problem_reporter,
                                                                                       stats().duplicate_nodes,
                                                                                       stats().duplicate_ways,
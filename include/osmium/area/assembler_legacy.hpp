@@ -140,9 +140,9 @@ namespace osmium {
                         std::cerr << "    use tags from outer ways\n";
                     }
                     std::set<const osmium::Way*> ways;
-                    for (const auto& ring : rings()) {
-                        if (ring.is_outer()) {
-                            ring.get_ways(ways);
+                    for (const detail::ProtoRing* ring : rings()) {
+                        if (ring->is_outer()) {
+                            ring->get_ways(ways);
                         }
                     }
                     if (ways.size() == 1) {
@@ -244,6 +244,7 @@ namespace osmium {
                 }
 
                 ++stats().from_ways;
+                reset();
                 stats().invalid_locations = segment_list().extract_segments_from_way(config().problem_reporter,
                                                                                      stats().duplicate_nodes,
                                                                                      way);
@@ -291,6 +292,7 @@ namespace osmium {
                 }
 
                 ++stats().from_relations;
+                reset();
                 stats().invalid_locations = segment_list().extract_segments_from_ways(config().problem_reporter,
                                                                                       stats().duplicate_nodes,
                                                                                       stats().duplicate_ways,
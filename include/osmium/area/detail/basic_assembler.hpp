@@ -37,9 +37,9 @@ DEALINGS IN THE SOFTWARE.
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
+#include <deque>
 #include <iostream>
 #include <iterator>
-#include <list>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -66,27 +66,27 @@ namespace osmium {
 
         namespace detail {
 
-            using open_ring_its_type = std::list<std::list<ProtoRing>::iterator>;
+            using open_rings_type = std::vector<ProtoRing*>;
 
             struct location_to_ring_map {
                 osmium::Location location;
-                open_ring_its_type::iterator ring_it;
+                ProtoRing* ring_ptr;
                 bool start;
 
-                location_to_ring_map(osmium::Location l, open_ring_its_type::iterator r, const bool s) noexcept :
+                location_to_ring_map(osmium::Location l, ProtoRing* r, const bool s) noexcept :
                     location(l),
-                    ring_it(r),
+                    ring_ptr(r),
                     start(s) {
                 }
 
                 explicit location_to_ring_map(osmium::Location l) noexcept :
                     location(l),
-                    ring_it(),
+                    ring_ptr(nullptr),
                     start(false) {
                 }
 
                 const ProtoRing& ring() const noexcept {
-                    return **ring_it;
+                    return *ring_ptr;
                 }
 
             }; // struct location_to_ring_map
@@ -148,8 +148,17 @@ namespace osmium {
                 // List of segments (connection between two nodes)
                 SegmentList m_segment_list;
 
+                // Storage for all rings. The ring objects are reused (with
+                // the capacity of their vectors) when the assembler is used
+                // for the next area, they are never destroyed before the
+                // assembler is.
+                std::deque<ProtoRing> m_ring_storage;
+
+                // The number of ring objects in m_ring_storage in use
+                std::size_t m_ring_storage_used = 0;
+
                 // The rings we are building from the segments
-                std::list<ProtoRing> m_rings;
+                std::vector<ProtoRing*> m_rings;
 
                 // All node locations
                 std::vector<slocation> m_locations;
@@ -180,7 +189,8 @@ namespace osmium {
                     std::unordered_map<const osmium::Way*, const ProtoRing*> way_rings;
                     std::unordered_set<const osmium::Way*> ways_in_multiple_rings;
 
-                    for (const ProtoRing& ring : m_rings) {
+                    for (const ProtoRing* ring_ptr : m_rings) {
+                        const ProtoRing& ring = *ring_ptr;
                         for (const auto& segment : ring.segments()) {
                             assert(segment->way());
 
@@ -395,6 +405,21 @@ namespace osmium {
                     return outer_rings.front().ring_ptr();
                 }
 
+                /**
+                 * Get a ring object from the ring storage, initialize it with
+                 * the given segment and add it to the list of rings.
+                 */
+                ProtoRing* new_ring(NodeRefSegment* segment) {
+                    if (m_ring_storage_used < m_ring_storage.size()) {
+                        m_ring_storage[m_ring_storage_used].restart(segment);
+                    } else {
+                        m_ring_storage.emplace_back(segment);
+                    }
+                    ProtoRing* ring = &m_ring_storage[m_ring_storage_used++];
+                    m_rings.push_back(ring);
+                    return ring;
+                }
+
                 bool is_split_location(const osmium::Location& location) const noexcept {
                     return std::find(m_split_locations.cbegin(), m_split_locations.cend(), location) != m_split_locations.cend();
                 }
@@ -418,8 +443,7 @@ namespace osmium {
                     }
                     segment->mark_direction_done();
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = new_ring(segment);
                     if (outer_ring) {
                         if (debug()) {
                             std::cerr << "    This is an inner ring. Outer ring is " << *outer_ring << "\n";
@@ -469,8 +493,7 @@ namespace osmium {
                         segment->reverse();
                     }
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = new_ring(segment);
 
                     const osmium::Location& first_location = node.location(m_segment_list);
                     osmium::Location last_location = segment->stop().location();
@@ -529,9 +552,9 @@ namespace osmium {
                     }
                     std::vector<ProtoRing*> rings;
                     rings.reserve(m_rings.size());
-                    for (auto& ring : m_rings) {
-                        if (ring.closed()) {
-                            rings.push_back(&ring);
+                    for (ProtoRing* ring : m_rings) {
+                        if (ring->closed()) {
+                            rings.push_back(ring);
                         }
                     }
 
@@ -605,16 +628,16 @@ namespace osmium {
                     }
                 }
 
-                std::vector<location_to_ring_map> create_location_to_ring_map(open_ring_its_type& open_ring_its) {
+                std::vector<location_to_ring_map> create_location_to_ring_map(open_rings_type& open_rings) {
                     std::vector<location_to_ring_map> xrings;
-                    xrings.reserve(open_ring_its.size() * 2);
+                    xrings.reserve(open_rings.size() * 2);
 
-                    for (auto it = open_ring_its.begin(); it != open_ring_its.end(); ++it) {
+                    for (ProtoRing* ring : open_rings) {
                         if (debug()) {
-                            std::cerr << "      " << **it << '\n';
+                            std::cerr << "      " << *ring << '\n';
                         }
-                        xrings.emplace_back((*it)->get_node_ref_start().location(), it, true);
-                        xrings.emplace_back((*it)->get_node_ref_stop().location(), it, false);
+                        xrings.emplace_back(ring->get_node_ref_start().location(), ring, true);
+                        xrings.emplace_back(ring->get_node_ref_stop().location(), ring, false);
                     }
 
                     std::sort(xrings.begin(), xrings.end());
@@ -622,9 +645,9 @@ namespace osmium {
                     return xrings;
                 }
 
-                void merge_two_rings(open_ring_its_type& open_ring_its, const location_to_ring_map& m1, const location_to_ring_map& m2) {
-                    const auto r1 = *m1.ring_it;
-                    const auto r2 = *m2.ring_it;
+                void merge_two_rings(open_rings_type& open_rings, const location_to_ring_map& m1, const location_to_ring_map& m2) {
+                    ProtoRing* r1 = m1.ring_ptr;
+                    ProtoRing* r2 = m2.ring_ptr;
 
                     if (r1->get_node_ref_stop().location() == r2->get_node_ref_start().location()) {
                         r1->join_forward(*r2);
@@ -640,24 +663,26 @@ namespace osmium {
                         assert(false);
                     }
 
-                    open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r2));
-                    m_rings.erase(r2);
+                    // The ring object of r2 stays in m_ring_storage until the
+                    // assembler is reset, it is only removed from the lists.
+                    open_rings.erase(std::find(open_rings.begin(), open_rings.end(), r2));
+                    m_rings.erase(std::find(m_rings.begin(), m_rings.end(), r2));
 
                     if (r1->closed()) {
-                        open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r1));
+                        open_rings.erase(std::find(open_rings.begin(), open_rings.end(), r1));
                     }
                 }
 
-                bool try_to_merge(open_ring_its_type& open_ring_its) {
-                    if (open_ring_its.empty()) {
+                bool try_to_merge(open_rings_type& open_rings) {
+                    if (open_rings.empty()) {
                         return false;
                     }
 
                     if (debug()) {
-                        std::cerr << "    Trying to merge " << open_ring_its.size() << " open rings (try_to_merge)\n";
+                        std::cerr << "    Trying to merge " << open_rings.size() << " open rings (try_to_merge)\n";
                     }
 
-                    std::vector<location_to_ring_map> xrings = create_location_to_ring_map(open_ring_its);
+                    std::vector<location_to_ring_map> xrings = create_location_to_ring_map(open_rings);
 
                     auto it = xrings.cbegin();
                     while (it != xrings.cend()) {
@@ -670,7 +695,7 @@ namespace osmium {
                             if (debug()) {
                                 std::cerr << "      Merging two rings\n";
                             }
-                            merge_two_rings(open_ring_its, *it, *std::next(it));
+                            merge_two_rings(open_rings, *it, *std::next(it));
                             return true;
                         }
                         while (it != xrings.cend() && it->location == after->location) {
@@ -682,8 +707,8 @@ namespace osmium {
                 }
 
                 bool there_are_open_rings() const noexcept {
-                    return std::any_of(m_rings.cbegin(), m_rings.cend(), [](const ProtoRing& ring){
-                        return !ring.closed();
+                    return std::any_of(m_rings.cbegin(), m_rings.cend(), [](const ProtoRing* ring){
+                        return !ring->closed();
                     });
                 }
 
@@ -771,14 +796,14 @@ namespace osmium {
                  * can't close this ring, an error is reported and the function
                  * returns false.
                  */
-                bool join_connected_rings(open_ring_its_type& open_ring_its) {
-                    assert(!open_ring_its.empty());
+                bool join_connected_rings(open_rings_type& open_rings) {
+                    assert(!open_rings.empty());
 
                     if (debug()) {
-                        std::cerr << "    Trying to merge " << open_ring_its.size() << " open rings (join_connected_rings)\n";
+                        std::cerr << "    Trying to merge " << open_rings.size() << " open rings (join_connected_rings)\n";
                     }
 
-                    std::vector<location_to_ring_map> xrings = create_location_to_ring_map(open_ring_its);
+                    std::vector<location_to_ring_map> xrings = create_location_to_ring_map(open_rings);
 
                     const auto ring_min = std::min_element(xrings.begin(), xrings.end(), [](const location_to_ring_map& lhs, const location_to_ring_map& rhs) {
                         return lhs.ring().min_segment() < rhs.ring().min_segment();
@@ -790,8 +815,8 @@ namespace osmium {
                     if (debug()) {
                         std::cerr << "  Open ring is " << (ring_min_is_outer ? "outer" : "inner") << " ring\n";
                     }
-                    for (auto& ring : m_rings) {
-                        ring.reset();
+                    for (ProtoRing* ring : m_rings) {
+                        ring->reset();
                     }
 
                     candidate cand{*ring_min, false};
@@ -809,10 +834,10 @@ namespace osmium {
                         if (debug()) {
                             std::cerr << "    Found no candidates\n";
                         }
-                        if (!open_ring_its.empty()) {
+                        if (!open_rings.empty()) {
                             ++m_stats.open_rings;
                             if (m_config.problem_reporter) {
-                                for (auto& it : open_ring_its) {
+                                for (auto& it : open_rings) {
                                     m_config.problem_reporter->report_ring_not_closed(it->get_node_ref_start(), nullptr);
                                     m_config.problem_reporter->report_ring_not_closed(it->get_node_ref_stop(), nullptr);
                                 }
@@ -852,7 +877,7 @@ namespace osmium {
                     const auto& first_ring = chosen_cand->rings.front().first;
                     const ProtoRing& remaining_ring = first_ring.ring();
                     for (auto it = std::next(chosen_cand->rings.begin()); it != chosen_cand->rings.end(); ++it) {
-                        merge_two_rings(open_ring_its, first_ring, it->first);
+                        merge_two_rings(open_rings, first_ring, it->first);
                     }
 
                     if (debug()) {
@@ -902,26 +927,26 @@ namespace osmium {
                     if (there_are_open_rings()) {
                         ++m_stats.area_really_complex_case;
 
-                        open_ring_its_type open_ring_its;
-                        for (auto it = m_rings.begin(); it != m_rings.end(); ++it) {
-                            if (!it->closed()) {
-                                open_ring_its.push_back(it);
+                        open_rings_type open_rings;
+                        for (ProtoRing* ring : m_rings) {
+                            if (!ring->closed()) {
+                                open_rings.push_back(ring);
                             }
                         }
 
-                        while (!open_ring_its.empty()) {
+                        while (!open_rings.empty()) {
                             if (debug()) {
-                                std::cerr << "  There are " << open_ring_its.size() << " open rings\n";
+                                std::cerr << "  There are " << open_rings.size() << " open rings\n";
                             }
-                            while (try_to_merge(open_ring_its)) {
+                            while (try_to_merge(open_rings)) {
                                 // intentionally left blank
                             }
 
-                            if (!open_ring_its.empty()) {
+                            if (!open_rings.empty()) {
                                 if (debug()) {
-                                    std::cerr << "  After joining obvious cases there are still " << open_ring_its.size() << " open rings\n";
+                                    std::cerr << "  After joining obvious cases there are still " << open_rings.size() << " open rings\n";
                                 }
-                                if (!join_connected_rings(open_ring_its)) {
+                                if (!join_connected_rings(open_rings)) {
                                     return false;
                                 }
                             }
@@ -967,7 +992,7 @@ namespace osmium {
 
             protected:
 
-                const std::list<ProtoRing>& rings() const noexcept {
+                const std::vector<ProtoRing*>& rings() const noexcept {
                     return m_rings;
                 }
 
@@ -979,15 +1004,30 @@ namespace osmium {
                     return m_segment_list;
                 }
 
+                /**
+                 * Forget the segments, rings, and locations of the last
+                 * area assembled. The memory allocated for them is kept
+                 * and reused for the next area. The statistics are not
+                 * reset.
+                 */
+                void reset() noexcept {
+                    m_segment_list.clear();
+                    m_rings.clear();
+                    m_ring_storage_used = 0;
+                    m_locations.clear();
+                    m_split_locations.clear();
+                    m_num_members = 0;
+                }
+
                 /**
                  * Append each outer ring together with its inner rings to the
                  * area in the buffer.
                  */
                 void add_rings_to_area(osmium::builder::AreaBuilder& builder) const {
-                    for (const ProtoRing& ring : m_rings) {
-                        if (ring.is_outer()) {
-                            build_ring_from_proto_ring<osmium::builder::OuterRingBuilder>(builder, ring);
-                            for (const ProtoRing* inner : ring.inner_rings()) {
+                    for (const ProtoRing* ring : m_rings) {
+                        if (ring->is_outer()) {
+                            build_ring_from_proto_ring<osmium::builder::OuterRingBuilder>(builder, *ring);
+                            for (const ProtoRing* inner : ring->inner_rings()) {
                                 build_ring_from_proto_ring<osmium::builder::InnerRingBuilder>(builder, *inner);
                             }
                         }
@@ -1125,8 +1165,8 @@ namespace osmium {
                         timer_roles.stop();
                     }
 
-                    m_stats.outer_rings = std::count_if(m_rings.cbegin(), m_rings.cend(), [](const ProtoRing& ring){
-                        return ring.is_outer();
+                    m_stats.outer_rings = std::count_if(m_rings.cbegin(), m_rings.cend(), [](const ProtoRing* ring){
+                        return ring->is_outer();
                     });
                     m_stats.inner_rings = m_rings.size() - m_stats.outer_rings;
 
@@ -1192,6 +1232,18 @@ namespace osmium {
                     return m_stats;
                 }
 
+                /**
+                 * Reset the assembler so it can be used for the next area
+                 * as if it was newly constructed. This also resets the
+                 * statistics. The memory allocated for segments, rings, and
+                 * locations is kept, so reusing an assembler is much cheaper
+                 * than constructing a new one for each area.
+                 */
+                void clear() noexcept {
+                    reset();
+                    m_stats = area_stats{};
+                }
+
             }; // class BasicAssembler
 
         } // namespace detail
@@ -35,12 +35,15 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <iterator>
 #include <numeric>
+#include <tuple>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <osmium/area/detail/node_ref_segment.hpp>
@@ -88,6 +91,24 @@ namespace osmium {
 
                 bool m_debug;
 
+                enum constant_sweep : std::size_t {
+                    // Below this number of segments a simple nested loop
+                    // is faster than the sweep line algorithm.
+                    min_segments_for_sweep = 512,
+
+                    // Average number of segments per y bucket of the
+                    // sweep line algorithm.
+                    segments_per_bucket = 8,
+
+                    max_buckets = 64 * 1024
+                };
+
+                struct intersection_type {
+                    std::size_t first;
+                    std::size_t second;
+                    osmium::Location location;
+                };
+
                 static role_type parse_role(const char* role) noexcept {
                     if (role[0] == '\0') {
                         return role_type::empty;
@@ -141,6 +162,126 @@ namespace osmium {
                     return invalid_locations;
                 }
 
+                void report_intersection(ProblemReporter* problem_reporter, const NodeRefSegment& s1, const NodeRefSegment& s2, const osmium::Location intersection) const {
+                    if (m_debug) {
+                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
+                    }
+                    if (problem_reporter) {
+                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
+                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
+                    }
+                }
+
+                /**
+                 * Compare each segment with all following segments until
+                 * they are outside its x range. This is quadratic in the
+                 * worst case, but fast for small numbers of segments.
+                 */
+                uint32_t find_intersections_nested_loop(ProblemReporter* problem_reporter) const {
+                    uint32_t found_intersections = 0;
+
+                    for (auto it1 = m_segments.cbegin(); it1 != m_segments.cend() - 1; ++it1) {
+                        const NodeRefSegment& s1 = *it1;
+                        for (auto it2 = it1+1; it2 != m_segments.end(); ++it2) {
+                            const NodeRefSegment& s2 = *it2;
+
+                            assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
+
+                            if (outside_x_range(s2, s1)) {
+                                break;
+                            }
+
+                            if (y_range_overlap(s1, s2)) {
+                                osmium::Location intersection{calculate_intersection(s1, s2)};
+                                if (intersection) {
+                                    ++found_intersections;
+                                    report_intersection(problem_reporter, s1, s2, intersection);
+                                }
+                            }
+                        }
+                    }
+
+                    return found_intersections;
+                }
+
+                /**
+                 * Sweep a vertical line over the (sorted) segments from
+                 * left to right. The segments the line currently crosses
+                 * are kept in buckets by their y range, so each new segment
+                 * is only compared with the segments in the buckets its y
+                 * range covers. Segments left behind by the sweep line are
+                 * removed from a bucket when it is visited.
+                 *
+                 * This checks exactly the same pairs of segments as
+                 * find_intersections_nested_loop() and reports the
+                 * intersections in the same order.
+                 */
+                uint32_t find_intersections_sweep(ProblemReporter* problem_reporter) const {
+                    int32_t min_y = m_segments.front().first().location().y();
+                    int32_t max_y = min_y;
+                    for (const auto& segment : m_segments) {
+                        const std::pair<int32_t, int32_t> y = std::minmax(segment.first().location().y(), segment.second().location().y());
+                        min_y = std::min(min_y, y.first);
+                        max_y = std::max(max_y, y.second);
+                    }
+
+                    const std::size_t num_buckets = std::min(std::max(m_segments.size() / segments_per_bucket, std::size_t{1}), std::size_t{max_buckets});
+                    const int64_t bucket_height = (int64_t(max_y) - int64_t(min_y)) / int64_t(num_buckets) + 1;
+                    const auto bucket = [min_y, bucket_height](int32_t y) noexcept {
+                        return static_cast<std::size_t>((int64_t(y) - int64_t(min_y)) / bucket_height);
+                    };
+
+                    std::vector<std::vector<std::size_t>> buckets(num_buckets);
+                    std::vector<intersection_type> intersections;
+
+                    for (std::size_t j = 0; j < m_segments.size(); ++j) {
+                        const NodeRefSegment& s2 = m_segments[j];
+                        const std::pair<int32_t, int32_t> y2 = std::minmax(s2.first().location().y(), s2.second().location().y());
+                        const std::size_t last_bucket = bucket(y2.second);
+
+                        for (std::size_t b = bucket(y2.first); b <= last_bucket; ++b) {
+                            auto& active = buckets[b];
+                            for (std::size_t n = 0; n < active.size();) {
+                                const std::size_t i = active[n];
+                                const NodeRefSegment& s1 = m_segments[i];
+
+                                // The sweep line has moved past this
+                                // segment, it can't intersect with any
+                                // segment from here on.
+                                if (outside_x_range(s2, s1)) {
+                                    active[n] = active.back();
+                                    active.pop_back();
+                                    continue;
+                                }
+                                ++n;
+
+                                assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
+
+                                // Segments overlapping in several buckets
+                                // are only checked in the first of them.
+                                const int32_t y1_min = std::min(s1.first().location().y(), s1.second().location().y());
+                                if (y_range_overlap(s1, s2) && bucket(std::max(y1_min, y2.first)) == b) {
+                                    osmium::Location intersection{calculate_intersection(s1, s2)};
+                                    if (intersection) {
+                                        intersections.push_back(intersection_type{i, j, intersection});
+                                    }
+                                }
+                            }
+                            active.push_back(j);
+                        }
+                    }
+
+                    std::sort(intersections.begin(), intersections.end(), [](const intersection_type& a, const intersection_type& b) noexcept {
+                        return std::tie(a.first, a.second) < std::tie(b.first, b.second);
+                    });
+
+                    for (const auto& intersection : intersections) {
+                        report_intersection(problem_reporter, m_segments[intersection.first], m_segments[intersection.second], intersection.location);
+                    }
+
+                    return static_cast<uint32_t>(intersections.size());
+                }
+
             public:
 
                 explicit SegmentList(bool debug) noexcept :
@@ -166,6 +307,11 @@ namespace osmium {
                     return m_segments.empty();
                 }
 
+                /// Remove all segments from the list, but keep the memory.
+                void clear() noexcept {
+                    m_segments.clear();
+                }
+
                 using const_iterator = slist_type::const_iterator;
                 using iterator = slist_type::iterator;
 
@@ -320,36 +466,11 @@ namespace osmium {
                         return 0;
                     }
 
-                    uint32_t found_intersections = 0;
-
-                    for (auto it1 = m_segments.cbegin(); it1 != m_segments.cend() - 1; ++it1) {
-                        const NodeRefSegment& s1 = *it1;
-                        for (auto it2 = it1+1; it2 != m_segments.end(); ++it2) {
-                            const NodeRefSegment& s2 = *it2;
-
-                            assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
-
-                            if (outside_x_range(s2, s1)) {
-                                break;
-                            }
-
-                            if (y_range_overlap(s1, s2)) {
-                                osmium::Location intersection{calculate_intersection(s1, s2)};
-                                if (intersection) {
-                                    ++found_intersections;
-                                    if (m_debug) {
-                                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
-                                    }
-                                    if (problem_reporter) {
-                                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
-                                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
-                                    }
-                                }
-                            }
-                        }
+                    if (m_segments.size() < min_segments_for_sweep) {
+                        return find_intersections_nested_loop(problem_reporter);
                     }
 
-                    return found_intersections;
+                    return find_intersections_sweep(problem_reporter);
                 }
 
             }; // class SegmentList
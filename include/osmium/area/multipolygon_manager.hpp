@@ -35,13 +35,19 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <future>
+#include <utility>
 #include <vector>
 
 #include <osmium/area/stats.hpp>
+#include <osmium/memory/buffer.hpp>
 #include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/way.hpp>
@@ -52,6 +58,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/storage/item_stash.hpp>
 #include <osmium/tags/taglist.hpp>
 #include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
 
 namespace osmium {
 
@@ -60,6 +67,90 @@ namespace osmium {
      */
     namespace area {
 
+        namespace detail {
+
+            /**
+             * The areas assembled from one job and the statistics of the
+             * assemblers.
+             */
+            struct assembler_job_result {
+                osmium::memory::Buffer buffer;
+                area_stats stats;
+            };
+
+            /**
+             * Task for the thread pool assembling areas from copies of the
+             * closed ways and complete relations. The input buffer contains
+             * closed ways and relations, each relation is followed by its
+             * member ways (one for each member with a non-zero ref).
+             */
+            template <typename TAssembler>
+            class AssemblerJob {
+
+                using assembler_config_type = typename TAssembler::config_type;
+
+                osmium::memory::Buffer m_input;
+                assembler_config_type m_config;
+
+            public:
+
+                AssemblerJob(osmium::memory::Buffer&& input, const assembler_config_type& config) :
+                    m_input(std::move(input)),
+                    m_config(config) {
+                }
+
+                assembler_job_result operator()() {
+                    // Free the input as soon as possible, the task object
+                    // lives on until the result is picked up.
+                    const osmium::memory::Buffer input{std::move(m_input)};
+                    assembler_job_result result{osmium::memory::Buffer{input.committed(), osmium::memory::Buffer::auto_grow::yes}, area_stats{}};
+
+                    // One assembler is used for all areas in this job.
+                    TAssembler assembler{m_config};
+                    std::vector<const osmium::Way*> ways;
+                    auto it = input.cbegin<osmium::OSMObject>();
+                    const auto end = input.cend<osmium::OSMObject>();
+                    while (it != end) {
+                        if (it->type() == osmium::item_type::way) {
+                            const auto& way = static_cast<const osmium::Way&>(*it);
+                            ++it;
+                            try {
+                                assembler.clear();
+                                assembler(way, result.buffer);
+                                result.stats += assembler.stats();
+                            } catch (const osmium::invalid_location&) {
+                                // XXX ignore
+                            }
+                            continue;
+                        }
+
+                        assert(it->type() == osmium::item_type::relation);
+                        const auto& relation = static_cast<const osmium::Relation&>(*it);
+                        ++it;
+                        ways.clear();
+                        for (const auto& member : relation.members()) {
+                            if (member.ref() != 0) {
+                                assert(it != end && it->type() == osmium::item_type::way);
+                                ways.push_back(&static_cast<const osmium::Way&>(*it));
+                                ++it;
+                            }
+                        }
+                        try {
+                            assembler.clear();
+                            assembler(relation, ways, result.buffer);
+                            result.stats += assembler.stats();
+                        } catch (const osmium::invalid_location&) {
+                            // XXX ignore
+                        }
+                    }
+
+                    return result;
+                }
+
+            }; // class AssemblerJob
+
+        } // namespace detail
+
         /**
          * This class collects all data needed for creating areas from
          * relations tagged with type=multipolygon or type=boundary.
@@ -69,7 +160,17 @@ namespace osmium {
          * The actual assembling of the areas is done by the assembler
          * class given as template argument.
          *
-         * @tparam TAssembler Multipolygon Assembler class.
+         * Call set_thread_pool() to assemble the areas in parallel on the
+         * threads of a thread pool. The closed ways and complete relations
+         * (with their member ways) are copied into jobs which are handed
+         * to the pool. The areas are added to the output in the same
+         * order as without the pool, so the output doesn't depend on the
+         * number of threads. Problem reporters are not thread-safe, so
+         * the thread pool is not used if a problem reporter is configured.
+         *
+         * @tparam TAssembler Multipolygon Assembler class. It must have a
+         *                    clear() function resetting it for the next
+         *                    area.
          * @pre The Ids of all objects must be unique in the input data.
          */
         template <typename TAssembler>
@@ -82,6 +183,70 @@ namespace osmium {
 
             osmium::TagsFilter m_filter;
 
+            // The assembler used for all areas assembled on the calling
+            // thread. Jobs in the thread pool each have their own.
+            TAssembler m_assembler;
+
+            // Reused for the member ways of each relation.
+            std::vector<const osmium::Way*> m_member_ways;
+
+            enum constant_job_size : std::size_t {
+                // Hand a job to the pool when its input is this large.
+                max_job_size = 256UL * 1024UL
+            };
+
+            // Thread pool used for assembling the areas or nullptr if they
+            // are assembled on the calling thread.
+            osmium::thread::Pool* m_pool = nullptr;
+
+            // Input for the next job.
+            osmium::memory::Buffer m_job_input;
+
+            // Results of the jobs handed to the pool in the order they
+            // were submitted.
+            std::deque<std::future<detail::assembler_job_result>> m_jobs;
+
+            std::size_t max_jobs_in_flight() const noexcept {
+                return static_cast<std::size_t>(m_pool->num_threads()) * 4;
+            }
+
+            void add_to_job(const osmium::OSMObject& object) {
+                if (!m_job_input) {
+                    m_job_input = osmium::memory::Buffer{max_job_size + max_job_size / 4, osmium::memory::Buffer::auto_grow::yes};
+                }
+                m_job_input.add_item(object);
+                m_job_input.commit();
+            }
+
+            void possibly_submit_job() {
+                if (m_job_input.committed() >= max_job_size) {
+                    submit_job();
+                }
+            }
+
+            void submit_job() {
+                if (m_job_input && m_job_input.committed() > 0) {
+                    m_jobs.push_back(m_pool->submit(detail::AssemblerJob<TAssembler>{std::move(m_job_input), m_assembler_config}));
+                    m_job_input = osmium::memory::Buffer{};
+                }
+                collect_results(m_jobs.size() > max_jobs_in_flight());
+            }
+
+            // Add the results of finished jobs to the output buffer. If wait
+            // is set, wait for (at least) the oldest job.
+            void collect_results(bool wait) {
+                while (!m_jobs.empty() &&
+                       (wait || m_jobs.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+                    auto result = m_jobs.front().get();
+                    m_jobs.pop_front();
+                    m_stats += result.stats;
+                    this->buffer().add_buffer(result.buffer);
+                    this->buffer().commit();
+                    this->possibly_flush();
+                    wait = false;
+                }
+            }
+
         public:
 
             /**
@@ -95,7 +260,27 @@ namespace osmium {
              */
             explicit MultipolygonManager(assembler_config_type assembler_config, osmium::TagsFilter filter = osmium::TagsFilter{true}) :
                 m_assembler_config(std::move(assembler_config)),
-                m_filter(std::move(filter)) {
+                m_filter(std::move(filter)),
+                m_assembler(m_assembler_config) {
+            }
+
+            /**
+             * Assemble the areas in parallel using the threads of the
+             * specified pool.
+             *
+             * The statistics and the output buffer will only contain
+             * all areas after flush_output() or read() was called.
+             *
+             * If a problem reporter is set in the assembler config, this
+             * does nothing and all areas are assembled on the calling
+             * thread, because problem reporters can not be called from
+             * several threads at the same time.
+             */
+            void set_thread_pool(osmium::thread::Pool& pool) noexcept {
+                if (m_assembler_config.problem_reporter) {
+                    return;
+                }
+                m_pool = &pool;
             }
 
             /**
@@ -133,19 +318,31 @@ namespace osmium {
              * assembler.
              */
             void complete_relation(const osmium::Relation& relation) {
-                std::vector<const osmium::Way*> ways;
-                ways.reserve(relation.members().size());
+                if (m_pool) {
+                    add_to_job(relation);
+                    for (const auto& member : relation.members()) {
+                        if (member.ref() != 0) {
+                            const osmium::Way* way = this->get_member_way(member.ref());
+                            assert(way != nullptr);
+                            add_to_job(*way);
+                        }
+                    }
+                    possibly_submit_job();
+                    return;
+                }
+
+                m_member_ways.clear();
                 for (const auto& member : relation.members()) {
                     if (member.ref() != 0) {
-                        ways.push_back(this->get_member_way(member.ref()));
-                        assert(ways.back() != nullptr);
+                        m_member_ways.push_back(this->get_member_way(member.ref()));
+                        assert(m_member_ways.back() != nullptr);
                     }
                 }
 
                 try {
-                    TAssembler assembler{m_assembler_config};
-                    assembler(relation, ways, this->buffer());
-                    m_stats += assembler.stats();
+                    m_assembler.clear();
+                    m_assembler(relation, m_member_ways, this->buffer());
+                    m_stats += m_assembler.stats();
                 } catch (const osmium::invalid_location&) {
                     // XXX ignore
                 }
@@ -170,9 +367,15 @@ namespace osmium {
                             return;
                         }
 
-                        TAssembler assembler{m_assembler_config};
-                        assembler(way, this->buffer());
-                        m_stats += assembler.stats();
+                        if (m_pool) {
+                            add_to_job(way);
+                            possibly_submit_job();
+                            return;
+                        }
+
+                        m_assembler.clear();
+                        m_assembler(way, this->buffer());
+                        m_stats += m_assembler.stats();
                         this->possibly_flush();
                     }
                 } catch (const osmium::invalid_location&) {
@@ -180,6 +383,21 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Wait for all areas assembled in the thread pool and add them
+             * to the output buffer. This is called automatically from
+             * flush_output() and read().
+             */
+            void before_flush_output() {
+                if (!m_pool) {
+                    return;
+                }
+                submit_job();
+                while (!m_jobs.empty()) {
+                    collect_results(true);
+                }
+            }
+
         }; // class MultipolygonManager
 
     } // namespace area
@@ -33,15 +33,20 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstddef>
 #include <limits>
 #include <type_traits>
+#include <vector>
 
 #include <osmium/handler.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map/dummy.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/object.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 
@@ -89,6 +94,54 @@ namespace osmium {
 
             bool m_must_sort = false;
 
+            /**
+             * Node refs of ways waiting for their locations. The
+             * locations are looked up in batches with Map::get_many().
+             */
+            class lookup_batch {
+
+                std::vector<osmium::unsigned_object_id_type> m_ids;
+                std::vector<osmium::NodeRef*> m_node_refs;
+                std::vector<osmium::Location> m_locations;
+
+            public:
+
+                bool empty() const noexcept {
+                    return m_ids.empty();
+                }
+
+                void add(osmium::unsigned_object_id_type id, osmium::NodeRef& node_ref) {
+                    m_ids.push_back(id);
+                    m_node_refs.push_back(&node_ref);
+                }
+
+                // Look up the locations of all node refs in the batch,
+                // set them, and clear the batch. Returns false if any
+                // location was not found.
+                template <typename TStorage>
+                bool resolve(const TStorage& storage) {
+                    m_locations.resize(m_ids.size());
+                    storage.get_many(m_ids.data(), m_locations.data(), m_ids.size());
+
+                    bool okay = true;
+                    for (std::size_t i = 0; i < m_ids.size(); ++i) {
+                        m_node_refs[i]->set_location(m_locations[i]);
+                        if (!m_locations[i]) {
+                            okay = false;
+                        }
+                    }
+
+                    m_ids.clear();
+                    m_node_refs.clear();
+
+                    return okay;
+                }
+
+            }; // class lookup_batch
+
+            lookup_batch m_batch_pos;
+            lookup_batch m_batch_neg;
+
             // It is okay to have this static dummy instance, even when using several threads,
             // because it is read-only.
             static dummy_type& get_dummy() {
@@ -144,29 +197,96 @@ namespace osmium {
                 }
             }
 
-            /**
-             * Retrieve locations of all nodes in the way from storage and add
-             * them to the way object.
-             */
-            void way(osmium::Way& way) {
+        private:
+
+            void sort_if_needed() {
                 if (m_must_sort) {
                     m_storage_pos.sort();
                     m_storage_neg.sort();
                     m_must_sort = false;
                     m_last_id = std::numeric_limits<osmium::unsigned_object_id_type>::max();
                 }
-                bool error = false;
+            }
+
+            void add_to_batch(osmium::Way& way) {
                 for (auto& node_ref : way.nodes()) {
-                    node_ref.set_location(get_node_location(node_ref.ref()));
-                    if (!node_ref.location()) {
-                        error = true;
+                    const auto id = node_ref.ref();
+                    if (id >= 0) {
+                        m_batch_pos.add(static_cast<osmium::unsigned_object_id_type>( id), node_ref);
+                    } else {
+                        m_batch_neg.add(static_cast<osmium::unsigned_object_id_type>(-id), node_ref);
                     }
                 }
-                if (!m_ignore_errors && error) {
+            }
+
+            // Returns false if any location was not found.
+            bool resolve_batch() {
+                bool okay = true;
+                if (!m_batch_pos.empty()) {
+                    okay = m_batch_pos.resolve(m_storage_pos);
+                }
+                if (!m_batch_neg.empty()) {
+                    okay = m_batch_neg.resolve(m_storage_neg) && okay;
+                }
+                return okay;
+            }
+
+            void check_errors(bool okay) const {
+                if (!m_ignore_errors && !okay) {
                     throw osmium::not_found{"location for one or more nodes not found in node location index"};
                 }
             }
 
+        public:
+
+            /**
+             * Retrieve locations of all nodes in the way from storage and add
+             * them to the way object.
+             */
+            void way(osmium::Way& way) {
+                sort_if_needed();
+                add_to_batch(way);
+                check_errors(resolve_batch());
+            }
+
+            /**
+             * Store the locations of all nodes in the buffer and add the
+             * node locations to all ways in the buffer. This has the same
+             * effect as calling node() and way() for all nodes and ways in
+             * the buffer in order, but the locations of the nodes of
+             * consecutive ways are looked up together using
+             * Map::get_many(). For large indexes this is much faster.
+             *
+             * Use this instead of putting this handler into the call of
+             * osmium::apply() when reading a file:
+             * @code
+             * while (osmium::memory::Buffer buffer = reader.read()) {
+             *     location_handler.process_buffer(buffer);
+             *     osmium::apply(buffer, other_handler);
+             * }
+             * @endcode
+             *
+             * @throws osmium::not_found if a location was not found and
+             *         ignore_errors() was not called. All ways in the
+             *         buffer will have been handled in this case.
+             */
+            void process_buffer(osmium::memory::Buffer& buffer) {
+                bool okay = true;
+                for (auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (object.type() == osmium::item_type::node) {
+                        // Handle the ways seen so far first to get the
+                        // same result as with calling way() and node().
+                        okay = resolve_batch() && okay;
+                        node(static_cast<const osmium::Node&>(object));
+                    } else if (object.type() == osmium::item_type::way) {
+                        sort_if_needed();
+                        add_to_batch(static_cast<osmium::Way&>(object));
+                    }
+                }
+                okay = resolve_batch() && okay;
+                check_errors(okay);
+            }
+
             /**
              * Call clear on the location indexes. Makes the
              * NodeLocationsForWays handler unusable. Used to explicitly free
@@ -41,12 +41,20 @@ DEALINGS IN THE SOFTWARE.
 #include <string>
 #include <vector>
 
+#include <osmium/index/detail/parse_mapping_options.hpp>
+
 namespace osmium {
 
     namespace index {
 
         namespace detail {
 
+            /**
+             * Create a map based on a file. The file name is in config[1],
+             * if it is missing a temporary file is used. Any further
+             * config entries are mapping options (see
+             * parse_mapping_options()).
+             */
             template <typename T>
             inline T* create_map_with_fd(const std::vector<std::string>& config) {
                 if (config.size() == 1) {
@@ -58,7 +66,7 @@ namespace osmium {
                 if (fd == -1) {
                     throw std::runtime_error{std::string{"can't open file '"} + filename + "': " + std::strerror(errno)};
                 }
-                return new T{fd};
+                return new T{fd, parse_mapping_options(config, 2)};
             }
 
         } // namespace detail
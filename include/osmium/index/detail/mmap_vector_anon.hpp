@@ -54,6 +54,10 @@ namespace osmium {
                 mmap_vector_base<T>() {
             }
 
+            explicit mmap_vector_anon(const osmium::util::mapping_options& options) :
+                mmap_vector_base<T>(osmium::detail::mmap_vector_size_increment, options) {
+            }
+
             ~mmap_vector_anon() noexcept = default;
 
         }; // class mmap_vector_anon
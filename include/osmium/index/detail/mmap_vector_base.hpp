@@ -63,17 +63,17 @@ namespace osmium {
 
         public:
 
-            mmap_vector_base(int fd, size_t capacity, size_t size = 0) :
+            mmap_vector_base(int fd, size_t capacity, size_t size = 0, const osmium::util::mapping_options& options = osmium::util::mapping_options{}) :
                 m_size(size),
-                m_mapping(capacity, osmium::util::MemoryMapping::mapping_mode::write_shared, fd) {
+                m_mapping(capacity, osmium::util::MemoryMapping::mapping_mode::write_shared, fd, 0, options) {
                 assert(size <= capacity);
                 std::fill(data() + size, data() + capacity, osmium::index::empty_value<T>());
                 shrink_to_fit();
             }
 
-            explicit mmap_vector_base(size_t capacity = mmap_vector_size_increment) :
+            explicit mmap_vector_base(size_t capacity = mmap_vector_size_increment, const osmium::util::mapping_options& options = osmium::util::mapping_options{}) :
                 m_size(0),
-                m_mapping(capacity) {
+                m_mapping(capacity, options) {
                 std::fill_n(data(), capacity, osmium::index::empty_value<T>());
             }
 
@@ -95,6 +95,10 @@ namespace osmium {
                 return m_mapping.size();
             }
 
+            const osmium::util::mapping_options& mapping_options() const noexcept {
+                return m_mapping.options();
+            }
+
             size_t size() const noexcept {
                 return m_size;
             }
@@ -78,6 +78,14 @@ namespace osmium {
                     filesize(fd)) {
             }
 
+            mmap_vector_file(int fd, const osmium::util::mapping_options& options) :
+                mmap_vector_base<T>(
+                    fd,
+                    std::max(osmium::detail::mmap_vector_size_increment, filesize(fd)),
+                    filesize(fd),
+                    options) {
+            }
+
             ~mmap_vector_file() noexcept = default;
 
         }; // class mmap_vector_file
@@ -0,0 +1,91 @@
+#ifndef OSMIUM_INDEX_DETAIL_PARSE_MAPPING_OPTIONS_HPP
+#define OSMIUM_INDEX_DETAIL_PARSE_MAPPING_OPTIONS_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <osmium/index/map.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Parse the options for memory mapped indexes from the map
+             * factory config, starting at config[first]. Known options are:
+             *
+             * hugepages  - ask for transparent huge pages
+             * hugetlb    - use pre-allocated huge pages (MAP_HUGETLB)
+             * populate   - pre-fault all pages
+             * sequential - memory will be accessed sequentially
+             * random     - memory will be accessed in random order
+             *
+             * @throws map_factory_error if there is an unknown option
+             */
+            inline osmium::util::mapping_options parse_mapping_options(const std::vector<std::string>& config, std::size_t first) {
+                using options_type = osmium::util::mapping_options;
+
+                options_type options;
+                for (std::size_t i = first; i < config.size(); ++i) {
+                    const std::string& option = config[i];
+                    if (option == "hugepages") {
+                        options.huge_pages = options_type::huge_pages_mode::transparent;
+                    } else if (option == "hugetlb") {
+                        options.huge_pages = options_type::huge_pages_mode::hugetlb;
+                    } else if (option == "populate") {
+                        options.populate = true;
+                    } else if (option == "sequential") {
+                        options.access = options_type::access_mode::sequential;
+                    } else if (option == "random") {
+                        options.access = options_type::access_mode::random;
+                    } else {
+                        throw osmium::map_factory_error{"Unknown option '" + option + "' for map type '" + config[0] + "'"};
+                    }
+                }
+
+                return options;
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_PARSE_MAPPING_OPTIONS_HPP
@@ -40,6 +40,8 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/compatibility.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 namespace osmium {
 
@@ -50,6 +52,11 @@ namespace osmium {
             template <typename TVector, typename TId, typename TValue>
             class VectorBasedDenseMap : public Map<TId, TValue> {
 
+                // How many ids ahead get_many() prefetches.
+                enum constant_prefetch_distance : std::size_t {
+                    prefetch_distance = 8
+                };
+
                 TVector m_vector;
 
             public:
@@ -67,6 +74,14 @@ namespace osmium {
                     m_vector(fd) {
                 }
 
+                explicit VectorBasedDenseMap(const osmium::util::mapping_options& options) :
+                    m_vector(options) {
+                }
+
+                VectorBasedDenseMap(int fd, const osmium::util::mapping_options& options) :
+                    m_vector(fd, options) {
+                }
+
                 ~VectorBasedDenseMap() noexcept final = default;
 
                 void reserve(const std::size_t size) final {
@@ -98,6 +113,24 @@ namespace osmium {
                     return m_vector[id];
                 }
 
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    // Each lookup is likely a cache miss (or a page fault
+                    // for mmaps), so we start loading the data for the
+                    // following ids while working on the current one.
+                    const std::size_t size = m_vector.size();
+                    for (std::size_t i = 0; i < count && i < prefetch_distance; ++i) {
+                        if (ids[i] < size) {
+                            OSMIUM_PREFETCH(&m_vector[ids[i]]);
+                        }
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i + prefetch_distance < count && ids[i + prefetch_distance] < size) {
+                            OSMIUM_PREFETCH(&m_vector[ids[i + prefetch_distance]]);
+                        }
+                        values[i] = ids[i] < size ? m_vector[ids[i]] : osmium::index::empty_value<TValue>();
+                    }
+                }
+
                 std::size_t size() const final {
                     return m_vector.size();
                 }
@@ -180,6 +213,14 @@ namespace osmium {
                     m_vector(fd) {
                 }
 
+                explicit VectorBasedSparseMap(const osmium::util::mapping_options& options) :
+                    m_vector(options) {
+                }
+
+                VectorBasedSparseMap(int fd, const osmium::util::mapping_options& options) :
+                    m_vector(fd, options) {
+                }
+
                 ~VectorBasedSparseMap() final = default;
 
                 void set(const TId id, const TValue value) final {
@@ -204,6 +245,12 @@ namespace osmium {
                     return result->second;
                 }
 
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        values[i] = get_noexcept(ids[i]);
+                    }
+                }
+
                 std::size_t size() const final {
                     return m_vector.size();
                 }
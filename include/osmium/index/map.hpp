@@ -145,6 +145,25 @@ namespace osmium {
                  */
                 virtual TValue get_noexcept(const TId id) const noexcept = 0;
 
+                /**
+                 * Retrieve values for many ids at once. This is the same as
+                 * calling get_noexcept() for each id, but it only needs one
+                 * virtual function call and implementations can overlap the
+                 * memory accesses for the different ids.
+                 *
+                 * @param ids Pointer to the ids to look for.
+                 * @param values Pointer to the place where the values will
+                 *               be written to. There must be space for
+                 *               count values. If an id is not found, the
+                 *               empty value is written.
+                 * @param count Number of ids.
+                 */
+                virtual void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        values[i] = get_noexcept(ids[i]);
+                    }
+                }
+
                 /**
                  * Get the approximate number of items in the storage. The storage
                  * might allocate memory in blocks, so this size might not be
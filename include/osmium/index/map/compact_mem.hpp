@@ -0,0 +1,358 @@
+#ifndef OSMIUM_INDEX_MAP_COMPACT_MEM_HPP
+#define OSMIUM_INDEX_MAP_COMPACT_MEM_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <protozero/varint.hpp>
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#define OSMIUM_HAS_INDEX_MAP_COMPACT_MEM
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * This is a compressed in-memory index for node locations. It
+             * stores sorted Ids and locations in blocks, similar to the
+             * DenseNodes in PBF files: The first entry of each block is kept
+             * in a small directory, all other entries are stored as
+             * varint-encoded differences to the previous entry. Lookups
+             * use a binary search on the directory and then decode at most
+             * one block.
+             *
+             * Depending on how close together the Ids and locations of
+             * consecutive nodes are, this needs only about 4 to 8 bytes per
+             * node instead of 16 bytes for the sparse or 8 bytes per
+             * possible Id for the dense indexes.
+             *
+             * This index works best if the Ids are set in increasing order,
+             * as they are in sorted OSM files. Entries set out of order are
+             * kept uncompressed until sort() is called, which will then
+             * re-encode the whole index. This temporarily needs 16 bytes
+             * per entry. If an Id is set more than once, the last value
+             * set wins.
+             *
+             * Call sort() after setting all entries and before reading.
+             *
+             * Only works with osmium::Location as value type.
+             */
+            template <typename TId, typename TValue>
+            class CompactMem : public osmium::index::map::Map<TId, TValue> {
+
+                static_assert(std::is_same<TValue, osmium::Location>::value,
+                              "TValue template parameter for class CompactMem must be osmium::Location");
+
+                // Number of entries in each block. Larger blocks need less
+                // memory for the directory, but lookups take longer.
+                enum constant_block_size : std::size_t {
+                    block_size = 64
+                };
+
+                struct entry {
+                    TId id;
+                    TValue value;
+
+                    entry(TId i, TValue v) :
+                        id(i),
+                        value(v) {
+                    }
+                };
+
+                // Directory entry. Contains the first entry of the block
+                // and the offset of the encoded other entries in m_data.
+                struct block_info {
+                    TId first_id;
+                    std::size_t offset;
+                    int32_t x;
+                    int32_t y;
+                };
+
+                std::vector<block_info> m_directory;
+                std::vector<char> m_data;
+
+                // Entries set in increasing Id order that have not been
+                // encoded yet, because they don't fill a block.
+                std::vector<entry> m_pending;
+
+                // Entries set out of order. They are merged in by sort().
+                std::vector<entry> m_unsorted;
+
+                // Number of entries in directory, data, and pending.
+                std::size_t m_size = 0;
+
+                // Largest Id in directory, data, and pending.
+                TId m_last_id = 0;
+
+                void encode_pending() {
+                    const auto& first = m_pending.front();
+                    m_directory.push_back(block_info{first.id, m_data.size(), first.value.x(), first.value.y()});
+
+                    auto out = std::back_inserter(m_data);
+                    for (auto it = std::next(m_pending.begin()); it != m_pending.end(); ++it) {
+                        const auto& prev = *std::prev(it);
+                        protozero::write_varint(out, it->id - prev.id);
+                        protozero::write_varint(out, protozero::encode_zigzag64(int64_t(it->value.x()) - prev.value.x()));
+                        protozero::write_varint(out, protozero::encode_zigzag64(int64_t(it->value.y()) - prev.value.y()));
+                    }
+
+                    m_pending.clear();
+                }
+
+                void append(const TId id, const TValue value) {
+                    m_pending.emplace_back(id, value);
+                    m_last_id = id;
+                    ++m_size;
+                    if (m_pending.size() == block_size) {
+                        encode_pending();
+                    }
+                }
+
+                const char* block_end(std::size_t block) const noexcept {
+                    return m_data.data() + (block + 1 < m_directory.size() ? m_directory[block + 1].offset : m_data.size());
+                }
+
+                // Call func with each entry in the given block until it
+                // returns true.
+                template <typename TFunc>
+                void decode_block(std::size_t block, TFunc&& func) const {
+                    const auto& info = m_directory[block];
+                    entry current{info.first_id, TValue{info.x, info.y}};
+                    if (func(current)) {
+                        return;
+                    }
+
+                    const char* data = m_data.data() + info.offset;
+                    const char* const end = block_end(block);
+                    while (data != end) {
+                        current.id += TId(protozero::decode_varint(&data, end));
+                        const auto x = int64_t(current.value.x()) + protozero::decode_zigzag64(protozero::decode_varint(&data, end));
+                        const auto y = int64_t(current.value.y()) + protozero::decode_zigzag64(protozero::decode_varint(&data, end));
+                        current.value = TValue{int32_t(x), int32_t(y)};
+                        if (func(current)) {
+                            return;
+                        }
+                    }
+                }
+
+                TValue get_encoded(const TId id) const {
+                    const auto it = std::upper_bound(m_directory.begin(), m_directory.end(), id, [](const TId i, const block_info& info) {
+                        return i < info.first_id;
+                    });
+                    if (it == m_directory.begin()) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+
+                    TValue value = osmium::index::empty_value<TValue>();
+                    decode_block(std::size_t(std::distance(m_directory.begin(), it) - 1), [&](const entry& e) {
+                        if (e.id == id) {
+                            value = e.value;
+                        }
+                        return e.id >= id;
+                    });
+                    return value;
+                }
+
+                TValue get_pending(const TId id) const noexcept {
+                    const auto it = std::lower_bound(m_pending.begin(), m_pending.end(), id, [](const entry& e, const TId i) {
+                        return e.id < i;
+                    });
+                    if (it == m_pending.end() || it->id != id) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return it->value;
+                }
+
+                template <typename TFunc>
+                void for_each_entry(TFunc&& func) const {
+                    for (std::size_t block = 0; block < m_directory.size(); ++block) {
+                        decode_block(block, [&](const entry& e) {
+                            func(e);
+                            return false;
+                        });
+                    }
+                    for (const auto& e : m_pending) {
+                        func(e);
+                    }
+                }
+
+                void release_memory() {
+                    m_directory.clear();
+                    m_directory.shrink_to_fit();
+                    m_data.clear();
+                    m_data.shrink_to_fit();
+                    m_pending.clear();
+                    m_pending.shrink_to_fit();
+                    m_size = 0;
+                    m_last_id = 0;
+                }
+
+            public:
+
+                CompactMem() = default;
+
+                ~CompactMem() noexcept final = default;
+
+                void set(const TId id, const TValue value) final {
+                    if (m_size == 0 || id > m_last_id) {
+                        append(id, value);
+                    } else {
+                        m_unsorted.emplace_back(id, value);
+                    }
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    if (id > m_last_id || m_size == 0) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    if (!m_pending.empty() && id >= m_pending.front().id) {
+                        return get_pending(id);
+                    }
+                    return get_encoded(id);
+                }
+
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        values[i] = get_noexcept(ids[i]);
+                    }
+                }
+
+                TValue get(const TId id) const final {
+                    const auto value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                std::size_t size() const noexcept final {
+                    return m_size + m_unsorted.size();
+                }
+
+                std::size_t used_memory() const noexcept final {
+                    return sizeof(CompactMem) +
+                           m_directory.capacity() * sizeof(block_info) +
+                           m_data.capacity() +
+                           (m_pending.capacity() + m_unsorted.capacity()) * sizeof(entry);
+                }
+
+                void clear() final {
+                    release_memory();
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+                }
+
+                /**
+                 * Merge the entries set out of order into the index. This
+                 * decodes and re-encodes the whole index, so it is only
+                 * expensive if there are such entries.
+                 */
+                void sort() final {
+                    if (m_unsorted.empty()) {
+                        return;
+                    }
+
+                    std::vector<entry> entries;
+                    entries.reserve(m_size + m_unsorted.size());
+                    for_each_entry([&entries](const entry& e) {
+                        entries.push_back(e);
+                    });
+                    entries.insert(entries.end(), m_unsorted.begin(), m_unsorted.end());
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+
+                    // The stable sort keeps entries with the same Id in the
+                    // order they were set in, so we keep the last one.
+                    std::stable_sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) {
+                        return a.id < b.id;
+                    });
+
+                    release_memory();
+                    for (auto it = entries.begin(); it != entries.end(); ++it) {
+                        const auto next = std::next(it);
+                        if (next == entries.end() || next->id != it->id) {
+                            append(it->id, it->value);
+                        }
+                    }
+                }
+
+                void dump_as_list(const int fd) final {
+                    sort();
+
+                    using element_type = std::pair<TId, TValue>;
+                    std::vector<element_type> elements;
+                    elements.reserve(block_size);
+
+                    const auto write_elements = [&]() {
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(elements.data()), sizeof(element_type) * elements.size());
+                        elements.clear();
+                    };
+
+                    for_each_entry([&](const entry& e) {
+                        elements.emplace_back(e.id, e.value);
+                        if (elements.size() == block_size) {
+                            write_elements();
+                        }
+                    });
+                    write_elements();
+                }
+
+            }; // class CompactMem
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompactMem, compact_mem)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_COMPACT_MEM_HPP
@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #ifdef __linux__
 
 #include <osmium/index/detail/mmap_vector_anon.hpp> // IWYU pragma: keep
+#include <osmium/index/detail/parse_mapping_options.hpp>
 #include <osmium/index/detail/vector_map.hpp>
 
 #define OSMIUM_HAS_INDEX_MAP_DENSE_MMAP_ARRAY
@@ -49,6 +50,13 @@ namespace osmium {
             template <typename TId, typename TValue>
             using DenseMmapArray = VectorBasedDenseMap<osmium::detail::mmap_vector_anon<TValue>, TId, TValue>;
 
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, DenseMmapArray> {
+                DenseMmapArray<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    return new DenseMmapArray<TId, TValue>{osmium::index::detail::parse_mapping_options(config, 1)};
+                }
+            };
+
         } // namespace map
 
     } // namespace index
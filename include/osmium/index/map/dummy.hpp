@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
 #include <cstddef>
 
 #include <osmium/index/index.hpp>
@@ -70,6 +71,10 @@ namespace osmium {
                     return osmium::index::empty_value<TValue>();
                 }
 
+                void get_many(const TId* /*ids*/, TValue* values, const std::size_t count) const noexcept final {
+                    std::fill_n(values, count, osmium::index::empty_value<TValue>());
+                }
+
                 size_t size() const final {
                     return 0;
                 }
@@ -41,6 +41,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/index/map.hpp>
 #include <osmium/index/index.hpp>
+#include <osmium/util/compatibility.hpp>
 
 #define OSMIUM_HAS_INDEX_MAP_FLEX_MEM
 
@@ -85,6 +86,11 @@ namespace osmium {
                     density_factor = 3
                 };
 
+                // How many ids ahead get_many() prefetches in dense mode.
+                enum constant_prefetch_distance : std::size_t {
+                    prefetch_distance = 8
+                };
+
                 // An entry in the sparse index
                 struct entry {
                     uint64_t id;
@@ -213,6 +219,27 @@ namespace osmium {
                     return get_sparse(id);
                 }
 
+                void get_many(const TId* ids, TValue* values, const std::size_t count) const noexcept final {
+                    if (!m_dense) {
+                        for (std::size_t i = 0; i < count; ++i) {
+                            values[i] = get_sparse(ids[i]);
+                        }
+                        return;
+                    }
+
+                    // Start loading the data for later ids while working on
+                    // the current one.
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i + prefetch_distance < count) {
+                            const uint64_t id = ids[i + prefetch_distance];
+                            if (block(id) < m_dense_blocks.size() && !m_dense_blocks[block(id)].empty()) {
+                                OSMIUM_PREFETCH(&m_dense_blocks[block(id)][offset(id)]);
+                            }
+                        }
+                        values[i] = get_dense(ids[i]);
+                    }
+                }
+
                 TValue get(const TId id) const final {
                     const auto value = get_noexcept(id);
                     if (value == osmium::index::empty_value<TValue>()) {
@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #ifdef __linux__
 
 #include <osmium/index/detail/mmap_vector_anon.hpp>
+#include <osmium/index/detail/parse_mapping_options.hpp>
 #include <osmium/index/detail/vector_map.hpp>
 
 #define OSMIUM_HAS_INDEX_MAP_SPARSE_MMAP_ARRAY
@@ -49,6 +50,13 @@ namespace osmium {
             template <typename TId, typename TValue>
             using SparseMmapArray = VectorBasedSparseMap<TId, TValue, osmium::detail::mmap_vector_anon>;
 
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, SparseMmapArray> {
+                SparseMmapArray<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    return new SparseMmapArray<TId, TValue>{osmium::index::detail::parse_mapping_options(config, 1)};
+                }
+            };
+
         } // namespace map
 
     } // namespace index
@@ -37,6 +37,10 @@ DEALINGS IN THE SOFTWARE.
 
 #define OSMIUM_WANT_NODE_LOCATION_MAPS
 
+#ifdef OSMIUM_HAS_INDEX_MAP_COMPACT_MEM
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompactMem, compact_mem)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_DENSE_FILE_ARRAY
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseFileArray, dense_file_array)
 #endif
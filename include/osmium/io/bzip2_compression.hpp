@@ -42,15 +42,24 @@ DEALINGS IN THE SOFTWARE.
  * @attention If you include this file, you'll need to link with `libbz2`.
  */
 
+#include <algorithm>
 #include <cerrno>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <deque>
+#include <exception>
+#include <future>
 #include <string>
 #include <system_error>
+#include <utility>
 
 #include <bzlib.h>
 
 #ifndef _MSC_VER
 # include <unistd.h>
+#else
+# include <io.h>
 #endif
 
 #include <osmium/io/compression.hpp>
@@ -58,6 +67,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/util/cast.hpp>
 #include <osmium/util/compatibility.hpp>
 
@@ -97,6 +107,220 @@ namespace osmium {
                 throw osmium::bzip2_error{error, errnum};
             }
 
+            // bzip2 streams start with "BZh" and a digit for the block size
+            // (in 100k). Each compressed block starts with a 48 bit magic
+            // number, followed by the 32 bit CRC of the block data. The end
+            // of a stream is marked with another magic number, followed by
+            // the combined CRC of all blocks in the stream. Blocks are not
+            // aligned to byte boundaries.
+            enum : uint64_t {
+                bzip2_block_magic = 0x314159265359ULL,
+                bzip2_eos_magic   = 0x177245385090ULL
+            };
+
+            inline unsigned int get_bit(const char* data, std::size_t pos) noexcept {
+                return (static_cast<unsigned char>(data[pos >> 3U]) >> (7U - (pos & 7U))) & 1U;
+            }
+
+            inline uint64_t get_bits(const char* data, std::size_t pos, unsigned int count) noexcept {
+                uint64_t value = 0;
+                for (unsigned int i = 0; i < count; ++i) {
+                    value = (value << 1U) | get_bit(data, pos + i);
+                }
+                return value;
+            }
+
+            inline bool is_bzip2_stream_header(const char* data) noexcept {
+                return data[0] == 'B' && data[1] == 'Z' && data[2] == 'h' &&
+                       data[3] >= '1' && data[3] <= '9';
+            }
+
+            /**
+             * Find the first block or end of stream magic number starting
+             * at bit pos or later.
+             *
+             * @returns Bit position of the magic number or size * 8 if none
+             *          was found.
+             */
+            inline std::size_t find_bzip2_magic(const char* data, std::size_t size, std::size_t pos) noexcept {
+                const std::size_t end = size * 8;
+                if (pos + 48 > end) {
+                    return end;
+                }
+
+                // Shift register with the last bits read, the number of
+                // valid bits in it is kept in bits (up to 64).
+                uint64_t reg = 0;
+                unsigned int bits = 0;
+
+                // Read single bits up to the next byte boundary, they can't
+                // contain a complete magic number.
+                for (; (pos & 7U) != 0; ++pos, ++bits) {
+                    reg = (reg << 1U) | get_bit(data, pos);
+                }
+
+                // Then read whole bytes and check the eight positions at
+                // which a magic number can end in each byte, first one
+                // first.
+                for (std::size_t n = pos / 8; n < size; ++n) {
+                    reg = (reg << 8U) | static_cast<unsigned char>(data[n]);
+                    bits = std::min(bits + 8U, 64U);
+                    for (unsigned int shift = 8; shift-- > 0;) {
+                        if (bits < 48 + shift) {
+                            continue;
+                        }
+                        const uint64_t value = (reg >> shift) & 0xffffffffffffULL;
+                        if (value == bzip2_block_magic || value == bzip2_eos_magic) {
+                            return n * 8 + 8 - shift - 48;
+                        }
+                    }
+                }
+
+                return end;
+            }
+
+            /**
+             * One compressed bzip2 block (or what looks like one). The
+             * data contains the bytes from the one with the first bit of
+             * the block to the one with the last bit.
+             */
+            struct bzip2_block {
+                std::string data;
+                std::size_t bit_offset = 0;
+                std::size_t bit_size = 0;
+                uint32_t crc = 0;
+
+                bzip2_block() = default;
+
+                bzip2_block(const char* input, std::size_t begin, std::size_t end) :
+                    data(input + begin / 8, (end + 7) / 8 - begin / 8),
+                    bit_offset(begin % 8),
+                    bit_size(end - begin),
+                    crc(static_cast<uint32_t>(get_bits(input, begin + 48, 32))) {
+                }
+
+                /**
+                 * Append the following block to this one. This is needed if
+                 * a block magic number was found inside the compressed data.
+                 * The CRC of this block stays, because this is still only one
+                 * block.
+                 */
+                void append(const bzip2_block& other) {
+                    const std::size_t end = bit_offset + bit_size;
+                    data.resize(end / 8);
+                    data += other.data;
+                    bit_size += other.bit_size;
+                }
+
+            }; // struct bzip2_block
+
+            /**
+             * Decompresses one bzip2 block by wrapping it into a bzip2
+             * stream of its own. These are the tasks run in the thread pool
+             * by the Bzip2ParallelDecompressor.
+             */
+            class Bzip2BlockDecompressor {
+
+                bzip2_block m_block;
+
+                class bit_writer {
+
+                    std::string& m_out;
+                    unsigned int m_value = 0;
+                    unsigned int m_bits = 0;
+
+                public:
+
+                    explicit bit_writer(std::string& out) :
+                        m_out(out) {
+                    }
+
+                    void put(uint64_t value, unsigned int count) {
+                        while (count > 0) {
+                            --count;
+                            m_value = (m_value << 1U) | static_cast<unsigned int>((value >> count) & 1U);
+                            if (++m_bits == 8) {
+                                m_out += static_cast<char>(m_value);
+                                m_value = 0;
+                                m_bits = 0;
+                            }
+                        }
+                    }
+
+                    void flush() {
+                        if (m_bits > 0) {
+                            put(0, 8 - m_bits);
+                        }
+                    }
+
+                }; // class bit_writer
+
+                std::string make_stream() const {
+                    // Always use the largest block size, it is only an
+                    // upper limit.
+                    std::string stream{"BZh9"};
+                    stream.reserve(stream.size() + m_block.bit_size / 8 + 12);
+
+                    const auto* data = reinterpret_cast<const unsigned char*>(m_block.data.data());
+                    const std::size_t offset = m_block.bit_offset;
+                    const std::size_t full_bytes = m_block.bit_size / 8;
+                    for (std::size_t i = 0; i < full_bytes; ++i) {
+                        if (offset == 0) {
+                            stream += static_cast<char>(data[i]);
+                        } else {
+                            stream += static_cast<char>(((data[i] << offset) | (data[i + 1] >> (8 - offset))) & 0xffU);
+                        }
+                    }
+
+                    bit_writer writer{stream};
+                    const auto rest = static_cast<unsigned int>(m_block.bit_size % 8);
+                    writer.put(get_bits(m_block.data.data(), offset + full_bytes * 8, rest), rest);
+                    writer.put(bzip2_eos_magic, 48);
+                    writer.put(m_block.crc, 32);
+                    writer.flush();
+
+                    return stream;
+                }
+
+            public:
+
+                explicit Bzip2BlockDecompressor(bzip2_block&& block) :
+                    m_block(std::move(block)) {
+                }
+
+                std::string operator()() const {
+                    std::string stream{make_stream()};
+
+                    bz_stream bzstream{};
+                    int result = BZ2_bzDecompressInit(&bzstream, 0, 0);
+                    if (result != BZ_OK) {
+                        throw bzip2_error{"bzip2 error: decompression init failed", result};
+                    }
+
+                    bzstream.next_in = &stream[0];
+                    bzstream.avail_in = static_cast_with_assert<unsigned int>(stream.size());
+
+                    std::string output;
+                    do {
+                        const std::size_t size = output.size();
+                        output.resize(size + osmium::io::Decompressor::input_buffer_size);
+                        bzstream.next_out = &output[size];
+                        bzstream.avail_out = osmium::io::Decompressor::input_buffer_size;
+                        result = BZ2_bzDecompress(&bzstream);
+                        output.resize(output.size() - bzstream.avail_out);
+                    } while (result == BZ_OK && (bzstream.avail_in > 0 || bzstream.avail_out == 0));
+
+                    BZ2_bzDecompressEnd(&bzstream);
+
+                    if (result != BZ_STREAM_END) {
+                        throw bzip2_error{"bzip2 error: block decompression failed", result == BZ_OK ? BZ_UNEXPECTED_EOF : result};
+                    }
+
+                    return output;
+                }
+
+            }; // class Bzip2BlockDecompressor
+
         } // namespace detail
 
         class Bzip2Compressor : public Compressor {
@@ -238,6 +462,299 @@ namespace osmium {
 
         }; // class Bzip2Decompressor
 
+        /**
+         * Reads bzip2 compressed files decompressing the blocks in
+         * parallel in the thread pool. The blocks are found by looking for
+         * their magic numbers in the compressed data, every block is then
+         * decompressed as a stream of its own. Files with several
+         * concatenated streams (as written by pbzip2 for instance) are
+         * handled, too.
+         *
+         * The magic numbers can also appear by chance inside the compressed
+         * data of a block. If a block can't be decompressed, it is tried
+         * again together with the following (presumed) blocks.
+         */
+        class Bzip2ParallelDecompressor : public Decompressor {
+
+            // Maximum number of blocks decompressed at the same time
+            // (per thread in the pool).
+            enum constant_max_blocks_per_thread : std::size_t {
+                max_blocks_per_thread = 2
+            };
+
+            // Maximum number of presumed blocks tried together when a
+            // block can't be decompressed.
+            enum constant_max_merged_blocks : std::size_t {
+                max_merged_blocks = 8
+            };
+
+            struct pending_block {
+                detail::bzip2_block block;
+                std::future<std::string> future;
+                bool end_of_stream = false;
+                uint32_t crc = 0; // combined CRC if end_of_stream is set
+            };
+
+            int m_fd;
+
+            // The pool used or nullptr for the default pool.
+            osmium::thread::Pool* m_pool;
+            std::deque<pending_block> m_pending;
+
+            std::string m_input;
+            std::size_t m_offset = 0;
+            bool m_input_done = false;
+
+            // Bit position in m_input of the current block or stream header.
+            std::size_t m_pos = 0;
+            bool m_at_stream_header = true;
+            bool m_done = false;
+
+            uint32_t m_combined_crc = 0;
+
+            // Make sure at least size bytes of input are available. Returns
+            // false if the end of file is reached before that.
+            bool fill_input(std::size_t size) {
+                while (m_input.size() < size) {
+                    if (m_input_done) {
+                        return false;
+                    }
+                    const std::size_t old_size = m_input.size();
+                    m_input.resize(old_size + osmium::io::Decompressor::input_buffer_size);
+                    const auto nread = ::read(m_fd, &m_input[old_size], osmium::io::Decompressor::input_buffer_size);
+                    if (nread < 0) {
+                        throw std::system_error{errno, std::system_category(), "Read failed"};
+                    }
+                    m_input.resize(old_size + std::size_t(nread));
+                    m_offset += std::size_t(nread);
+                    if (nread == 0) {
+                        m_input_done = true;
+                    }
+                }
+                return true;
+            }
+
+            osmium::thread::Pool& pool() const {
+                return m_pool ? *m_pool : osmium::thread::Pool::default_instance();
+            }
+
+            void add_block(std::size_t end) {
+                pending_block p;
+                p.block = detail::bzip2_block{m_input.data(), m_pos, end};
+                p.future = pool().submit(detail::Bzip2BlockDecompressor{detail::bzip2_block{p.block}});
+                m_pending.push_back(std::move(p));
+            }
+
+            void add_end_of_stream(std::size_t pos) {
+                pending_block p;
+                p.end_of_stream = true;
+                p.crc = static_cast<uint32_t>(detail::get_bits(m_input.data(), pos + 48, 32));
+                m_pending.push_back(std::move(p));
+                m_pos = (pos + 48 + 32 + 7) / 8 * 8;
+                m_at_stream_header = true;
+            }
+
+            // Is there a stream header or the end of the file at the
+            // (byte aligned) bit position?
+            bool stream_header_or_end_at(std::size_t pos) {
+                if (!fill_input(pos / 8 + 4)) {
+                    return m_input.size() == pos / 8;
+                }
+                return detail::is_bzip2_stream_header(m_input.data() + pos / 8);
+            }
+
+            // Find the next block or end of stream and add it to the
+            // pending blocks.
+            void scan_next() {
+                // Remove input which isn't needed any more.
+                const std::size_t used = m_pos / 8;
+                m_input.erase(0, used);
+                m_pos -= used * 8;
+
+                if (m_at_stream_header) {
+                    if (!fill_input(4)) {
+                        if (!m_input.empty()) {
+                            throw bzip2_error{"bzip2 error: unexpected end of file", BZ_UNEXPECTED_EOF};
+                        }
+                        m_done = true;
+                        return;
+                    }
+                    if (!detail::is_bzip2_stream_header(m_input.data())) {
+                        throw bzip2_error{"bzip2 error: invalid stream header", BZ_DATA_ERROR_MAGIC};
+                    }
+                    m_pos = 32;
+                    m_at_stream_header = false;
+                    if (!fill_input(10)) {
+                        throw bzip2_error{"bzip2 error: unexpected end of file", BZ_UNEXPECTED_EOF};
+                    }
+                    const auto magic = detail::get_bits(m_input.data(), m_pos, 48);
+                    if (magic == detail::bzip2_eos_magic) {
+                        if (!fill_input(14)) {
+                            throw bzip2_error{"bzip2 error: unexpected end of file", BZ_UNEXPECTED_EOF};
+                        }
+                        add_end_of_stream(m_pos);
+                        return;
+                    }
+                    if (magic != detail::bzip2_block_magic) {
+                        throw bzip2_error{"bzip2 error: invalid block header", BZ_DATA_ERROR};
+                    }
+                }
+
+                // m_pos is at the magic number of a block, look for the
+                // magic number after it.
+                std::size_t search_pos = m_pos + 48;
+                while (true) {
+                    const std::size_t pos = detail::find_bzip2_magic(m_input.data(), m_input.size(), search_pos);
+                    if (pos == m_input.size() * 8) {
+                        if (!fill_input(m_input.size() + 1)) {
+                            throw bzip2_error{"bzip2 error: unexpected end of file", BZ_UNEXPECTED_EOF};
+                        }
+                        search_pos = pos > search_pos + 47 ? pos - 47 : search_pos;
+                        continue;
+                    }
+                    if (detail::get_bits(m_input.data(), pos, 48) == detail::bzip2_block_magic) {
+                        add_block(pos);
+                        m_pos = pos;
+                        return;
+                    }
+                    // End of stream magic number, but only if there is
+                    // another stream or the end of the file after it.
+                    if (fill_input((pos + 80 + 7) / 8) && stream_header_or_end_at((pos + 80 + 7) / 8 * 8)) {
+                        add_block(pos);
+                        add_end_of_stream(pos);
+                        return;
+                    }
+                    search_pos = pos + 1;
+                }
+            }
+
+            void submit_blocks() {
+                const std::size_t max_pending = max_blocks_per_thread * std::size_t(pool().num_threads());
+                while (!m_done && m_pending.size() < max_pending) {
+                    scan_next();
+                }
+            }
+
+            // Called when the first pending block couldn't be decompressed:
+            // Try again together with the following presumed blocks.
+            std::string decompress_merged_blocks(std::exception_ptr error) {
+                detail::bzip2_block block{std::move(m_pending.front().block)};
+                m_pending.pop_front();
+                for (std::size_t n = 1; n < max_merged_blocks; ++n) {
+                    if (m_pending.empty()) {
+                        if (!m_done) {
+                            scan_next();
+                        }
+                        if (m_pending.empty()) {
+                            break;
+                        }
+                    }
+                    if (m_pending.front().end_of_stream) {
+                        break;
+                    }
+                    block.append(m_pending.front().block);
+                    m_pending.pop_front();
+                    try {
+                        // Decompress a copy, the block is still needed if
+                        // this fails and the next block has to be appended.
+                        std::string output{detail::Bzip2BlockDecompressor{detail::bzip2_block{block}}()};
+                        add_to_combined_crc(block.crc);
+                        return output;
+                    } catch (const bzip2_error&) {
+                    }
+                }
+                std::rethrow_exception(error);
+            }
+
+            void add_to_combined_crc(uint32_t crc) noexcept {
+                m_combined_crc = ((m_combined_crc << 1U) | (m_combined_crc >> 31U)) ^ crc;
+            }
+
+        public:
+
+            /**
+             * Create decompressor reading from the file descriptor fd.
+             * The default thread pool is used unless use_thread_pool() is
+             * called.
+             */
+            explicit Bzip2ParallelDecompressor(int fd) :
+                Decompressor(),
+                m_fd(fd),
+                m_pool(nullptr) {
+            }
+
+            /**
+             * Create decompressor reading from the file descriptor fd and
+             * decompressing in the specified thread pool.
+             */
+            Bzip2ParallelDecompressor(int fd, osmium::thread::Pool& pool) :
+                Decompressor(),
+                m_fd(fd),
+                m_pool(&pool) {
+            }
+
+            Bzip2ParallelDecompressor(const Bzip2ParallelDecompressor&) = delete;
+            Bzip2ParallelDecompressor& operator=(const Bzip2ParallelDecompressor&) = delete;
+
+            Bzip2ParallelDecompressor(Bzip2ParallelDecompressor&&) = delete;
+            Bzip2ParallelDecompressor& operator=(Bzip2ParallelDecompressor&&) = delete;
+
+            ~Bzip2ParallelDecompressor() noexcept final {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            void use_thread_pool(osmium::thread::Pool& pool) final {
+                m_pool = &pool;
+            }
+
+            std::string read() final {
+                while (true) {
+                    submit_blocks();
+                    if (m_pending.empty()) {
+                        return std::string{};
+                    }
+
+                    if (m_pending.front().end_of_stream) {
+                        const bool crc_okay = m_pending.front().crc == m_combined_crc;
+                        m_pending.pop_front();
+                        m_combined_crc = 0;
+                        if (!crc_okay) {
+                            throw bzip2_error{"bzip2 error: combined crc mismatch", BZ_DATA_ERROR};
+                        }
+                        continue;
+                    }
+
+                    std::string output;
+                    try {
+                        output = m_pending.front().future.get();
+                        add_to_combined_crc(m_pending.front().block.crc);
+                        m_pending.pop_front();
+                    } catch (const bzip2_error&) {
+                        output = decompress_merged_blocks(std::current_exception());
+                    }
+
+                    set_offset(m_offset);
+                    if (!output.empty()) {
+                        return output;
+                    }
+                }
+            }
+
+            void close() final {
+                m_pending.clear();
+                if (m_fd >= 0) {
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+        }; // class Bzip2ParallelDecompressor
+
         class Bzip2BufferDecompressor : public Decompressor {
 
             const char* m_buffer;
@@ -305,7 +822,7 @@ namespace osmium {
             // the variable is only a side-effect, it will never be used
             const bool registered_bzip2_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::bzip2,
                 [](int fd, fsync sync) { return new osmium::io::Bzip2Compressor{fd, sync}; },
-                [](int fd) { return new osmium::io::Bzip2Decompressor{fd}; },
+                [](int fd) { return new osmium::io::Bzip2ParallelDecompressor{fd}; },
                 [](const char* buffer, size_t size) { return new osmium::io::Bzip2BufferDecompressor{buffer, size}; }
             );
 
@@ -58,6 +58,10 @@ DEALINGS IN THE SOFTWARE.
 
 namespace osmium {
 
+    namespace thread {
+        class Pool;
+    } // namespace thread
+
     namespace io {
 
         class Compressor {
@@ -78,6 +82,14 @@ namespace osmium {
 
             virtual ~Compressor() noexcept = default;
 
+            /**
+             * Compress chunks of the data in parallel using the specified
+             * thread pool. This must be called before any data is written.
+             * Compressors that can't do this ignore it.
+             */
+            virtual void compress_in_parallel(osmium::thread::Pool& /*pool*/) {
+            }
+
             virtual void write(const std::string& data) = 0;
 
             virtual void close() = 0;
@@ -103,6 +115,15 @@ namespace osmium {
 
             virtual ~Decompressor() noexcept = default;
 
+            /**
+             * Decompress in parallel using the specified thread pool
+             * instead of the default pool. This must be called before
+             * the first read(). Decompressors that don't decompress in
+             * parallel ignore it.
+             */
+            virtual void use_thread_pool(osmium::thread::Pool& /*pool*/) {
+            }
+
             virtual std::string read() = 0;
 
             virtual void close() = 0;
@@ -207,7 +207,7 @@ namespace osmium {
 
                 void write_timestamp(const osmium::Timestamp& timestamp) {
                     if (timestamp.valid()) {
-                        *m_out += timestamp.to_iso();
+                        timestamp.to_iso(std::back_inserter(*m_out));
                         *m_out += " (";
                         output_int(timestamp.seconds_since_epoch());
                         *m_out += ')';
@@ -316,8 +316,8 @@ namespace osmium {
 
             public:
 
-                DebugOutputBlock(osmium::memory::Buffer&& buffer, const debug_output_options& options) :
-                    OutputBlock(std::move(buffer)),
+                DebugOutputBlock(osmium::memory::Buffer&& buffer, const debug_output_options& options, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    OutputBlock(std::move(buffer), buffer_pool),
                     m_options(options),
                     m_utf8_prefix(options.use_color ? color_red  : ""),
                     m_utf8_suffix(options.use_color ? color_blue : "") {
@@ -325,6 +325,7 @@ namespace osmium {
 
                 std::string operator()() {
                     osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+                    m_input_buffer.reset();
 
                     std::string out;
                     using std::swap;
@@ -570,7 +571,7 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(buffer), m_options}));
+                    m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(buffer), m_options, m_buffer_pool}));
                 }
 
             }; // class DebugOutputFormat
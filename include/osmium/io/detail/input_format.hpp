@@ -41,12 +41,14 @@ DEALINGS IN THE SOFTWARE.
 #include <string>
 #include <utility>
 
+#include <osmium/io/detail/mapped_input_file.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 
@@ -54,6 +56,8 @@ namespace osmium {
 
     namespace io {
 
+        class PBFBlobIndex;
+
         namespace detail {
 
             struct parser_arguments {
@@ -63,6 +67,23 @@ namespace osmium {
                 std::promise<osmium::io::Header>& header_promise;
                 osmium::osm_entity_bits::type read_which_entities;
                 osmium::io::read_meta read_metadata;
+
+                // Set if the parser should read from a memory mapping of
+                // the input file instead of from the input queue.
+                std::shared_ptr<MappedInputFile> mapped_input;
+
+                // Set if the parser should only decode the blobs in this
+                // index. Only used by the PBF parser.
+                const osmium::io::PBFBlobIndex* blob_index;
+
+                // Set if the parser should split the input and parse the
+                // parts in parallel in the thread pool. Only used by the
+                // XML parser.
+                bool parallel;
+
+                // Set if the parser should get the buffers it fills from
+                // this pool instead of allocating new ones.
+                osmium::memory::BufferPool* buffer_pool;
             };
 
             class Parser {
@@ -73,6 +94,10 @@ namespace osmium {
                 queue_wrapper<std::string> m_input_queue;
                 osmium::osm_entity_bits::type m_read_which_entities;
                 osmium::io::read_meta m_read_metadata;
+                std::shared_ptr<MappedInputFile> m_mapped_input;
+                const osmium::io::PBFBlobIndex* m_blob_index;
+                bool m_parallel;
+                osmium::memory::BufferPool* m_buffer_pool;
                 bool m_header_is_done;
 
             protected:
@@ -89,6 +114,50 @@ namespace osmium {
                     return m_read_metadata;
                 }
 
+                /**
+                 * Memory mapping of the input file. This is only set if
+                 * the Reader decided that the parser should access the
+                 * input file directly, otherwise it is empty and the data
+                 * has to be read with get_input().
+                 */
+                const std::shared_ptr<MappedInputFile>& mapped_input() const noexcept {
+                    return m_mapped_input;
+                }
+
+                /**
+                 * Index of the blobs in the input file the parser should
+                 * decode. This is only set if the user gave an index to
+                 * the Reader, otherwise it is nullptr.
+                 */
+                const osmium::io::PBFBlobIndex* blob_index() const noexcept {
+                    return m_blob_index;
+                }
+
+                /**
+                 * Did the user ask for parsing the input in parallel? Only
+                 * used by parsers for which this is optional.
+                 */
+                bool parse_in_parallel() const noexcept {
+                    return m_parallel;
+                }
+
+                /**
+                 * Pool the buffers for the parsed data should come from.
+                 * This is nullptr if the user didn't give a pool to the
+                 * Reader, use new_buffer() to handle both cases.
+                 */
+                osmium::memory::BufferPool* buffer_pool() const noexcept {
+                    return m_buffer_pool;
+                }
+
+                /**
+                 * Get a buffer for the parsed data from the buffer pool or
+                 * allocate a new one if there is no pool.
+                 */
+                osmium::memory::Buffer new_buffer(std::size_t capacity, osmium::memory::Buffer::auto_grow auto_grow = osmium::memory::Buffer::auto_grow::yes) {
+                    return osmium::memory::detail::get_buffer(m_buffer_pool, capacity, auto_grow);
+                }
+
                 bool header_is_done() const noexcept {
                     return m_header_is_done;
                 }
@@ -127,6 +196,10 @@ namespace osmium {
                     m_input_queue(args.input_queue),
                     m_read_which_entities(args.read_which_entities),
                     m_read_metadata(args.read_metadata),
+                    m_mapped_input(args.mapped_input),
+                    m_blob_index(args.blob_index),
+                    m_parallel(args.parallel),
+                    m_buffer_pool(args.buffer_pool),
                     m_header_is_done(false) {
                 }
 
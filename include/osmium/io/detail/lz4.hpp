@@ -0,0 +1,121 @@
+#ifndef OSMIUM_IO_DETAIL_LZ4_HPP
+#define OSMIUM_IO_DETAIL_LZ4_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to read or write PBF files with lz4
+ * compressed blobs. You also have to define OSMIUM_WITH_LZ4 before
+ * including any PBF-related Osmium headers.
+ *
+ * @attention If you include this file, you'll need to link with `liblz4`.
+ */
+
+#include <cstddef>
+#include <string>
+
+#include <lz4.h>
+#include <lz4hc.h>
+
+#include <protozero/types.hpp>
+
+#include <osmium/io/error.hpp>
+#include <osmium/util/cast.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Compress data using lz4.
+             *
+             * @param input Data to compress.
+             * @param level Compression level. If this is larger than 0,
+             *              the slower lz4 high compression mode is used with
+             *              this level.
+             * @returns Compressed data.
+             */
+            inline std::string lz4_compress(const std::string& input, int level = 0) {
+                const int input_size = osmium::static_cast_with_assert<int>(input.size());
+                const int output_size = ::LZ4_compressBound(input_size);
+
+                std::string output(static_cast<std::size_t>(output_size), '\0');
+
+                const int result = level > 0
+                    ? ::LZ4_compress_HC(input.data(), &*output.begin(), input_size, output_size, level)
+                    : ::LZ4_compress_default(input.data(), &*output.begin(), input_size, output_size);
+
+                if (result <= 0) {
+                    throw io_error{"failed to compress data with lz4"};
+                }
+
+                output.resize(static_cast<std::size_t>(result));
+
+                return output;
+            }
+
+            /**
+             * Uncompress data using lz4.
+             *
+             * @param input Compressed input data.
+             * @param input_size Size of compressed input data.
+             * @param raw_size Size of uncompressed data.
+             * @param output Uncompressed result data.
+             * @returns Pointer and size to incompressed data.
+             */
+            inline protozero::data_view lz4_uncompress_string(const char* input, std::size_t input_size, std::size_t raw_size, std::string& output) {
+                output.resize(raw_size);
+
+                const int result = ::LZ4_decompress_safe(input,
+                                                         &*output.begin(),
+                                                         osmium::static_cast_with_assert<int>(input_size),
+                                                         osmium::static_cast_with_assert<int>(raw_size));
+
+                if (result < 0 || static_cast<std::size_t>(result) != raw_size) {
+                    throw io_error{"failed to uncompress data with lz4"};
+                }
+
+                return protozero::data_view{output.data(), output.size()};
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_LZ4_HPP
@@ -0,0 +1,124 @@
+#ifndef OSMIUM_IO_DETAIL_MAPPED_INPUT_FILE_HPP
+#define OSMIUM_IO_DETAIL_MAPPED_INPUT_FILE_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <atomic>
+#include <cstddef>
+
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Read-only memory mapping of a complete input file. This is
+             * used by parsers that work on the file contents directly
+             * instead of getting the data through the input queue.
+             *
+             * An object of this class is shared (through a std::shared_ptr)
+             * between the Reader, the parser and all tasks the parser sends
+             * to the thread pool. This way the mapping stays valid as long
+             * as anybody still has a pointer into it.
+             */
+            class MappedInputFile {
+
+                osmium::util::MemoryMapping m_mapping;
+
+                // Current offset of the parser into the file. Used for
+                // progress reporting only.
+                std::atomic<std::size_t> m_offset{0};
+
+                // Set by the Reader to tell the parser to stop early.
+                std::atomic<bool> m_done{false};
+
+            public:
+
+                /**
+                 * Map the file with the given file descriptor. The file
+                 * descriptor is not needed any more after the constructor
+                 * returns and can be closed by the caller.
+                 *
+                 * @pre File must not be empty.
+                 * @throws std::system_error if the mapping fails.
+                 */
+                explicit MappedInputFile(int fd) :
+                    m_mapping(osmium::util::file_size(fd), osmium::util::MemoryMapping::mapping_mode::readonly, fd) {
+                }
+
+                MappedInputFile(const MappedInputFile&) = delete;
+                MappedInputFile& operator=(const MappedInputFile&) = delete;
+
+                MappedInputFile(MappedInputFile&&) = delete;
+                MappedInputFile& operator=(MappedInputFile&&) = delete;
+
+                ~MappedInputFile() noexcept = default;
+
+                const char* data() const {
+                    return m_mapping.get_addr<const char>();
+                }
+
+                std::size_t size() const noexcept {
+                    return m_mapping.size();
+                }
+
+                std::size_t offset() const noexcept {
+                    return m_offset;
+                }
+
+                void set_offset(std::size_t offset) noexcept {
+                    m_offset = offset;
+                }
+
+                /// Tell the parser to stop at the next opportunity.
+                void stop() noexcept {
+                    m_done = true;
+                }
+
+                bool stopped() const noexcept {
+                    return m_done;
+                }
+
+            }; // class MappedInputFile
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_MAPPED_INPUT_FILE_HPP
@@ -0,0 +1,103 @@
+#ifndef OSMIUM_IO_DETAIL_O5M_HPP
+#define OSMIUM_IO_DETAIL_O5M_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+#include <protozero/varint.hpp>
+
+#include <osmium/io/error.hpp>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when the o5m deocder failed. The exception contains
+     * (if available) information about the place where the error happened
+     * and the type of error.
+     */
+    struct o5m_error : public io_error {
+
+        explicit o5m_error(const char* what) :
+            io_error(std::string{"o5m format error: "} + what) {
+        }
+
+    }; // struct o5m_error
+
+    namespace io {
+
+        namespace detail {
+
+            // Implementation of the o5m/o5c file formats according to the
+            // description at http://wiki.openstreetmap.org/wiki/O5m .
+
+            enum class o5m_dataset : unsigned char {
+                node         = 0x10,
+                way          = 0x11,
+                relation     = 0x12,
+                bounding_box = 0xdb,
+                timestamp    = 0xdc,
+                header       = 0xe0,
+                sync         = 0xee,
+                jump         = 0xef,
+                end_of_file  = 0xfe,
+                reset        = 0xff
+            };
+
+            inline void o5m_append_varint(std::string& out, uint64_t value) {
+                protozero::write_varint(std::back_inserter(out), value);
+            }
+
+            inline void o5m_append_zvarint(std::string& out, int64_t value) {
+                o5m_append_varint(out, protozero::encode_zigzag64(value));
+            }
+
+            inline int64_t o5m_decode_zvarint(const char** data, const char* end) {
+                return protozero::decode_zigzag64(protozero::decode_varint(data, end));
+            }
+
+            inline void o5m_append_dataset(std::string& out, o5m_dataset type, const std::string& data) {
+                out += static_cast<char>(type);
+                o5m_append_varint(out, data.size());
+                out += data;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_O5M_HPP
@@ -47,11 +47,13 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/io/detail/input_format.hpp>
+#include <osmium/io/detail/o5m.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
@@ -72,26 +74,10 @@ namespace osmium {
         class Builder;
     } // namespace builder
 
-    /**
-     * Exception thrown when the o5m deocder failed. The exception contains
-     * (if available) information about the place where the error happened
-     * and the type of error.
-     */
-    struct o5m_error : public io_error {
-
-        explicit o5m_error(const char* what) :
-            io_error(std::string{"o5m format error: "} + what) {
-        }
-
-    }; // struct o5m_error
-
     namespace io {
 
         namespace detail {
 
-            // Implementation of the o5m/o5c file formats according to the
-            // description at http://wiki.openstreetmap.org/wiki/O5m .
-
             class ReferenceTable {
 
                 // The following settings are from the o5m description:
@@ -143,93 +129,19 @@ namespace osmium {
 
             }; // class ReferenceTable
 
-            class O5mParser : public Parser {
-
-                static constexpr int buffer_size = 2 * 1000 * 1000;
-
-                osmium::io::Header m_header;
-
-                osmium::memory::Buffer m_buffer;
-
-                std::string m_input;
-
-                const char* m_data;
-                const char* m_end;
+            /**
+             * Decodes o5m datasets containing OSM objects into a buffer.
+             * Holds the string reference table and the delta decoding
+             * state, both of which are cleared by a reset.
+             */
+            class O5mDecoder {
 
                 ReferenceTable m_reference_table;
 
-                static int64_t zvarint(const char** data, const char* end) {
-                    return protozero::decode_zigzag64(protozero::decode_varint(data, end));
-                }
-
-                bool ensure_bytes_available(std::size_t need_bytes) {
-                    if ((m_end - m_data) >= long(need_bytes)) {
-                        return true;
-                    }
-
-                    if (input_done() && (m_input.size() < need_bytes)) {
-                        return false;
-                    }
-
-                    m_input.erase(0, m_data - m_input.data());
-
-                    while (m_input.size() < need_bytes) {
-                        const std::string data{get_input()};
-                        if (input_done()) {
-                            return false;
-                        }
-                        m_input.append(data);
-                    }
-
-                    m_data = m_input.data();
-                    m_end = m_input.data() + m_input.size();
-
-                    return true;
-                }
-
-                void check_header_magic() {
-                    static const unsigned char header_magic[] = { 0xff, 0xe0, 0x04, 'o', '5' };
-
-                    if (std::strncmp(reinterpret_cast<const char*>(header_magic), m_data, sizeof(header_magic))) {
-                        throw o5m_error{"wrong header magic"};
-                    }
-
-                    m_data += sizeof(header_magic);
-                }
-
-                void check_file_type() {
-                    if (*m_data == 'm') {         // o5m data file
-                        m_header.set_has_multiple_object_versions(false);
-                    } else if (*m_data == 'c') {  // o5c change file
-                        m_header.set_has_multiple_object_versions(true);
-                    } else {
-                        throw o5m_error{"wrong header magic"};
-                    }
-
-                    m_data++;
-                }
-
-                void check_file_format_version() {
-                    if (*m_data != '2') {
-                        throw o5m_error{"wrong header magic"};
-                    }
-
-                    m_data++;
-                }
-
-                void decode_header() {
-                    if (! ensure_bytes_available(7)) { // overall length of header
-                        throw o5m_error{"file too short (incomplete header info)"};
-                    }
+                osmium::memory::Buffer m_buffer;
+                osmium::memory::BufferPool* m_buffer_pool;
 
-                    check_header_magic();
-                    check_file_type();
-                    check_file_format_version();
-                }
-
-                void mark_header_as_done() {
-                    set_header_value(m_header);
-                }
+                osmium::osm_entity_bits::type m_read_types;
 
                 osmium::util::DeltaDecode<osmium::object_id_type> m_delta_id;
 
@@ -241,21 +153,6 @@ namespace osmium {
                 osmium::util::DeltaDecode<osmium::object_id_type> m_delta_way_node_id;
                 osmium::util::DeltaDecode<osmium::object_id_type> m_delta_member_ids[3];
 
-                void reset() {
-                    m_reference_table.clear();
-
-                    m_delta_id.clear();
-                    m_delta_timestamp.clear();
-                    m_delta_changeset.clear();
-                    m_delta_lon.clear();
-                    m_delta_lat.clear();
-
-                    m_delta_way_node_id.clear();
-                    m_delta_member_ids[0].clear();
-                    m_delta_member_ids[1].clear();
-                    m_delta_member_ids[2].clear();
-                }
-
                 const char* decode_string(const char** dataptr, const char* const end) {
                     if (**dataptr == 0x00) { // get inline string
                         (*dataptr)++;
@@ -339,10 +236,10 @@ namespace osmium {
                         ++*dataptr;
                     } else { // has info section
                         object.set_version(static_cast_with_assert<object_version_type>(protozero::decode_varint(dataptr, end)));
-                        auto timestamp = m_delta_timestamp.update(zvarint(dataptr, end));
+                        auto timestamp = m_delta_timestamp.update(o5m_decode_zvarint(dataptr, end));
                         if (timestamp != 0) { // has timestamp
                             object.set_timestamp(timestamp);
-                            object.set_changeset(m_delta_changeset.update(zvarint(dataptr, end)));
+                            object.set_changeset(m_delta_changeset.update(o5m_decode_zvarint(dataptr, end)));
                             if (*dataptr != end) {
                                 auto uid_user = decode_user(dataptr, end);
                                 object.set_uid(uid_user.first);
@@ -359,7 +256,7 @@ namespace osmium {
                 void decode_node(const char* data, const char* const end) {
                     osmium::builder::NodeBuilder builder{m_buffer};
 
-                    builder.set_id(m_delta_id.update(zvarint(&data, end)));
+                    builder.set_id(m_delta_id.update(o5m_decode_zvarint(&data, end)));
 
                     builder.set_user(decode_info(builder.object(), &data, end));
 
@@ -368,8 +265,8 @@ namespace osmium {
                         builder.set_visible(false);
                         builder.set_location(osmium::Location{});
                     } else {
-                        auto lon = m_delta_lon.update(zvarint(&data, end));
-                        auto lat = m_delta_lat.update(zvarint(&data, end));
+                        auto lon = m_delta_lon.update(o5m_decode_zvarint(&data, end));
+                        auto lat = m_delta_lat.update(o5m_decode_zvarint(&data, end));
                         builder.set_location(osmium::Location{lon, lat});
 
                         if (data != end) {
@@ -381,7 +278,7 @@ namespace osmium {
                 void decode_way(const char* data, const char* const end) {
                     osmium::builder::WayBuilder builder{m_buffer};
 
-                    builder.set_id(m_delta_id.update(zvarint(&data, end)));
+                    builder.set_id(m_delta_id.update(o5m_decode_zvarint(&data, end)));
 
                     builder.set_user(decode_info(builder.object(), &data, end));
 
@@ -399,7 +296,7 @@ namespace osmium {
                             osmium::builder::WayNodeListBuilder wn_builder{builder};
 
                             while (data < end_refs) {
-                                wn_builder.add_node_ref(m_delta_way_node_id.update(zvarint(&data, end)));
+                                wn_builder.add_node_ref(m_delta_way_node_id.update(o5m_decode_zvarint(&data, end)));
                             }
                         }
 
@@ -444,7 +341,7 @@ namespace osmium {
                 void decode_relation(const char* data, const char* const end) {
                     osmium::builder::RelationBuilder builder{m_buffer};
 
-                    builder.set_id(m_delta_id.update(zvarint(&data, end)));
+                    builder.set_id(m_delta_id.update(o5m_decode_zvarint(&data, end)));
 
                     builder.set_user(decode_info(builder.object(), &data, end));
 
@@ -462,7 +359,7 @@ namespace osmium {
                             osmium::builder::RelationMemberListBuilder rml_builder{builder};
 
                             while (data < end_refs) {
-                                auto delta_id = zvarint(&data, end);
+                                auto delta_id = o5m_decode_zvarint(&data, end);
                                 if (data == end) {
                                     throw o5m_error{"relation member format error"};
                                 }
@@ -479,46 +376,320 @@ namespace osmium {
                     }
                 }
 
+            public:
+
+                O5mDecoder(std::size_t buffer_size, osmium::osm_entity_bits::type read_types, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_reference_table(),
+                    m_buffer(osmium::memory::detail::get_buffer(buffer_pool, buffer_size)),
+                    m_buffer_pool(buffer_pool),
+                    m_read_types(read_types) {
+                }
+
+                const osmium::memory::Buffer& buffer() const noexcept {
+                    return m_buffer;
+                }
+
+                /**
+                 * Return the buffer with the decoded objects and start a
+                 * new one with the given size.
+                 */
+                osmium::memory::Buffer take_buffer(std::size_t buffer_size) {
+                    osmium::memory::Buffer buffer{osmium::memory::detail::get_buffer(m_buffer_pool, buffer_size)};
+                    using std::swap;
+                    swap(m_buffer, buffer);
+                    return buffer;
+                }
+
+                /**
+                 * Return the buffer with the decoded objects. Nothing can
+                 * be decoded after this.
+                 */
+                osmium::memory::Buffer take_buffer() {
+                    return std::move(m_buffer);
+                }
+
+                void reset() {
+                    m_reference_table.clear();
+
+                    m_delta_id.clear();
+                    m_delta_timestamp.clear();
+                    m_delta_changeset.clear();
+                    m_delta_lon.clear();
+                    m_delta_lat.clear();
+
+                    m_delta_way_node_id.clear();
+                    m_delta_member_ids[0].clear();
+                    m_delta_member_ids[1].clear();
+                    m_delta_member_ids[2].clear();
+                }
+
+                /**
+                 * Decode the contents of a node, way, or relation dataset
+                 * and add the object to the buffer if objects of this type
+                 * should be read. Other datasets are ignored.
+                 */
+                void decode_object(o5m_dataset type, const char* data, const char* const end) {
+                    switch (type) {
+                        case o5m_dataset::node:
+                            if (m_read_types & osmium::osm_entity_bits::node) {
+                                decode_node(data, end);
+                                m_buffer.commit();
+                            }
+                            break;
+                        case o5m_dataset::way:
+                            if (m_read_types & osmium::osm_entity_bits::way) {
+                                decode_way(data, end);
+                                m_buffer.commit();
+                            }
+                            break;
+                        case o5m_dataset::relation:
+                            if (m_read_types & osmium::osm_entity_bits::relation) {
+                                decode_relation(data, end);
+                                m_buffer.commit();
+                            }
+                            break;
+                        default:
+                            break;
+                    }
+                }
+
+                /**
+                 * Decode a sequence of complete datasets. Datasets with
+                 * OSM objects are decoded, resets clear the state, all
+                 * other datasets are ignored.
+                 */
+                void decode_datasets(const char* data, const char* const end) {
+                    while (data != end) {
+                        const auto type = o5m_dataset(*data++);
+                        if (type > o5m_dataset::jump) {
+                            if (type == o5m_dataset::reset) {
+                                reset();
+                            }
+                            continue;
+                        }
+
+                        uint64_t length = 0;
+                        try {
+                            length = protozero::decode_varint(&data, end);
+                        } catch (const protozero::end_of_buffer_exception&) {
+                            throw o5m_error{"premature end of file"};
+                        }
+
+                        if (length > uint64_t(end - data)) {
+                            throw o5m_error{"premature end of file"};
+                        }
+
+                        decode_object(type, data, data + length);
+                        data += length;
+                    }
+                }
+
+            }; // class O5mDecoder
+
+            /**
+             * Task decoding a segment of o5m data which starts with fresh
+             * state, ie. at a reset. Run in the thread pool.
+             */
+            class O5mSegmentDecoder {
+
+                std::string m_data;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::memory::BufferPool* m_buffer_pool;
+
+            public:
+
+                O5mSegmentDecoder(std::string&& data, osmium::osm_entity_bits::type read_types, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_data(std::move(data)),
+                    m_read_types(read_types),
+                    m_buffer_pool(buffer_pool) {
+                }
+
+                osmium::memory::Buffer operator()() const {
+                    O5mDecoder decoder{m_data.size() * 4, m_read_types, m_buffer_pool};
+                    decoder.decode_datasets(m_data.data(), m_data.data() + m_data.size());
+                    return decoder.take_buffer();
+                }
+
+            }; // class O5mSegmentDecoder
+
+            /**
+             * The o5m parser splits the input into segments at the reset
+             * datasets. After a reset all state needed for decoding is
+             * cleared, so each segment can be decoded independently in the
+             * thread pool. Futures for the resulting buffers are sent to the
+             * output queue in order.
+             *
+             * If there is no reset for a long time, the data is decoded in
+             * this thread until the next reset.
+             */
+            class O5mParser : public Parser {
+
+                static constexpr int buffer_size = 2 * 1000 * 1000;
+
+                enum constant_segment_size : std::size_t {
+                    // Collect at least this much data into a segment before
+                    // handing it to the pool (if there are enough resets).
+                    min_segment_size = 1024 * 1024,
+
+                    // Decode in this thread if a segment gets this large.
+                    max_segment_size = 4 * 1024 * 1024
+                };
+
+                osmium::io::Header m_header;
+
+                std::string m_input;
+
+                const char* m_data;
+                const char* m_end;
+
+                // The complete datasets collected for the next segment.
+                std::string m_segment;
+
+                // Used for decoding in this thread if there is no reset
+                // for a long time.
+                O5mDecoder m_decoder;
+                bool m_decode_here;
+
+                bool ensure_bytes_available(std::size_t need_bytes) {
+                    if ((m_end - m_data) >= long(need_bytes)) {
+                        return true;
+                    }
+
+                    if (input_done() && (m_input.size() < need_bytes)) {
+                        return false;
+                    }
+
+                    m_input.erase(0, m_data - m_input.data());
+
+                    while (m_input.size() < need_bytes) {
+                        const std::string data{get_input()};
+                        if (input_done()) {
+                            return false;
+                        }
+                        m_input.append(data);
+                    }
+
+                    m_data = m_input.data();
+                    m_end = m_input.data() + m_input.size();
+
+                    return true;
+                }
+
+                void check_header_magic() {
+                    static const unsigned char header_magic[] = { 0xff, 0xe0, 0x04, 'o', '5' };
+
+                    if (std::strncmp(reinterpret_cast<const char*>(header_magic), m_data, sizeof(header_magic))) {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data += sizeof(header_magic);
+                }
+
+                void check_file_type() {
+                    if (*m_data == 'm') {         // o5m data file
+                        m_header.set_has_multiple_object_versions(false);
+                    } else if (*m_data == 'c') {  // o5c change file
+                        m_header.set_has_multiple_object_versions(true);
+                    } else {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data++;
+                }
+
+                void check_file_format_version() {
+                    if (*m_data != '2') {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data++;
+                }
+
+                void decode_header() {
+                    if (! ensure_bytes_available(7)) { // overall length of header
+                        throw o5m_error{"file too short (incomplete header info)"};
+                    }
+
+                    check_header_magic();
+                    check_file_type();
+                    check_file_format_version();
+                }
+
+                void mark_header_as_done() {
+                    set_header_value(m_header);
+                }
+
                 void decode_bbox(const char* data, const char* const end) {
-                    auto sw_lon = zvarint(&data, end);
-                    auto sw_lat = zvarint(&data, end);
-                    auto ne_lon = zvarint(&data, end);
-                    auto ne_lat = zvarint(&data, end);
+                    auto sw_lon = o5m_decode_zvarint(&data, end);
+                    auto sw_lat = o5m_decode_zvarint(&data, end);
+                    auto ne_lon = o5m_decode_zvarint(&data, end);
+                    auto ne_lat = o5m_decode_zvarint(&data, end);
 
                     m_header.add_box(osmium::Box{osmium::Location{sw_lon, sw_lat},
                                                  osmium::Location{ne_lon, ne_lat}});
                 }
 
                 void decode_timestamp(const char* data, const char* const end) {
-                    auto timestamp = osmium::Timestamp(zvarint(&data, end)).to_iso();
+                    auto timestamp = osmium::Timestamp(o5m_decode_zvarint(&data, end)).to_iso();
                     m_header.set("o5m_timestamp", timestamp);
                     m_header.set("timestamp", timestamp);
                 }
 
-                void flush() {
-                    osmium::memory::Buffer buffer(buffer_size);
-                    using std::swap;
-                    swap(m_buffer, buffer);
-                    send_to_output_queue(std::move(buffer));
-                }
-
-                enum class dataset_type : unsigned char {
-                    node         = 0x10,
-                    way          = 0x11,
-                    relation     = 0x12,
-                    bounding_box = 0xdb,
-                    timestamp    = 0xdc,
-                    header       = 0xe0,
-                    sync         = 0xee,
-                    jump         = 0xef,
-                    reset        = 0xff
-                };
+                void submit_segment() {
+                    if (!m_segment.empty()) {
+                        send_to_output_queue(get_pool().submit(O5mSegmentDecoder{std::move(m_segment), read_types(), buffer_pool()}));
+                        m_segment.clear();
+                    }
+                }
+
+                void flush_decoded() {
+                    if (m_decoder.buffer().committed() > 0) {
+                        send_to_output_queue(m_decoder.take_buffer(buffer_size));
+                    }
+                }
+
+                void add_object(o5m_dataset type, std::size_t length) {
+                    if (m_decode_here) {
+                        m_decoder.decode_object(type, m_data, m_data + length);
+                        if (m_decoder.buffer().committed() > buffer_size / 10 * 9) {
+                            flush_decoded();
+                        }
+                        return;
+                    }
+
+                    m_segment += static_cast<char>(type);
+                    o5m_append_varint(m_segment, length);
+                    m_segment.append(m_data, length);
+
+                    if (m_segment.size() > max_segment_size) {
+                        // The segment starts with fresh state, so it can
+                        // be decoded here, too. Go on decoding here until
+                        // the next reset.
+                        m_decoder.reset();
+                        m_decoder.decode_datasets(m_segment.data(), m_segment.data() + m_segment.size());
+                        m_segment.clear();
+                        m_decode_here = true;
+                        flush_decoded();
+                    }
+                }
+
+                void reset() {
+                    if (m_decode_here) {
+                        flush_decoded();
+                        m_decode_here = false;
+                    } else if (m_segment.size() >= min_segment_size) {
+                        submit_segment();
+                    }
+                    if (!m_segment.empty()) {
+                        m_segment += static_cast<char>(o5m_dataset::reset);
+                    }
+                }
 
                 void decode_data() {
                     while (ensure_bytes_available(1)) {
-                        dataset_type ds_type = dataset_type(*m_data++);
-                        if (ds_type > dataset_type::jump) {
-                            if (ds_type == dataset_type::reset) {
+                        const auto ds_type = o5m_dataset(*m_data++);
+                        if (ds_type > o5m_dataset::jump) {
+                            if (ds_type == o5m_dataset::reset) {
                                 reset();
                             }
                         } else {
@@ -536,31 +707,28 @@ namespace osmium {
                             }
 
                             switch (ds_type) {
-                                case dataset_type::node:
+                                case o5m_dataset::node:
                                     mark_header_as_done();
                                     if (read_types() & osmium::osm_entity_bits::node) {
-                                        decode_node(m_data, m_data + length);
-                                        m_buffer.commit();
+                                        add_object(ds_type, length);
                                     }
                                     break;
-                                case dataset_type::way:
+                                case o5m_dataset::way:
                                     mark_header_as_done();
                                     if (read_types() & osmium::osm_entity_bits::way) {
-                                        decode_way(m_data, m_data + length);
-                                        m_buffer.commit();
+                                        add_object(ds_type, length);
                                     }
                                     break;
-                                case dataset_type::relation:
+                                case o5m_dataset::relation:
                                     mark_header_as_done();
                                     if (read_types() & osmium::osm_entity_bits::relation) {
-                                        decode_relation(m_data, m_data + length);
-                                        m_buffer.commit();
+                                        add_object(ds_type, length);
                                     }
                                     break;
-                                case dataset_type::bounding_box:
+                                case o5m_dataset::bounding_box:
                                     decode_bbox(m_data, m_data + length);
                                     break;
-                                case dataset_type::timestamp:
+                                case o5m_dataset::timestamp:
                                     decode_timestamp(m_data, m_data + length);
                                     break;
                                 default:
@@ -573,15 +741,13 @@ namespace osmium {
                             }
 
                             m_data += length;
-
-                            if (m_buffer.committed() > buffer_size / 10 * 9) {
-                                flush();
-                            }
                         }
                     }
 
-                    if (m_buffer.committed()) {
-                        flush();
+                    if (m_decode_here) {
+                        flush_decoded();
+                    } else {
+                        submit_segment();
                     }
 
                     mark_header_as_done();
@@ -592,10 +758,12 @@ namespace osmium {
                 explicit O5mParser(parser_arguments& args) :
                     Parser(args),
                     m_header(),
-                    m_buffer(buffer_size),
                     m_input(),
                     m_data(m_input.data()),
-                    m_end(m_data) {
+                    m_end(m_data),
+                    m_segment(),
+                    m_decoder(buffer_size, args.read_which_entities, args.buffer_pool),
+                    m_decode_here(false) {
                 }
 
                 ~O5mParser() noexcept final = default;
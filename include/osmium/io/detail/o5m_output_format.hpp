@@ -0,0 +1,370 @@
+#ifndef OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <osmium/io/detail/o5m.hpp>
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/delta.hpp>
+#include <osmium/visitor.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            struct o5m_output_options {
+
+                /// Should metadata of objects be added?
+                bool add_metadata;
+
+            };
+
+            /**
+             * Writes out one buffer with OSM data in o5m format. Each block
+             * starts with a reset, so the string table and the delta
+             * encoding start from scratch and blocks can be encoded
+             * independently of each other.
+             */
+            class O5mOutputBlock : public OutputBlock {
+
+                // The following settings are from the o5m description
+                // and must be the same as in the ReferenceTable used by
+                // the O5mParser.
+
+                // The maximum number of entries in the string table.
+                static constexpr const uint64_t number_of_entries = 15000;
+
+                // The maximum length of a string in the table including
+                // two \0 bytes.
+                static constexpr const std::size_t max_length = 250 + 2;
+
+                o5m_output_options m_options;
+
+                // Maps strings in the table to their position (the number
+                // of strings added before them).
+                std::unordered_map<std::string, uint64_t> m_string_table;
+                uint64_t m_strings_added = 0;
+
+                osmium::item_type m_last_type = osmium::item_type::undefined;
+
+                osmium::util::DeltaEncode<osmium::object_id_type> m_delta_id;
+
+                osmium::util::DeltaEncode<int64_t> m_delta_timestamp;
+                osmium::util::DeltaEncode<osmium::changeset_id_type> m_delta_changeset;
+                osmium::util::DeltaEncode<int64_t> m_delta_lon;
+                osmium::util::DeltaEncode<int64_t> m_delta_lat;
+
+                osmium::util::DeltaEncode<osmium::object_id_type> m_delta_way_node_id;
+                osmium::util::DeltaEncode<osmium::object_id_type> m_delta_member_ids[3];
+
+                // Data of the dataset currently being encoded.
+                std::string m_data;
+
+                // References (way nodes or relation members) of the
+                // dataset currently being encoded.
+                std::string m_refs;
+
+                std::string m_string;
+
+                void reset() {
+                    *m_out += static_cast<char>(o5m_dataset::reset);
+
+                    m_string_table.clear();
+                    m_strings_added = 0;
+
+                    m_delta_id.clear();
+                    m_delta_timestamp.clear();
+                    m_delta_changeset.clear();
+                    m_delta_lon.clear();
+                    m_delta_lat.clear();
+
+                    m_delta_way_node_id.clear();
+                    m_delta_member_ids[0].clear();
+                    m_delta_member_ids[1].clear();
+                    m_delta_member_ids[2].clear();
+                }
+
+                // Write the string (which contains the terminating \0
+                // bytes) as reference into the string table if possible or
+                // inline otherwise.
+                void write_string(std::string& out, const std::string& str) {
+                    const auto it = m_string_table.find(str);
+                    if (it != m_string_table.end() && m_strings_added - it->second <= number_of_entries) {
+                        o5m_append_varint(out, m_strings_added - it->second);
+                        return;
+                    }
+
+                    out += '\0';
+                    out += str;
+                    if (str.size() <= max_length) {
+                        m_string_table[str] = m_strings_added++;
+                    }
+                }
+
+                void write_user(const osmium::OSMObject& object) {
+                    if (object.uid() == 0) {
+                        // Anonymous user: The decoder puts an entry into
+                        // the string table, but it can't be referenced.
+                        m_data.append(3, '\0');
+                        ++m_strings_added;
+                        return;
+                    }
+                    m_string.clear();
+                    o5m_append_varint(m_string, object.uid());
+                    m_string += '\0';
+                    m_string += object.user();
+                    m_string += '\0';
+                    write_string(m_data, m_string);
+                }
+
+                void write_info(const osmium::OSMObject& object) {
+                    if (!m_options.add_metadata || object.version() == 0) {
+                        m_data += '\0';
+                        return;
+                    }
+
+                    o5m_append_varint(m_data, object.version());
+                    const auto timestamp = static_cast<int64_t>(uint32_t(object.timestamp()));
+                    o5m_append_zvarint(m_data, m_delta_timestamp.update(timestamp));
+                    if (timestamp != 0) {
+                        o5m_append_zvarint(m_data, m_delta_changeset.update(object.changeset()));
+                        write_user(object);
+                    }
+                }
+
+                void write_tags(const osmium::TagList& tags) {
+                    for (const auto& tag : tags) {
+                        m_string.assign(tag.key());
+                        m_string += '\0';
+                        m_string += tag.value();
+                        m_string += '\0';
+                        write_string(m_data, m_string);
+                    }
+                }
+
+                // Start a new object. The id is delta encoded over all
+                // object types, but we write a reset whenever the type
+                // changes, like other programs writing o5m do.
+                void start_object(const osmium::OSMObject& object) {
+                    if (object.type() != m_last_type) {
+                        if (m_last_type != osmium::item_type::undefined) {
+                            reset();
+                        }
+                        m_last_type = object.type();
+                    }
+                    m_data.clear();
+                    o5m_append_zvarint(m_data, m_delta_id.update(object.id()));
+                    write_info(object);
+                }
+
+                void write_refs() {
+                    o5m_append_varint(m_data, m_refs.size());
+                    m_data += m_refs;
+                }
+
+            public:
+
+                O5mOutputBlock(osmium::memory::Buffer&& buffer, const o5m_output_options& options, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    OutputBlock(std::move(buffer), buffer_pool),
+                    m_options(options) {
+                }
+
+                std::string operator()() {
+                    reset();
+                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+                    m_input_buffer.reset();
+
+                    std::string out;
+                    using std::swap;
+                    swap(out, *m_out);
+
+                    return out;
+                }
+
+                void node(const osmium::Node& node) {
+                    start_object(node);
+
+                    // Deleted nodes have no location section.
+                    if (node.visible()) {
+                        o5m_append_zvarint(m_data, m_delta_lon.update(node.location().x()));
+                        o5m_append_zvarint(m_data, m_delta_lat.update(node.location().y()));
+                        write_tags(node.tags());
+                    }
+
+                    o5m_append_dataset(*m_out, o5m_dataset::node, m_data);
+                }
+
+                void way(const osmium::Way& way) {
+                    start_object(way);
+
+                    // Deleted ways have no reference section.
+                    if (way.visible()) {
+                        m_refs.clear();
+                        for (const auto& node_ref : way.nodes()) {
+                            o5m_append_zvarint(m_refs, m_delta_way_node_id.update(node_ref.ref()));
+                        }
+                        write_refs();
+                        write_tags(way.tags());
+                    }
+
+                    o5m_append_dataset(*m_out, o5m_dataset::way, m_data);
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    start_object(relation);
+
+                    // Deleted relations have no reference section.
+                    if (relation.visible()) {
+                        m_refs.clear();
+                        for (const auto& member : relation.members()) {
+                            const auto index = osmium::item_type_to_nwr_index(member.type());
+                            o5m_append_zvarint(m_refs, m_delta_member_ids[index].update(member.ref()));
+                            m_string.assign(1, static_cast<char>('0' + index));
+                            m_string += member.role();
+                            m_string += '\0';
+                            write_string(m_refs, m_string);
+                        }
+                        write_refs();
+                        write_tags(relation.tags());
+                    }
+
+                    o5m_append_dataset(*m_out, o5m_dataset::relation, m_data);
+                }
+
+            }; // class O5mOutputBlock
+
+            class O5mOutputFormat : public osmium::io::detail::OutputFormat {
+
+                o5m_output_options m_options;
+
+                bool m_change_format;
+
+            public:
+
+                O5mOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue),
+                    m_options(),
+                    m_change_format(file.is_true("o5c_change_format")) {
+                    m_options.add_metadata = file.is_not_false("add_metadata");
+                }
+
+                O5mOutputFormat(const O5mOutputFormat&) = delete;
+                O5mOutputFormat& operator=(const O5mOutputFormat&) = delete;
+
+                ~O5mOutputFormat() noexcept final = default;
+
+                void write_header(const osmium::io::Header& header) final {
+                    std::string out;
+                    out += static_cast<char>(o5m_dataset::reset);
+                    o5m_append_dataset(out, o5m_dataset::header, m_change_format ? "o5c2" : "o5m2");
+
+                    std::string data;
+                    const std::string timestamp{header.get("o5m_timestamp", header.get("timestamp"))};
+                    if (!timestamp.empty()) {
+                        try {
+                            o5m_append_zvarint(data, uint32_t(osmium::Timestamp{timestamp}));
+                            o5m_append_dataset(out, o5m_dataset::timestamp, data);
+                        } catch (const std::invalid_argument&) {
+                            // ignore timestamps we can't parse
+                        }
+                    }
+
+                    for (const auto& box : header.boxes()) {
+                        if (box.valid()) {
+                            data.clear();
+                            o5m_append_zvarint(data, box.bottom_left().x());
+                            o5m_append_zvarint(data, box.bottom_left().y());
+                            o5m_append_zvarint(data, box.top_right().x());
+                            o5m_append_zvarint(data, box.top_right().y());
+                            o5m_append_dataset(out, o5m_dataset::bounding_box, data);
+                        }
+                    }
+
+                    send_to_output_queue(std::move(out));
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    m_output_queue.push(m_pool.submit(O5mOutputBlock{std::move(buffer), m_options, m_buffer_pool}));
+                }
+
+                void write_end() final {
+                    send_to_output_queue(std::string(1, static_cast<char>(o5m_dataset::end_of_file)));
+                }
+
+            }; // class O5mOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_o5m_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::o5m,
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::O5mOutputFormat(pool, file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_o5m_output() noexcept {
+                return registered_o5m_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
@@ -33,16 +33,22 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstddef>
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/opl_parser_functions.hpp>
+#include <osmium/io/detail/string_scan.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 
 namespace osmium {
@@ -63,9 +69,12 @@ namespace osmium {
                     std::string input{worker.get_input()};
                     std::string::size_type ppos = 0;
 
+                    const char* const begin = input.data();
+                    const char* const end = begin + input.size();
+
                     if (!rest.empty()) {
-                        ppos = input.find_first_of("\n\r");
-                        if (ppos == std::string::npos) {
+                        ppos = find_first_of_in_range<'\n', '\r'>(begin, end) - begin;
+                        if (ppos == input.size()) {
                             rest.append(input);
                             continue;
                         }
@@ -77,9 +86,9 @@ namespace osmium {
                         ++ppos;
                     }
 
-                    for (auto pos = input.find_first_of("\n\r", ppos);
-                         pos != std::string::npos;
-                         pos = input.find_first_of("\n\r", ppos)) {
+                    for (std::string::size_type pos = find_first_of_in_range<'\n', '\r'>(begin + ppos, end) - begin;
+                         pos != input.size();
+                         pos = find_first_of_in_range<'\n', '\r'>(begin + ppos, end) - begin) {
                         const char* data = &input[ppos];
                         input[pos] = '\0';
                         if (data[0] != '\0') {
@@ -98,21 +107,119 @@ namespace osmium {
                 }
             }
 
-            class OPLParser : public Parser {
+            // Feed data coming in blocks to the worker in chunks of at
+            // least chunk_size bytes (if there is enough data) that end at
+            // a line boundary. Only the last chunk might not end with a
+            // newline.
+            template <typename T>
+            void chunk_by_lines(T& worker, std::size_t chunk_size) {
+                std::string chunk;
 
-                osmium::memory::Buffer m_buffer{1024*1024};
-                uint64_t m_line_count = 0;
+                while (!worker.input_done()) {
+                    std::string input{worker.get_input()};
+                    if (chunk.empty()) {
+                        chunk = std::move(input);
+                    } else {
+                        chunk.append(input);
+                    }
 
-                void maybe_flush() {
-                    if (m_buffer.committed() > 800*1024) {
-                        osmium::memory::Buffer buffer{1024*1024};
-                        using std::swap;
-                        swap(m_buffer, buffer);
-                        send_to_output_queue(std::move(buffer));
+                    if (chunk.size() < chunk_size) {
+                        continue;
+                    }
 
+                    const auto pos = chunk.find_last_of("\n\r");
+                    if (pos == std::string::npos) {
+                        continue;
                     }
+
+                    std::string rest{chunk, pos + 1};
+                    chunk.resize(pos + 1);
+                    worker.parse_chunk(std::move(chunk));
+                    chunk = std::move(rest);
                 }
 
+                if (!chunk.empty()) {
+                    worker.parse_chunk(std::move(chunk));
+                }
+            }
+
+            // Count the non-empty lines in the data. Lines end with \n or
+            // \r, so this counts lines the same way line_by_line() does.
+            inline uint64_t count_opl_lines(const std::string& data) noexcept {
+                uint64_t count = 0;
+                bool in_line = false;
+                for (const char c : data) {
+                    if (c == '\n' || c == '\r') {
+                        in_line = false;
+                    } else if (!in_line) {
+                        in_line = true;
+                        ++count;
+                    }
+                }
+                return count;
+            }
+
+            /**
+             * Parses a chunk of OPL data consisting of complete lines into
+             * a buffer. These are the tasks run in the thread pool.
+             */
+            class OPLChunkParser {
+
+                std::string m_data;
+                uint64_t m_line_count;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::memory::Buffer m_buffer;
+                osmium::memory::BufferPool* m_buffer_pool;
+                bool m_done = false;
+
+            public:
+
+                OPLChunkParser(std::string&& data, uint64_t first_line, osmium::osm_entity_bits::type read_types, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_data(std::move(data)),
+                    m_line_count(first_line),
+                    m_read_types(read_types),
+                    m_buffer(),
+                    m_buffer_pool(buffer_pool) {
+                }
+
+                bool input_done() const noexcept {
+                    return m_done;
+                }
+
+                std::string get_input() {
+                    m_done = true;
+                    return std::move(m_data);
+                }
+
+                void parse_line(const char* data) {
+                    opl_parse_line(m_line_count, data, m_buffer, m_read_types);
+                    ++m_line_count;
+                }
+
+                osmium::memory::Buffer operator()() {
+                    m_buffer = osmium::memory::detail::get_buffer(m_buffer_pool, m_data.size() + 1024);
+                    line_by_line(*this);
+                    return std::move(m_buffer);
+                }
+
+            }; // class OPLChunkParser
+
+            /**
+             * The OPL parser splits the input into chunks of complete
+             * lines and parses them in the thread pool. The resulting
+             * buffers are sent to the output queue as futures, so they
+             * stay in order.
+             */
+            class OPLParser : public Parser {
+
+                // Chunks of OPL data parsed by one task in the pool will
+                // be at least this large (except for the last one).
+                enum constant_chunk_size : std::size_t {
+                    chunk_size = 1024 * 1024
+                };
+
+                uint64_t m_line_count = 0;
+
             public:
 
                 explicit OPLParser(parser_arguments& args) :
@@ -122,21 +229,16 @@ namespace osmium {
 
                 ~OPLParser() noexcept final = default;
 
-                void parse_line(const char* data) {
-                    if (opl_parse_line(m_line_count, data, m_buffer, read_types())) {
-                        maybe_flush();
-                    }
-                    ++m_line_count;
+                void parse_chunk(std::string&& chunk) {
+                    const uint64_t first_line = m_line_count;
+                    m_line_count += count_opl_lines(chunk);
+                    send_to_output_queue(get_pool().submit(OPLChunkParser{std::move(chunk), first_line, read_types(), buffer_pool()}));
                 }
 
                 void run() final {
                     osmium::thread::set_thread_name("_osmium_opl_in");
 
-                    line_by_line(*this);
-
-                    if (m_buffer.committed() > 0) {
-                        send_to_output_queue(std::move(m_buffer));
-                    }
+                    chunk_by_lines(*this, chunk_size);
                 }
 
             }; // class OPLParser
@@ -98,7 +98,7 @@ namespace osmium {
 
                 void write_field_timestamp(char c, const osmium::Timestamp& timestamp) {
                     *m_out += c;
-                    *m_out += timestamp.to_iso();
+                    timestamp.to_iso(std::back_inserter(*m_out));
                 }
 
                 void write_tags(const osmium::TagList& tags) {
@@ -162,13 +162,14 @@ namespace osmium {
 
             public:
 
-                OPLOutputBlock(osmium::memory::Buffer&& buffer, const opl_output_options& options) :
-                    OutputBlock(std::move(buffer)),
+                OPLOutputBlock(osmium::memory::Buffer&& buffer, const opl_output_options& options, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    OutputBlock(std::move(buffer), buffer_pool),
                     m_options(options) {
                 }
 
                 std::string operator()() {
                     osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+                    m_input_buffer.reset();
 
                     std::string out;
                     using std::swap;
@@ -290,7 +291,7 @@ namespace osmium {
                 ~OPLOutputFormat() noexcept final = default;
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(OPLOutputBlock{std::move(buffer), m_options}));
+                    m_output_queue.push(m_pool.submit(OPLOutputBlock{std::move(buffer), m_options, m_buffer_pool}));
                 }
 
             }; // class OPLOutputFormat
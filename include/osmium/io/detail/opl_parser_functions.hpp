@@ -43,6 +43,7 @@ DEALINGS IN THE SOFTWARE.
 #include <utf8.h>
 
 #include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/detail/string_scan.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/box.hpp>
@@ -132,12 +133,25 @@ namespace osmium {
              * string.
              */
             inline const char* opl_skip_section(const char** s) noexcept {
-                while (opl_non_empty(*s)) {
-                    ++*s;
-                }
+                *s = find_first_of_or_end<' ', '\t'>(*s);
                 return *s;
             }
 
+            /**
+             * Get value of hex digit or -1 if c is not a hex digit.
+             */
+            inline int opl_hex_value(const char c) noexcept {
+                const unsigned int digit = static_cast<unsigned char>(c) - '0';
+                if (digit < 10) {
+                    return static_cast<int>(digit);
+                }
+                const unsigned int letter = (static_cast<unsigned char>(c) | 0x20u) - 'a';
+                if (letter < 6) {
+                    return static_cast<int>(letter) + 10;
+                }
+                return -1;
+            }
+
             /**
              * Parse OPL-escaped strings with hex code with a '%' at the end.
              * Appends resulting unicode character to the result string.
@@ -159,16 +173,11 @@ namespace osmium {
                         *data = s;
                         return;
                     }
-                    value <<= 4;
-                    if (*s >= '0' && *s <= '9') {
-                        value += *s - '0';
-                    } else if (*s >= 'a' && *s <= 'f') {
-                        value += *s - 'a' + 10;
-                    } else if (*s >= 'A' && *s <= 'F') {
-                        value += *s - 'A' + 10;
-                    } else {
+                    const int digit = opl_hex_value(*s);
+                    if (digit < 0) {
                         throw opl_error{"not a hex char", s};
                     }
+                    value = (value << 4) | static_cast<uint32_t>(digit);
                     ++s;
                 }
                 throw opl_error{"hex escape too long", s};
@@ -185,15 +194,14 @@ namespace osmium {
             inline void opl_parse_string(const char** data, std::string& result) {
                 const char* s = *data;
                 while (true) {
-                    if (*s == '\0' || *s == ' ' || *s == '\t' || *s == ',' || *s == '=') {
+                    const char* end = find_first_of_or_end<' ', '\t', ',', '=', '%'>(s);
+                    result.append(s, end);
+                    s = end;
+                    if (*s != '%') {
                         break;
-                    } else if (*s == '%') {
-                        ++s;
-                        opl_parse_escaped(&s, result);
-                    } else {
-                        result += *s;
-                        ++s;
                     }
+                    ++s;
+                    opl_parse_escaped(&s, result);
                 }
                 *data = s;
             }
@@ -46,6 +46,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/thread/pool.hpp>
 
 namespace osmium {
@@ -62,12 +63,15 @@ namespace osmium {
 
             protected:
 
+                // Derived classes reset this as soon as they are done with
+                // it, so the buffer is back in the buffer pool (if there is
+                // one) before the output is written.
                 std::shared_ptr<osmium::memory::Buffer> m_input_buffer;
 
                 std::shared_ptr<std::string> m_out;
 
-                explicit OutputBlock(osmium::memory::Buffer&& buffer) :
-                    m_input_buffer(std::make_shared<osmium::memory::Buffer>(std::move(buffer))),
+                explicit OutputBlock(osmium::memory::Buffer&& buffer, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_input_buffer(osmium::memory::detail::share_buffer(buffer_pool, std::move(buffer))),
                     m_out(std::make_shared<std::string>()) {
                 }
 
@@ -111,6 +115,10 @@ namespace osmium {
                 osmium::thread::Pool& m_pool;
                 future_string_queue_type& m_output_queue;
 
+                // If this is set, buffers are put back into this pool
+                // after they have been written.
+                osmium::memory::BufferPool* m_buffer_pool = nullptr;
+
                 /**
                  * Wrap the string into a future and add it to the output
                  * queue.
@@ -134,6 +142,10 @@ namespace osmium {
 
                 virtual ~OutputFormat() noexcept = default;
 
+                void set_buffer_pool(osmium::memory::BufferPool* buffer_pool) noexcept {
+                    m_buffer_pool = buffer_pool;
+                }
+
                 virtual void write_header(const osmium::io::Header&) {
                 }
 
@@ -214,7 +226,10 @@ namespace osmium {
 
                 ~BlackholeOutputFormat() noexcept final = default;
 
-                void write_buffer(osmium::memory::Buffer&& /*buffer*/) final {
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    if (m_buffer_pool) {
+                        m_buffer_pool->put(std::move(buffer));
+                    }
                 }
 
             }; // class BlackholeOutputFormat
@@ -33,7 +33,9 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 // needed for htonl and ntohl or their equivalent in protozero
@@ -43,7 +45,10 @@ DEALINGS IN THE SOFTWARE.
 # include <protozero/byteswap.hpp>
 #endif
 
+#include <protozero/types.hpp>
+
 #include <osmium/io/error.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/location.hpp>
 
 namespace osmium {
@@ -80,6 +85,86 @@ namespace osmium {
 
             const int64_t resolution_convert = lonlat_resolution / osmium::detail::coordinate_precision;
 
+            /**
+             * Get the length of a BlobHeader from the 4 bytes in network
+             * byte order in front of it.
+             */
+            inline uint32_t decode_blob_header_size(const char* data) noexcept {
+                uint32_t size_in_network_byte_order;
+                std::memcpy(&size_in_network_byte_order, data, sizeof(size_in_network_byte_order));
+
+                #ifndef _WIN32
+                return ntohl(size_in_network_byte_order);
+                #else
+                protozero::detail::byteswap_inplace(&size_in_network_byte_order);
+                return size_in_network_byte_order;
+                #endif
+            }
+
+            /**
+             * Osmium writes a marker into the (otherwise unused) indexdata
+             * field of the BlobHeader of each OSMData blob. It tells readers
+             * which types of OSM entities are in the blob, so they can skip
+             * blobs they are not interested in without decompressing them.
+             * The marker consists of this prefix followed by one character
+             * for each entity type in the blob ('n', 'w', 'r', or 'c').
+             */
+            constexpr const char* blob_types_marker_prefix = "osmium:";
+            constexpr const std::size_t blob_types_marker_prefix_size = 7;
+
+            inline std::string encode_blob_types_marker(osmium::osm_entity_bits::type types) {
+                std::string marker{blob_types_marker_prefix};
+                if (types & osmium::osm_entity_bits::node) {
+                    marker += 'n';
+                }
+                if (types & osmium::osm_entity_bits::way) {
+                    marker += 'w';
+                }
+                if (types & osmium::osm_entity_bits::relation) {
+                    marker += 'r';
+                }
+                if (types & osmium::osm_entity_bits::changeset) {
+                    marker += 'c';
+                }
+                return marker;
+            }
+
+            /**
+             * Decode the marker written by encode_blob_types_marker().
+             *
+             * @returns The entity types in the blob or
+             *          osmium::osm_entity_bits::nothing if there is no
+             *          valid marker, ie. if the types are unknown.
+             */
+            inline osmium::osm_entity_bits::type decode_blob_types_marker(const protozero::data_view& data) noexcept {
+                if (data.size() <= blob_types_marker_prefix_size ||
+                    std::strncmp(data.data(), blob_types_marker_prefix, blob_types_marker_prefix_size)) {
+                    return osmium::osm_entity_bits::nothing;
+                }
+
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+                for (std::size_t i = blob_types_marker_prefix_size; i < data.size(); ++i) {
+                    switch (data.data()[i]) {
+                        case 'n':
+                            types |= osmium::osm_entity_bits::node;
+                            break;
+                        case 'w':
+                            types |= osmium::osm_entity_bits::way;
+                            break;
+                        case 'r':
+                            types |= osmium::osm_entity_bits::relation;
+                            break;
+                        case 'c':
+                            types |= osmium::osm_entity_bits::changeset;
+                            break;
+                        default:
+                            return osmium::osm_entity_bits::nothing;
+                    }
+                }
+
+                return types;
+            }
+
         } // namespace detail
 
     } // namespace io
@@ -47,12 +47,20 @@ DEALINGS IN THE SOFTWARE.
 #include <protozero/types.hpp>
 
 #include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/detail/mapped_input_file.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/detail/zlib.hpp>
+#ifdef OSMIUM_WITH_LZ4
+# include <osmium/io/detail/lz4.hpp>
+#endif
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
@@ -93,7 +101,7 @@ namespace osmium {
 
                 osmium::osm_entity_bits::type m_read_types;
 
-                osmium::memory::Buffer m_buffer { initial_buffer_size };
+                osmium::memory::Buffer m_buffer;
 
                 osmium::io::read_meta m_read_metadata;
 
@@ -689,9 +697,10 @@ namespace osmium {
 
             public:
 
-                PBFPrimitiveBlockDecoder(const data_view& data, osmium::osm_entity_bits::type read_types, osmium::io::read_meta read_metadata) :
+                PBFPrimitiveBlockDecoder(const data_view& data, osmium::osm_entity_bits::type read_types, osmium::io::read_meta read_metadata, osmium::memory::BufferPool* buffer_pool = nullptr) :
                     m_data(data),
                     m_read_types(read_types),
+                    m_buffer(osmium::memory::detail::get_buffer(buffer_pool, initial_buffer_size)),
                     m_read_metadata(read_metadata) {
                 }
 
@@ -716,9 +725,62 @@ namespace osmium {
 
             }; // class PBFPrimitiveBlockDecoder
 
-            inline data_view decode_blob(const std::string& blob_data, std::string& output) {
+            struct pbf_blob_header_info {
+
+                // Size of the Blob following the BlobHeader.
+                size_t datasize;
+
+                // Types of OSM entities in the blob as given by the marker
+                // in the indexdata field or osmium::osm_entity_bits::nothing
+                // if they are not known.
+                osmium::osm_entity_bits::type types;
+
+            }; // struct pbf_blob_header_info
+
+            /**
+             * Decode the BlobHeader. Make sure it contains the expected
+             * type. Return the size of the following Blob and the entity
+             * types in it if the header has that information.
+             *
+             * @throws osmium::pbf_error If the header is invalid
+             */
+            inline pbf_blob_header_info decode_blob_header(const data_view& data, const char* expected_type) {
+                protozero::pbf_message<FileFormat::BlobHeader> pbf_blob_header{data};
+                protozero::data_view blob_header_type;
+                size_t blob_header_datasize = 0;
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+                while (pbf_blob_header.next()) {
+                    switch (pbf_blob_header.tag()) {
+                        case FileFormat::BlobHeader::required_string_type:
+                            blob_header_type = pbf_blob_header.get_view();
+                            break;
+                        case FileFormat::BlobHeader::optional_bytes_indexdata:
+                            types = decode_blob_types_marker(pbf_blob_header.get_view());
+                            break;
+                        case FileFormat::BlobHeader::required_int32_datasize:
+                            blob_header_datasize = pbf_blob_header.get_int32();
+                            break;
+                        default:
+                            pbf_blob_header.skip();
+                    }
+                }
+
+                if (blob_header_datasize == 0) {
+                    throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
+                }
+
+                if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size())) {
+                    throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                }
+
+                return pbf_blob_header_info{blob_header_datasize, types};
+            }
+
+            inline data_view decode_blob(const data_view& blob_data, std::string& output) {
                 int32_t raw_size = 0;
-                protozero::data_view zlib_data;
+                protozero::data_view compressed_data;
+                FileFormat::Blob compression = FileFormat::Blob::optional_bytes_raw;
 
                 protozero::pbf_message<FileFormat::Blob> pbf_blob{blob_data};
                 while (pbf_blob.next()) {
@@ -738,7 +800,10 @@ namespace osmium {
                             }
                             break;
                         case FileFormat::Blob::optional_bytes_zlib_data:
-                            zlib_data = pbf_blob.get_view();
+                        case FileFormat::Blob::optional_bytes_lz4_data:
+                        case FileFormat::Blob::optional_bytes_zstd_data:
+                            compression = pbf_blob.tag();
+                            compressed_data = pbf_blob.get_view();
                             break;
                         case FileFormat::Blob::optional_bytes_lzma_data:
                             throw osmium::pbf_error{"lzma blobs not implemented"};
@@ -747,16 +812,81 @@ namespace osmium {
                     }
                 }
 
-                if (!zlib_data.empty() && raw_size != 0) {
-                    return osmium::io::detail::zlib_uncompress_string(
-                        zlib_data.data(),
-                        static_cast<unsigned long>(zlib_data.size()),
-                        static_cast<unsigned long>(raw_size),
-                        output
-                    );
+                if (compressed_data.empty() || raw_size == 0) {
+                    throw osmium::pbf_error{"blob contains no data"};
+                }
+
+                switch (compression) {
+                    case FileFormat::Blob::optional_bytes_zlib_data:
+                        return osmium::io::detail::zlib_uncompress_string(
+                            compressed_data.data(),
+                            static_cast<unsigned long>(compressed_data.size()),
+                            static_cast<unsigned long>(raw_size),
+                            output
+                        );
+                    case FileFormat::Blob::optional_bytes_lz4_data:
+#ifdef OSMIUM_WITH_LZ4
+                        return osmium::io::detail::lz4_uncompress_string(
+                            compressed_data.data(),
+                            compressed_data.size(),
+                            static_cast<std::size_t>(raw_size),
+                            output
+                        );
+#else
+                        throw osmium::pbf_error{"lz4 blobs not supported (compile with OSMIUM_WITH_LZ4)"};
+#endif
+                    case FileFormat::Blob::optional_bytes_zstd_data:
+#ifdef OSMIUM_WITH_ZSTD
+                        return osmium::io::detail::zstd_uncompress_string(
+                            compressed_data.data(),
+                            compressed_data.size(),
+                            static_cast<std::size_t>(raw_size),
+                            output
+                        );
+#else
+                        throw osmium::pbf_error{"zstd blobs not supported (compile with OSMIUM_WITH_ZSTD)"};
+#endif
+                    default:
+                        break;
                 }
 
-                throw osmium::pbf_error{"blob contains no data"};
+                throw osmium::pbf_error{"unknown compression"};
+            }
+
+            /**
+             * Find out which types of OSM entities are in an (uncompressed)
+             * PrimitiveBlock. Only the PrimitiveGroups are looked at, the
+             * entities themselves are not decoded.
+             */
+            inline osmium::osm_entity_bits::type primitive_block_entity_types(const data_view& data) {
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+                protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
+                while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup)) {
+                    protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                    while (pbf_primitive_group.next()) {
+                        switch (pbf_primitive_group.tag()) {
+                            case OSMFormat::PrimitiveGroup::repeated_Node_nodes:
+                            case OSMFormat::PrimitiveGroup::optional_DenseNodes_dense:
+                                types |= osmium::osm_entity_bits::node;
+                                break;
+                            case OSMFormat::PrimitiveGroup::repeated_Way_ways:
+                                types |= osmium::osm_entity_bits::way;
+                                break;
+                            case OSMFormat::PrimitiveGroup::repeated_Relation_relations:
+                                types |= osmium::osm_entity_bits::relation;
+                                break;
+                            case OSMFormat::PrimitiveGroup::repeated_ChangeSet_changesets:
+                                types |= osmium::osm_entity_bits::changeset;
+                                break;
+                            default:
+                                break;
+                        }
+                        pbf_primitive_group.skip();
+                    }
+                }
+
+                return types;
             }
 
             inline osmium::Box decode_header_bbox(const data_view& data) {
@@ -859,7 +989,7 @@ namespace osmium {
              * @returns Header object
              * @throws osmium::pbf_error If there was a parsing error
              */
-            inline osmium::io::Header decode_header(const std::string& header_block_data) {
+            inline osmium::io::Header decode_header(const data_view& header_block_data) {
                 std::string output;
 
                 return decode_header_block(decode_blob(header_block_data, output));
@@ -867,21 +997,43 @@ namespace osmium {
 
             class PBFDataBlobDecoder {
 
+                // Only one of these is set. They keep the memory m_data is
+                // pointing into alive.
                 std::shared_ptr<std::string> m_input_buffer;
+                std::shared_ptr<MappedInputFile> m_mapped_input;
+
+                data_view m_data;
                 osmium::osm_entity_bits::type m_read_types;
                 osmium::io::read_meta m_read_metadata;
+                osmium::memory::BufferPool* m_buffer_pool;
 
             public:
 
-                PBFDataBlobDecoder(std::string&& input_buffer, osmium::osm_entity_bits::type read_types, osmium::io::read_meta read_metadata) :
+                PBFDataBlobDecoder(std::string&& input_buffer, osmium::osm_entity_bits::type read_types, osmium::io::read_meta read_metadata, osmium::memory::BufferPool* buffer_pool = nullptr) :
                     m_input_buffer(std::make_shared<std::string>(std::move(input_buffer))),
+                    m_mapped_input(),
+                    m_data(*m_input_buffer),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_read_metadata(read_metadata),
+                    m_buffer_pool(buffer_pool) {
+                }
+
+                /**
+                 * Create a decoder for a blob that is not copied but lives
+                 * in the given memory mapped input file.
+                 */
+                PBFDataBlobDecoder(std::shared_ptr<MappedInputFile> mapped_input, const data_view& data, osmium::osm_entity_bits::type read_types, osmium::io::read_meta read_metadata, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_input_buffer(),
+                    m_mapped_input(std::move(mapped_input)),
+                    m_data(data),
+                    m_read_types(read_types),
+                    m_read_metadata(read_metadata),
+                    m_buffer_pool(buffer_pool) {
                 }
 
                 osmium::memory::Buffer operator()() {
                     std::string output;
-                    PBFPrimitiveBlockDecoder decoder{decode_blob(*m_input_buffer, output), m_read_types, m_read_metadata};
+                    PBFPrimitiveBlockDecoder decoder{decode_blob(m_data, output), m_read_types, m_read_metadata, m_buffer_pool};
                     return decoder();
                 }
 
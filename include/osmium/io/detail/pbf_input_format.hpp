@@ -50,6 +50,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/pbf_decoder.hpp>
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/file_format.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
@@ -66,6 +67,9 @@ namespace osmium {
 
                 std::string m_input_buffer;
 
+                // Offset of the next byte to be read from the input file.
+                std::size_t m_offset = 0;
+
                 /**
                  * Read the given number of bytes from the input queue.
                  *
@@ -88,108 +92,204 @@ namespace osmium {
                     using std::swap;
                     swap(output, m_input_buffer);
 
+                    m_offset += size;
+
                     return output;
                 }
 
                 /**
-                 * Read 4 bytes in network byte order from file. They contain
-                 * the length of the following BlobHeader.
+                 * Read the given number of bytes from the memory mapped
+                 * input file. The data is not copied, the returned view
+                 * points into the mapping.
+                 *
+                 * @param size Number of bytes to read
+                 * @returns View on the data
+                 * @throws osmium::pbf_error If size bytes can't be read
                  */
-                uint32_t read_blob_header_size_from_file() {
-                    uint32_t size_in_network_byte_order;
-
-                    try {
-                        const std::string input_data{read_from_input_queue(sizeof(size_in_network_byte_order))};
-                        size_in_network_byte_order = *reinterpret_cast<const uint32_t*>(input_data.data());
-                    } catch (const osmium::pbf_error&) {
-                        return 0; // EOF
+                data_view read_from_mapped_input(size_t size) {
+                    auto& input = *mapped_input();
+                    if (input.size() - m_offset < size) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
                     }
 
-                    #ifndef _WIN32
-                    const uint32_t size = ntohl(size_in_network_byte_order);
-                    #else
-                    uint32_t size = size_in_network_byte_order;
-                    protozero::detail::byteswap_inplace(&size);
-                    #endif
+                    const data_view data{input.data() + m_offset, size};
+                    m_offset += size;
+                    input.set_offset(m_offset);
 
-                    if (size > static_cast<uint32_t>(max_blob_header_size)) {
-                        throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
-                    }
-
-                    return size;
+                    return data;
                 }
 
                 /**
-                 * Decode the BlobHeader. Make sure it contains the expected
-                 * type. Return the size of the following Blob.
+                 * Skip input up to the given offset in the input file. When
+                 * reading from the input queue the data in between still has
+                 * to be read, but it is thrown away immediately.
+                 *
+                 * @throws osmium::pbf_error If the offset is behind the
+                 *         current position or after the end of the file.
                  */
-                size_t decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>&& pbf_blob_header, const char* expected_type) {
-                    protozero::data_view blob_header_type;
-                    size_t blob_header_datasize = 0;
-
-                    while (pbf_blob_header.next()) {
-                        switch (pbf_blob_header.tag()) {
-                            case FileFormat::BlobHeader::required_string_type:
-                                blob_header_type = pbf_blob_header.get_view();
-                                break;
-                            case FileFormat::BlobHeader::required_int32_datasize:
-                                blob_header_datasize = pbf_blob_header.get_int32();
-                                break;
-                            default:
-                                pbf_blob_header.skip();
+                void skip_to(std::size_t offset) {
+                    if (offset < m_offset) {
+                        throw osmium::pbf_error{"blob index does not match input file"};
+                    }
+
+                    if (mapped_input()) {
+                        if (offset > mapped_input()->size()) {
+                            throw osmium::pbf_error{"blob index does not match input file"};
                         }
+                        m_offset = offset;
+                        mapped_input()->set_offset(m_offset);
+                        return;
                     }
 
-                    if (blob_header_datasize == 0) {
-                        throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
+                    std::size_t size = offset - m_offset;
+                    while (m_input_buffer.size() < size) {
+                        size -= m_input_buffer.size();
+                        m_input_buffer = get_input();
+                        if (input_done()) {
+                            throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                        }
+                    }
+                    m_input_buffer.erase(0, size);
+                    m_offset = offset;
+                }
+
+                /**
+                 * Read 4 bytes in network byte order from file. They contain
+                 * the length of the following BlobHeader.
+                 */
+                uint32_t read_blob_header_size_from_file() {
+                    uint32_t size;
+
+                    try {
+                        if (mapped_input()) {
+                            if (mapped_input()->stopped()) {
+                                return 0; // Reader was closed, handle like EOF
+                            }
+                            size = decode_blob_header_size(read_from_mapped_input(sizeof(size)).data());
+                        } else {
+                            size = decode_blob_header_size(read_from_input_queue(sizeof(size)).data());
+                        }
+                    } catch (const osmium::pbf_error&) {
+                        return 0; // EOF
                     }
 
-                    if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size())) {
-                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                    if (size > static_cast<uint32_t>(max_blob_header_size)) {
+                        throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
                     }
 
-                    return blob_header_datasize;
+                    return size;
                 }
 
-                size_t check_type_and_get_blob_size(const char* expected_type) {
+                pbf_blob_header_info check_type_and_get_blob_header(const char* expected_type) {
                     assert(expected_type);
 
                     const auto size = read_blob_header_size_from_file();
                     if (size == 0) { // EOF
-                        return 0;
+                        return pbf_blob_header_info{0, osmium::osm_entity_bits::nothing};
                     }
 
-                    const std::string blob_header{read_from_input_queue(size)};
+                    if (mapped_input()) {
+                        return decode_blob_header(read_from_mapped_input(size), expected_type);
+                    }
 
-                    return decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>(blob_header), expected_type);
+                    return decode_blob_header(read_from_input_queue(size), expected_type);
                 }
 
-                std::string read_from_input_queue_with_check(size_t size) {
+                static void check_blob_size(size_t size) {
                     if (size > max_uncompressed_blob_size) {
                         throw osmium::pbf_error{std::string{"invalid blob size: "} +
                                                 std::to_string(size)};
                     }
+                }
+
+                std::string read_from_input_queue_with_check(size_t size) {
+                    check_blob_size(size);
                     return read_from_input_queue(size);
                 }
 
+                data_view read_from_mapped_input_with_check(size_t size) {
+                    check_blob_size(size);
+                    return read_from_mapped_input(size);
+                }
+
                 // Parse the header in the PBF OSMHeader blob.
                 void parse_header_blob() {
-                    const auto size = check_type_and_get_blob_size("OSMHeader");
-                    osmium::io::Header header{decode_header(read_from_input_queue_with_check(size))};
-                    set_header_value(header);
+                    const auto size = check_type_and_get_blob_header("OSMHeader").datasize;
+                    if (mapped_input()) {
+                        set_header_value(decode_header(read_from_mapped_input_with_check(size)));
+                    } else {
+                        set_header_value(decode_header(read_from_input_queue_with_check(size)));
+                    }
                 }
 
-                void parse_data_blobs() {
-                    while (const auto size = check_type_and_get_blob_size("OSMData")) {
+                void send_to_pool_or_output_queue(PBFDataBlobDecoder&& data_blob_parser) {
+                    if (osmium::config::use_pool_threads_for_pbf_parsing()) {
+                        send_to_output_queue(get_pool().submit(std::move(data_blob_parser)));
+                    } else {
+                        send_to_output_queue(data_blob_parser());
+                    }
+                }
+
+                // Read the blob with the given size and decode it.
+                void parse_data_blob(size_t size) {
+                    if (mapped_input()) {
+                        send_to_pool_or_output_queue(PBFDataBlobDecoder{mapped_input(), read_from_mapped_input_with_check(size), read_types(), read_metadata(), buffer_pool()});
+                    } else {
                         std::string input_buffer{read_from_input_queue_with_check(size)};
+                        send_to_pool_or_output_queue(PBFDataBlobDecoder{std::move(input_buffer), read_types(), read_metadata(), buffer_pool()});
+                    }
+                }
 
-                        PBFDataBlobDecoder data_blob_parser{std::move(input_buffer), read_types(), read_metadata()};
+                // Is the blob with this header known to contain none of the
+                // entity types we are interested in?
+                bool can_skip_blob(const pbf_blob_header_info& header) const noexcept {
+                    return header.types != osmium::osm_entity_bits::nothing &&
+                           !(header.types & read_types());
+                }
 
-                        if (osmium::config::use_pool_threads_for_pbf_parsing()) {
-                            send_to_output_queue(get_pool().submit(std::move(data_blob_parser)));
+                void parse_data_blobs() {
+                    while (true) {
+                        const auto header = check_type_and_get_blob_header("OSMData");
+                        if (header.datasize == 0) { // EOF
+                            return;
+                        }
+                        if (can_skip_blob(header)) {
+                            check_blob_size(header.datasize);
+                            skip_to(m_offset + header.datasize);
                         } else {
-                            send_to_output_queue(data_blob_parser());
+                            parse_data_blob(header.datasize);
+                        }
+                    }
+                }
+
+                // Parse only those blobs from the blob index that contain
+                // any of the entity types we are interested in.
+                void parse_data_blobs_with_index() {
+                    if (mapped_input() && mapped_input()->size() != blob_index()->file_size()) {
+                        throw osmium::pbf_error{"blob index does not match input file"};
+                    }
+
+                    for (const auto& blob : *blob_index()) {
+                        if (!(blob.types & read_types())) {
+                            continue;
                         }
+
+                        skip_to(static_cast<std::size_t>(blob.offset));
+
+                        const auto size = check_type_and_get_blob_header("OSMData").datasize;
+                        if (size == 0) {
+                            if (mapped_input() && mapped_input()->stopped()) {
+                                return;
+                            }
+                            throw osmium::pbf_error{"blob index does not match input file"};
+                        }
+
+                        parse_data_blob(size);
+                    }
+
+                    // No need to look at the rest of the file.
+                    if (mapped_input()) {
+                        mapped_input()->set_offset(mapped_input()->size());
                     }
                 }
 
@@ -207,7 +307,13 @@ namespace osmium {
 
                     parse_header_blob();
 
-                    if (read_types() != osmium::osm_entity_bits::nothing) {
+                    if (read_types() == osmium::osm_entity_bits::nothing) {
+                        return;
+                    }
+
+                    if (blob_index()) {
+                        parse_data_blobs_with_index();
+                    } else {
                         parse_data_blobs();
                     }
                 }
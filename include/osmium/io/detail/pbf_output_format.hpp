@@ -53,12 +53,19 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/detail/string_table.hpp>
 #include <osmium/io/detail/zlib.hpp>
+#ifdef OSMIUM_WITH_LZ4
+# include <osmium/io/detail/lz4.hpp>
+#endif
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item_iterator.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
@@ -80,20 +87,91 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Compression used for the PBF blobs. Lz4 and zstd are only
+             * available if OSMIUM_WITH_LZ4 or OSMIUM_WITH_ZSTD are defined,
+             * respectively.
+             */
+            enum class pbf_compression {
+                none = 0,
+                zlib = 1,
+                lz4  = 2,
+                zstd = 3
+            };
+
+            /// Use the default compression level of the compression library.
+            constexpr const int pbf_default_compression_level = -1;
+
+            inline pbf_compression get_pbf_compression(const std::string& value) {
+                if (value.empty() || value == "zlib" || value == "true" || value == "yes") {
+                    return pbf_compression::zlib;
+                }
+                if (value == "none" || value == "false" || value == "no") {
+                    return pbf_compression::none;
+                }
+                if (value == "lz4") {
+#ifdef OSMIUM_WITH_LZ4
+                    return pbf_compression::lz4;
+#else
+                    throw osmium::io_error{"lz4 compression for PBF not available (compile with OSMIUM_WITH_LZ4)"};
+#endif
+                }
+                if (value == "zstd") {
+#ifdef OSMIUM_WITH_ZSTD
+                    return pbf_compression::zstd;
+#else
+                    throw osmium::io_error{"zstd compression for PBF not available (compile with OSMIUM_WITH_ZSTD)"};
+#endif
+                }
+                throw osmium::io_error{std::string{"unknown value for pbf_compression option: '"} + value + "'"};
+            }
+
+            /**
+             * Get the compression level from the pbf_compression_level
+             * option. Valid levels are 0 to 9 for zlib, 1 to 12 for lz4
+             * (which uses the lz4 high compression mode if a level is set),
+             * and 1 to 22 for zstd.
+             */
+            inline int get_pbf_compression_level(const std::string& value, pbf_compression compression) {
+                if (value.empty()) {
+                    return pbf_default_compression_level;
+                }
+
+                int min_level = 0;
+                int max_level = 9;
+                if (compression == pbf_compression::lz4) {
+                    min_level = 1;
+                    max_level = 12;
+                } else if (compression == pbf_compression::zstd) {
+                    min_level = 1;
+                    max_level = 22;
+                }
+
+                if (value.size() > 2 || value.find_first_not_of("0123456789") != std::string::npos ||
+                    std::atoi(value.c_str()) < min_level || std::atoi(value.c_str()) > max_level) {
+                    throw osmium::io_error{std::string{"invalid value for pbf_compression_level option: '"} + value + "'"};
+                }
+                return std::atoi(value.c_str());
+            }
+
             struct pbf_output_options {
 
                 /// Should nodes be encoded in DenseNodes?
                 bool use_dense_nodes;
 
                 /**
-                 * Should the PBF blobs contain zlib compressed data?
+                 * How should the PBF blobs be compressed?
                  *
-                 * The zlib compression is optional, it's possible to store the
+                 * The compression is optional, it's possible to store the
                  * blobs in raw format. Disabling the compression can improve
                  * the writing speed a little but the output will be 2x to 3x
-                 * bigger.
+                 * bigger. Lz4 and zstd are much faster to decompress than
+                 * zlib, but not all programs can read them.
                  */
-                bool use_compression;
+                pbf_compression compression;
+
+                /// Compression level or pbf_default_compression_level.
+                int compression_level;
 
                 /// Should metadata of objects be written?
                 bool add_metadata;
@@ -107,6 +185,12 @@ namespace osmium {
                 /// Should node locations be added to ways?
                 bool locations_on_ways;
 
+                /**
+                 * Should whole blocks be encoded in parallel on the thread
+                 * pool? Otherwise only the compression runs on the pool.
+                 */
+                bool parallel_encoding;
+
             };
 
             /**
@@ -143,7 +227,39 @@ namespace osmium {
 
                 pbf_blob_type m_blob_type;
 
-                bool m_use_compression;
+                pbf_compression m_compression;
+
+                int m_compression_level;
+
+                osmium::osm_entity_bits::type m_entity_types;
+
+                std::string compress() const {
+                    switch (m_compression) {
+#ifdef OSMIUM_WITH_LZ4
+                        case pbf_compression::lz4:
+                            return osmium::io::detail::lz4_compress(m_msg, m_compression_level == pbf_default_compression_level ? 0 : m_compression_level);
+#endif
+#ifdef OSMIUM_WITH_ZSTD
+                        case pbf_compression::zstd:
+                            return osmium::io::detail::zstd_compress(m_msg, m_compression_level == pbf_default_compression_level ? 0 : m_compression_level);
+#endif
+                        default:
+                            break;
+                    }
+                    return osmium::io::detail::zlib_compress(m_msg, m_compression_level);
+                }
+
+                FileFormat::Blob compressed_data_tag() const noexcept {
+                    switch (m_compression) {
+                        case pbf_compression::lz4:
+                            return FileFormat::Blob::optional_bytes_lz4_data;
+                        case pbf_compression::zstd:
+                            return FileFormat::Blob::optional_bytes_zstd_data;
+                        default:
+                            break;
+                    }
+                    return FileFormat::Blob::optional_bytes_zlib_data;
+                }
 
             public:
 
@@ -152,13 +268,23 @@ namespace osmium {
                  *
                  * @param msg Protobuf-message containing the blob data
                  * @param type Type of blob.
-                 * @param use_compression Should the output be compressed using
-                 *        zlib?
+                 * @param compression Compression to use for the output.
+                 * @param compression_level Compression level or
+                 *        pbf_default_compression_level.
+                 * @param entity_types Types of OSM entities in the blob. If
+                 *        set, they are noted in the BlobHeader so readers
+                 *        can skip the blob without decompressing it.
                  */
-                SerializeBlob(std::string&& msg, pbf_blob_type type, bool use_compression) :
+                SerializeBlob(std::string&& msg,
+                              pbf_blob_type type,
+                              pbf_compression compression,
+                              int compression_level = pbf_default_compression_level,
+                              osmium::osm_entity_bits::type entity_types = osmium::osm_entity_bits::nothing) :
                     m_msg(std::move(msg)),
                     m_blob_type(type),
-                    m_use_compression(use_compression) {
+                    m_compression(compression),
+                    m_compression_level(compression_level),
+                    m_entity_types(entity_types) {
                 }
 
                 /**
@@ -172,9 +298,9 @@ namespace osmium {
                     std::string blob_data;
                     protozero::pbf_builder<FileFormat::Blob> pbf_blob{blob_data};
 
-                    if (m_use_compression) {
+                    if (m_compression != pbf_compression::none) {
                         pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
-                        pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zlib_data, osmium::io::detail::zlib_compress(m_msg));
+                        pbf_blob.add_bytes(compressed_data_tag(), compress());
                     } else {
                         pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_raw, m_msg);
                     }
@@ -183,6 +309,9 @@ namespace osmium {
                     protozero::pbf_builder<FileFormat::BlobHeader> pbf_blob_header{blob_header_data};
 
                     pbf_blob_header.add_string(FileFormat::BlobHeader::required_string_type, m_blob_type == pbf_blob_type::data ? "OSMData" : "OSMHeader");
+                    if (m_entity_types != osmium::osm_entity_bits::nothing) {
+                        pbf_blob_header.add_bytes(FileFormat::BlobHeader::optional_bytes_indexdata, encode_blob_types_marker(m_entity_types));
+                    }
                     pbf_blob_header.add_int32(FileFormat::BlobHeader::required_int32_datasize, static_cast_with_assert<int32_t>(blob_data.size()));
 
                     #ifndef _WIN32
@@ -394,6 +523,24 @@ namespace osmium {
                     return m_type;
                 }
 
+                /// The type of OSM entities in this block.
+                osmium::osm_entity_bits::type entity_type() const noexcept {
+                    switch (m_type) {
+                        case OSMFormat::PrimitiveGroup::repeated_Node_nodes:
+                        case OSMFormat::PrimitiveGroup::optional_DenseNodes_dense:
+                            return osmium::osm_entity_bits::node;
+                        case OSMFormat::PrimitiveGroup::repeated_Way_ways:
+                            return osmium::osm_entity_bits::way;
+                        case OSMFormat::PrimitiveGroup::repeated_Relation_relations:
+                            return osmium::osm_entity_bits::relation;
+                        case OSMFormat::PrimitiveGroup::repeated_ChangeSet_changesets:
+                            return osmium::osm_entity_bits::changeset;
+                        default:
+                            break;
+                    }
+                    return osmium::osm_entity_bits::nothing;
+                }
+
                 std::size_t size() const {
                     return m_pbf_primitive_group_data.size() + m_stringtable.size() + m_dense_nodes.size();
                 }
@@ -418,12 +565,19 @@ namespace osmium {
 
             }; // class PrimitiveBlock
 
-            class PBFOutputFormat : public osmium::io::detail::OutputFormat, public osmium::handler::Handler {
+            /**
+             * Encodes OSM objects into PrimitiveBlocks. Each finished block
+             * is kept as a SerializeBlob object, which still has to be run
+             * (usually on the thread pool) to get the blob for the file.
+             */
+            class PBFBlockEncoder : public osmium::handler::Handler {
 
-                pbf_output_options m_options;
+                const pbf_output_options& m_options;
 
                 PrimitiveBlock m_primitive_block;
 
+                std::vector<SerializeBlob> m_blobs;
+
                 void store_primitive_block() {
                     if (m_primitive_block.count() == 0) {
                         return;
@@ -439,11 +593,11 @@ namespace osmium {
 
                     primitive_block.add_message(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, m_primitive_block.group_data());
 
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(primitive_block_data),
-                                      pbf_blob_type::data,
-                                      m_options.use_compression}
-                    ));
+                    m_blobs.emplace_back(std::move(primitive_block_data),
+                                         pbf_blob_type::data,
+                                         m_options.compression,
+                                         m_options.compression_level,
+                                         m_primitive_block.entity_type());
                 }
 
                 template <typename T>
@@ -485,82 +639,32 @@ namespace osmium {
 
             public:
 
-                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
-                    OutputFormat(pool, output_queue),
-                    m_options(),
-                    m_primitive_block(m_options) {
-                    m_options.use_dense_nodes = file.is_not_false("pbf_dense_nodes");
-                    m_options.use_compression = file.get("pbf_compression") != "none" && file.is_not_false("pbf_compression");
-                    m_options.add_metadata = file.is_not_false("pbf_add_metadata") && file.is_not_false("add_metadata");
-                    m_options.add_historical_information_flag = file.has_multiple_object_versions();
-                    m_options.add_visible_flag = file.has_multiple_object_versions();
-                    m_options.locations_on_ways = file.is_true("locations_on_ways");
+                explicit PBFBlockEncoder(const pbf_output_options& options) :
+                    m_options(options),
+                    m_primitive_block(options),
+                    m_blobs() {
                 }
 
-                PBFOutputFormat(const PBFOutputFormat&) = delete;
-                PBFOutputFormat& operator=(const PBFOutputFormat&) = delete;
+                PBFBlockEncoder(const PBFBlockEncoder&) = delete;
+                PBFBlockEncoder& operator=(const PBFBlockEncoder&) = delete;
 
-                ~PBFOutputFormat() noexcept final = default;
+                PBFBlockEncoder(PBFBlockEncoder&&) = delete;
+                PBFBlockEncoder& operator=(PBFBlockEncoder&&) = delete;
 
-                void write_header(const osmium::io::Header& header) final {
-                    std::string data;
-                    protozero::pbf_builder<OSMFormat::HeaderBlock> pbf_header_block{data};
+                ~PBFBlockEncoder() noexcept = default;
 
-                    if (!header.boxes().empty()) {
-                        protozero::pbf_builder<OSMFormat::HeaderBBox> pbf_header_bbox{pbf_header_block, OSMFormat::HeaderBlock::optional_HeaderBBox_bbox};
-
-                        osmium::Box box = header.joined_boxes();
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_left,   int64_t(box.bottom_left().lon() * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_right,  int64_t(box.top_right().lon()   * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_top,    int64_t(box.top_right().lat()   * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_bottom, int64_t(box.bottom_left().lat() * lonlat_resolution));
-                    }
-
-                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "OsmSchema-V0.6");
-
-                    if (m_options.use_dense_nodes) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "DenseNodes");
-                    }
-
-                    if (m_options.add_historical_information_flag) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "HistoricalInformation");
-                    }
-
-                    if (m_options.locations_on_ways) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
-                    }
-
-                    pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_writingprogram, header.get("generator"));
-
-                    const std::string osmosis_replication_timestamp{header.get("osmosis_replication_timestamp")};
-                    if (!osmosis_replication_timestamp.empty()) {
-                        osmium::Timestamp ts{osmosis_replication_timestamp.c_str()};
-                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_timestamp, uint32_t(ts));
-                    }
-
-                    const std::string osmosis_replication_sequence_number{header.get("osmosis_replication_sequence_number")};
-                    if (!osmosis_replication_sequence_number.empty()) {
-                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_sequence_number, std::atoll(osmosis_replication_sequence_number.c_str()));
-                    }
-
-                    const std::string osmosis_replication_base_url{header.get("osmosis_replication_base_url")};
-                    if (!osmosis_replication_base_url.empty()) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
-                    }
-
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(data),
-                                      pbf_blob_type::header,
-                                      m_options.use_compression}
-                        ));
-                }
-
-                void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    osmium::apply(buffer.cbegin(), buffer.cend(), *this);
+                /// Finish the current block even if it is not full.
+                void flush() {
+                    store_primitive_block();
+                    m_primitive_block.reset(OSMFormat::PrimitiveGroup::unknown);
                 }
 
-                void write_end() final {
-                    store_primitive_block();
+                /// Take all finished blocks out of the encoder.
+                std::vector<SerializeBlob> take_blobs() {
+                    std::vector<SerializeBlob> blobs;
+                    using std::swap;
+                    swap(blobs, m_blobs);
+                    return blobs;
                 }
 
                 void node(const osmium::Node& node) {
@@ -643,6 +747,189 @@ namespace osmium {
                     }
                 }
 
+            }; // class PBFBlockEncoder
+
+            /**
+             * Encodes a range of OSM objects from a buffer into complete
+             * blobs. This is used to encode several parts of a buffer in
+             * parallel on the thread pool. The result is the data of all
+             * blobs ready to be written to the file.
+             */
+            class PBFEncodeChunk {
+
+                pbf_output_options m_options;
+                std::shared_ptr<osmium::memory::Buffer> m_buffer;
+                osmium::memory::Buffer::const_iterator m_begin;
+                osmium::memory::Buffer::const_iterator m_end;
+
+            public:
+
+                PBFEncodeChunk(const pbf_output_options& options,
+                               const std::shared_ptr<osmium::memory::Buffer>& buffer,
+                               osmium::memory::Buffer::const_iterator begin,
+                               osmium::memory::Buffer::const_iterator end) :
+                    m_options(options),
+                    m_buffer(buffer),
+                    m_begin(begin),
+                    m_end(end) {
+                }
+
+                std::string operator()() {
+                    PBFBlockEncoder encoder{m_options};
+                    osmium::apply(m_begin, m_end, encoder);
+                    encoder.flush();
+                    m_buffer.reset();
+
+                    std::string output;
+                    for (auto& blob : encoder.take_blobs()) {
+                        output.append(blob());
+                    }
+
+                    return output;
+                }
+
+            }; // class PBFEncodeChunk
+
+            class PBFOutputFormat : public osmium::io::detail::OutputFormat {
+
+                pbf_output_options m_options;
+
+                PBFBlockEncoder m_encoder;
+
+                void send_blobs_to_pool() {
+                    for (auto& blob : m_encoder.take_blobs()) {
+                        m_output_queue.push(m_pool.submit(std::move(blob)));
+                    }
+                }
+
+                static bool is_encoded_type(osmium::item_type type) noexcept {
+                    return type == osmium::item_type::node ||
+                           type == osmium::item_type::way ||
+                           type == osmium::item_type::relation;
+                }
+
+                /**
+                 * Split the buffer into chunks of at most
+                 * max_entities_per_block objects of the same type and
+                 * encode each of them on the thread pool. The futures are
+                 * added to the output queue in order, so the output is the
+                 * same regardless of which thread finishes first.
+                 */
+                void write_buffer_in_chunks(osmium::memory::Buffer&& buffer) {
+                    const auto shared_buffer = osmium::memory::detail::share_buffer(m_buffer_pool, std::move(buffer));
+
+                    auto it = shared_buffer->cbegin();
+                    const auto end = shared_buffer->cend();
+                    while (it != end) {
+                        const auto begin = it;
+                        const auto type = it->type();
+                        int32_t count = 0;
+                        do {
+                            ++it;
+                            ++count;
+                        } while (it != end && it->type() == type && count < max_entities_per_block);
+
+                        if (is_encoded_type(type)) {
+                            m_output_queue.push(m_pool.submit(PBFEncodeChunk{m_options, shared_buffer, begin, it}));
+                        }
+                    }
+                }
+
+            public:
+
+                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue),
+                    m_options(),
+                    m_encoder(m_options) {
+                    m_options.use_dense_nodes = file.is_not_false("pbf_dense_nodes");
+                    m_options.compression = get_pbf_compression(file.get("pbf_compression"));
+                    m_options.compression_level = get_pbf_compression_level(file.get("pbf_compression_level"), m_options.compression);
+                    m_options.add_metadata = file.is_not_false("pbf_add_metadata") && file.is_not_false("add_metadata");
+                    m_options.add_historical_information_flag = file.has_multiple_object_versions();
+                    m_options.add_visible_flag = file.has_multiple_object_versions();
+                    m_options.locations_on_ways = file.is_true("locations_on_ways");
+                    m_options.parallel_encoding = file.is_true("pbf_parallel_encoding");
+                }
+
+                PBFOutputFormat(const PBFOutputFormat&) = delete;
+                PBFOutputFormat& operator=(const PBFOutputFormat&) = delete;
+
+                ~PBFOutputFormat() noexcept final = default;
+
+                void write_header(const osmium::io::Header& header) final {
+                    std::string data;
+                    protozero::pbf_builder<OSMFormat::HeaderBlock> pbf_header_block{data};
+
+                    if (!header.boxes().empty()) {
+                        protozero::pbf_builder<OSMFormat::HeaderBBox> pbf_header_bbox{pbf_header_block, OSMFormat::HeaderBlock::optional_HeaderBBox_bbox};
+
+                        osmium::Box box = header.joined_boxes();
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_left,   int64_t(box.bottom_left().lon() * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_right,  int64_t(box.top_right().lon()   * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_top,    int64_t(box.top_right().lat()   * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_bottom, int64_t(box.bottom_left().lat() * lonlat_resolution));
+                    }
+
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "OsmSchema-V0.6");
+
+                    if (m_options.use_dense_nodes) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "DenseNodes");
+                    }
+
+                    if (m_options.add_historical_information_flag) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "HistoricalInformation");
+                    }
+
+                    if (m_options.locations_on_ways) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
+                    }
+
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_writingprogram, header.get("generator"));
+
+                    const std::string osmosis_replication_timestamp{header.get("osmosis_replication_timestamp")};
+                    if (!osmosis_replication_timestamp.empty()) {
+                        osmium::Timestamp ts{osmosis_replication_timestamp.c_str()};
+                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_timestamp, uint32_t(ts));
+                    }
+
+                    const std::string osmosis_replication_sequence_number{header.get("osmosis_replication_sequence_number")};
+                    if (!osmosis_replication_sequence_number.empty()) {
+                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_sequence_number, std::atoll(osmosis_replication_sequence_number.c_str()));
+                    }
+
+                    const std::string osmosis_replication_base_url{header.get("osmosis_replication_base_url")};
+                    if (!osmosis_replication_base_url.empty()) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
+                    }
+
+                    m_output_queue.push(m_pool.submit(
+                        SerializeBlob{std::move(data),
+                                      pbf_blob_type::header,
+                                      m_options.compression,
+                                      m_options.compression_level}
+                        ));
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    if (m_options.parallel_encoding) {
+                        write_buffer_in_chunks(std::move(buffer));
+                        return;
+                    }
+
+                    osmium::apply(buffer.cbegin(), buffer.cend(), m_encoder);
+                    send_blobs_to_pool();
+
+                    // The encoder has copied everything it needs.
+                    if (m_buffer_pool) {
+                        m_buffer_pool->put(std::move(buffer));
+                    }
+                }
+
+                void write_end() final {
+                    m_encoder.flush();
+                    send_blobs_to_pool();
+                }
+
             }; // class PBFOutputFormat
 
             // we want the register_output_format() function to run, setting
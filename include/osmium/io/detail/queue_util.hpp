@@ -40,7 +40,7 @@ DEALINGS IN THE SOFTWARE.
 #include <utility>
 
 #include <osmium/memory/buffer.hpp>
-#include <osmium/thread/queue.hpp>
+#include <osmium/thread/bounded_queue.hpp>
 
 namespace osmium {
 
@@ -48,8 +48,13 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * The queues between the threads of the readers and writers.
+             * They always have a maximum size, so a thread producing data
+             * can't get too far ahead of the consumer.
+             */
             template <typename T>
-            using future_queue_type = osmium::thread::Queue<std::future<T>>;
+            using future_queue_type = osmium::thread::BoundedQueue<std::future<T>>;
 
             /**
              * This type of queue contains buffers with OSM data in them.
@@ -0,0 +1,250 @@
+#ifndef OSMIUM_IO_DETAIL_STRING_SCAN_HPP
+#define OSMIUM_IO_DETAIL_STRING_SCAN_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized scanning is used on GCC and clang if SSE2 (which all x86_64
+// CPUs have) or AVX2 is enabled when compiling. It reads whole aligned
+// blocks of memory, possibly after the end of a string, which the address
+// sanitizer doesn't like, so it is disabled in that case. Define
+// OSMIUM_NO_SIMD to always use the scalar code.
+#if defined(__GNUC__) && defined(__SSE2__) && !defined(OSMIUM_NO_SIMD) && !defined(__SANITIZE_ADDRESS__)
+# if defined(__has_feature)
+#  if !__has_feature(address_sanitizer)
+#   define OSMIUM_USE_SIMD_SCAN
+#  endif
+# else
+#  define OSMIUM_USE_SIMD_SCAN
+# endif
+#endif
+
+#ifdef OSMIUM_USE_SIMD_SCAN
+# include <immintrin.h>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            inline constexpr bool is_one_of(char) noexcept {
+                return false;
+            }
+
+            template <typename... TChars>
+            inline constexpr bool is_one_of(char c, char first, TChars... rest) noexcept {
+                return c == first || is_one_of(c, rest...);
+            }
+
+            /**
+             * Find the first of the given characters or the end of the
+             * string (the \0 character) in s. One character at a time.
+             */
+            template <char... TChars>
+            inline const char* find_first_of_or_end_scalar(const char* s) noexcept {
+                while (!is_one_of(*s, '\0', TChars...)) {
+                    ++s;
+                }
+                return s;
+            }
+
+            /**
+             * Find the first of the given characters in the range from s
+             * to end. Returns end if none of them is found. One character
+             * at a time.
+             */
+            template <char... TChars>
+            inline const char* find_first_of_in_range_scalar(const char* s, const char* end) noexcept {
+                while (s != end && !is_one_of(*s, TChars...)) {
+                    ++s;
+                }
+                return s;
+            }
+
+#ifdef OSMIUM_USE_SIMD_SCAN
+
+# ifdef __AVX2__
+            struct simd_ops {
+
+                using vector_type = __m256i;
+
+                enum : std::size_t {
+                    width = 32
+                };
+
+                static vector_type load_aligned(const char* p) noexcept {
+                    return _mm256_load_si256(reinterpret_cast<const vector_type*>(p));
+                }
+
+                static vector_type load(const char* p) noexcept {
+                    return _mm256_loadu_si256(reinterpret_cast<const vector_type*>(p));
+                }
+
+                static vector_type none() noexcept {
+                    return _mm256_setzero_si256();
+                }
+
+                static vector_type match(vector_type block, char c) noexcept {
+                    return _mm256_cmpeq_epi8(block, _mm256_set1_epi8(c));
+                }
+
+                static vector_type either(vector_type a, vector_type b) noexcept {
+                    return _mm256_or_si256(a, b);
+                }
+
+                static uint32_t mask(vector_type v) noexcept {
+                    return static_cast<uint32_t>(_mm256_movemask_epi8(v));
+                }
+
+            }; // struct simd_ops
+# else
+            struct simd_ops {
+
+                using vector_type = __m128i;
+
+                enum : std::size_t {
+                    width = 16
+                };
+
+                static vector_type load_aligned(const char* p) noexcept {
+                    return _mm_load_si128(reinterpret_cast<const vector_type*>(p));
+                }
+
+                static vector_type load(const char* p) noexcept {
+                    return _mm_loadu_si128(reinterpret_cast<const vector_type*>(p));
+                }
+
+                static vector_type none() noexcept {
+                    return _mm_setzero_si128();
+                }
+
+                static vector_type match(vector_type block, char c) noexcept {
+                    return _mm_cmpeq_epi8(block, _mm_set1_epi8(c));
+                }
+
+                static vector_type either(vector_type a, vector_type b) noexcept {
+                    return _mm_or_si128(a, b);
+                }
+
+                static uint32_t mask(vector_type v) noexcept {
+                    return static_cast<uint32_t>(_mm_movemask_epi8(v));
+                }
+
+            }; // struct simd_ops
+# endif
+
+            inline simd_ops::vector_type match_any(simd_ops::vector_type) noexcept {
+                return simd_ops::none();
+            }
+
+            template <typename... TChars>
+            inline simd_ops::vector_type match_any(simd_ops::vector_type block, char first, TChars... rest) noexcept {
+                return simd_ops::either(simd_ops::match(block, first), match_any(block, rest...));
+            }
+
+            template <char... TChars>
+            inline const char* find_first_of_or_end_simd(const char* s) noexcept {
+                // Aligned loads never cross a page boundary, so reading
+                // the rest of the block after the end of the string is
+                // okay even if it is at the end of the allocated memory.
+                const auto offset = reinterpret_cast<uintptr_t>(s) % simd_ops::width;
+                const char* block = s - offset;
+
+                uint32_t bits = simd_ops::mask(match_any(simd_ops::load_aligned(block), '\0', TChars...)) >> offset;
+                if (bits) {
+                    return s + __builtin_ctz(bits);
+                }
+
+                while (true) {
+                    block += simd_ops::width;
+                    bits = simd_ops::mask(match_any(simd_ops::load_aligned(block), '\0', TChars...));
+                    if (bits) {
+                        return block + __builtin_ctz(bits);
+                    }
+                }
+            }
+
+            template <char... TChars>
+            inline const char* find_first_of_in_range_simd(const char* s, const char* end) noexcept {
+                while (static_cast<std::size_t>(end - s) >= simd_ops::width) {
+                    const uint32_t bits = simd_ops::mask(match_any(simd_ops::load(s), TChars...));
+                    if (bits) {
+                        return s + __builtin_ctz(bits);
+                    }
+                    s += simd_ops::width;
+                }
+                return find_first_of_in_range_scalar<TChars...>(s, end);
+            }
+
+#endif
+
+            /**
+             * Find the first of the given characters or the end of the
+             * string (the \0 character) in s. Uses SIMD instructions if
+             * available.
+             */
+            template <char... TChars>
+            inline const char* find_first_of_or_end(const char* s) noexcept {
+#ifdef OSMIUM_USE_SIMD_SCAN
+                return find_first_of_or_end_simd<TChars...>(s);
+#else
+                return find_first_of_or_end_scalar<TChars...>(s);
+#endif
+            }
+
+            /**
+             * Find the first of the given characters in the range from s
+             * to end. Returns end if none of them is found. Uses SIMD
+             * instructions if available.
+             */
+            template <char... TChars>
+            inline const char* find_first_of_in_range(const char* s, const char* end) noexcept {
+#ifdef OSMIUM_USE_SIMD_SCAN
+                return find_first_of_in_range_simd<TChars...>(s, end);
+#else
+                return find_first_of_in_range_scalar<TChars...>(s, end);
+#endif
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_STRING_SCAN_HPP
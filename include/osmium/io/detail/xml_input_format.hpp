@@ -33,7 +33,10 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cstddef>
 #include <cstring>
 #include <future>
 #include <memory>
@@ -50,6 +53,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/changeset.hpp>
 #include <osmium/osm/entity_bits.hpp>
@@ -63,6 +67,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/types_from_string.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/cast.hpp>
 
@@ -80,14 +85,14 @@ namespace osmium {
         XML_Error error_code;
         std::string error_string;
 
-        explicit xml_error(const XML_Parser& parser) :
+        explicit xml_error(const XML_Parser& parser, unsigned long line_offset = 0) :
             io_error(std::string{"XML parsing error at line "}
-                    + std::to_string(XML_GetCurrentLineNumber(parser))
+                    + std::to_string(XML_GetCurrentLineNumber(parser) + line_offset)
                     + ", column "
                     + std::to_string(XML_GetCurrentColumnNumber(parser))
                     + ": "
                     + XML_ErrorString(XML_GetErrorCode(parser))),
-            line(XML_GetCurrentLineNumber(parser)),
+            line(XML_GetCurrentLineNumber(parser) + line_offset),
             column(XML_GetCurrentColumnNumber(parser)),
             error_code(XML_GetErrorCode(parser)),
             error_string(XML_ErrorString(error_code)) {
@@ -127,9 +132,86 @@ namespace osmium {
 
         namespace detail {
 
-            class XMLParser : public Parser {
+            /**
+             * A C++ wrapper for the Expat parser that makes sure no memory is leaked.
+             * The callback object gets the start_element(), end_element(), and
+             * characters() calls.
+             */
+            template <typename T>
+            class ExpatXMLParser {
 
-                static constexpr int buffer_size = 2 * 1000 * 1000;
+                XML_Parser m_parser;
+                unsigned long m_line_offset;
+
+                static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) {
+                    static_cast<T*>(data)->start_element(element, attrs);
+                }
+
+                static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) {
+                    static_cast<T*>(data)->end_element(element);
+                }
+
+                static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) {
+                    static_cast<T*>(data)->characters(text, len);
+                }
+
+                // This handler is called when there are any XML entities
+                // declared in the OSM file. Entities are normally not used,
+                // but they can be misused. See
+                // https://en.wikipedia.org/wiki/Billion_laughs
+                // The handler will just throw an error.
+                static void entity_declaration_handler(void*,
+                        const XML_Char*, int, const XML_Char*, int, const XML_Char*,
+                        const XML_Char*, const XML_Char*, const XML_Char*) {
+                    throw osmium::xml_error{"XML entities are not supported"};
+                }
+
+            public:
+
+                /**
+                 * @param callback_object Object getting the callbacks.
+                 * @param line_offset Added to the line numbers reported
+                 *                    in errors. Used when parsing only a
+                 *                    part of the input.
+                 */
+                explicit ExpatXMLParser(T* callback_object, unsigned long line_offset = 0) :
+                    m_parser(XML_ParserCreate(nullptr)),
+                    m_line_offset(line_offset) {
+                    if (!m_parser) {
+                        throw osmium::io_error{"Internal error: Can not create parser"};
+                    }
+                    XML_SetUserData(m_parser, callback_object);
+                    XML_SetElementHandler(m_parser, start_element_wrapper, end_element_wrapper);
+                    XML_SetCharacterDataHandler(m_parser, character_data_wrapper);
+                    XML_SetEntityDeclHandler(m_parser, entity_declaration_handler);
+                }
+
+                ExpatXMLParser(const ExpatXMLParser&) = delete;
+                ExpatXMLParser(ExpatXMLParser&&) = delete;
+
+                ExpatXMLParser& operator=(const ExpatXMLParser&) = delete;
+                ExpatXMLParser& operator=(ExpatXMLParser&&) = delete;
+
+                ~ExpatXMLParser() noexcept {
+                    XML_ParserFree(m_parser);
+                }
+
+                void operator()(const std::string& data, bool last) {
+                    if (XML_Parse(m_parser, data.data(), static_cast_with_assert<int>(data.size()), last) == XML_STATUS_ERROR) {
+                        throw osmium::xml_error{m_parser, m_line_offset};
+                    }
+                }
+
+            }; // class ExpatXMLParser
+
+            /**
+             * Builds OSM objects in a buffer from the callbacks of the Expat
+             * parser. The callback object is told when the header is complete
+             * (header_done()) and after each object is finished
+             * (flush_buffer()), so it can take the buffer when it is full.
+             */
+            template <typename TCallback>
+            class XMLContentHandler {
 
                 enum class context {
                     root,
@@ -148,6 +230,10 @@ namespace osmium {
                     in_object
                 }; // enum class context
 
+                TCallback& m_callback;
+
+                osmium::osm_entity_bits::type m_read_types;
+
                 context m_context;
                 context m_last_context;
 
@@ -173,68 +259,6 @@ namespace osmium {
 
                 std::string m_comment_text;
 
-                /**
-                 * A C++ wrapper for the Expat parser that makes sure no memory is leaked.
-                 */
-                template <typename T>
-                class ExpatXMLParser {
-
-                    XML_Parser m_parser;
-
-                    static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) {
-                        static_cast<XMLParser*>(data)->start_element(element, attrs);
-                    }
-
-                    static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) {
-                        static_cast<XMLParser*>(data)->end_element(element);
-                    }
-
-                    static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) {
-                        static_cast<XMLParser*>(data)->characters(text, len);
-                    }
-
-                    // This handler is called when there are any XML entities
-                    // declared in the OSM file. Entities are normally not used,
-                    // but they can be misused. See
-                    // https://en.wikipedia.org/wiki/Billion_laughs
-                    // The handler will just throw an error.
-                    static void entity_declaration_handler(void*,
-                            const XML_Char*, int, const XML_Char*, int, const XML_Char*,
-                            const XML_Char*, const XML_Char*, const XML_Char*) {
-                        throw osmium::xml_error{"XML entities are not supported"};
-                    }
-
-                public:
-
-                    explicit ExpatXMLParser(T* callback_object) :
-                        m_parser(XML_ParserCreate(nullptr)) {
-                        if (!m_parser) {
-                            throw osmium::io_error{"Internal error: Can not create parser"};
-                        }
-                        XML_SetUserData(m_parser, callback_object);
-                        XML_SetElementHandler(m_parser, start_element_wrapper, end_element_wrapper);
-                        XML_SetCharacterDataHandler(m_parser, character_data_wrapper);
-                        XML_SetEntityDeclHandler(m_parser, entity_declaration_handler);
-                    }
-
-                    ExpatXMLParser(const ExpatXMLParser&) = delete;
-                    ExpatXMLParser(ExpatXMLParser&&) = delete;
-
-                    ExpatXMLParser& operator=(const ExpatXMLParser&) = delete;
-                    ExpatXMLParser& operator=(ExpatXMLParser&&) = delete;
-
-                    ~ExpatXMLParser() noexcept {
-                        XML_ParserFree(m_parser);
-                    }
-
-                    void operator()(const std::string& data, bool last) {
-                        if (XML_Parse(m_parser, data.data(), static_cast_with_assert<int>(data.size()), last) == XML_STATUS_ERROR) {
-                            throw osmium::xml_error{m_parser};
-                        }
-                    }
-
-                }; // class ExpatXMLParser
-
                 template <typename T>
                 static void check_attributes(const XML_Char** attrs, T check) {
                     while (*attrs) {
@@ -312,7 +336,39 @@ namespace osmium {
                 }
 
                 void mark_header_as_done() {
-                    set_header_value(m_header);
+                    m_callback.header_done(m_header);
+                }
+
+                void flush_buffer() {
+                    m_callback.flush_buffer(m_buffer);
+                }
+
+            public:
+
+                XMLContentHandler(TCallback& callback, osmium::osm_entity_bits::type read_types, std::size_t buffer_size, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_callback(callback),
+                    m_read_types(read_types),
+                    m_context(context::root),
+                    m_last_context(context::root),
+                    m_in_delete_section(false),
+                    m_header(),
+                    m_buffer(osmium::memory::detail::get_buffer(buffer_pool, buffer_size)),
+                    m_node_builder(),
+                    m_way_builder(),
+                    m_relation_builder(),
+                    m_changeset_builder(),
+                    m_changeset_discussion_builder(),
+                    m_tl_builder(),
+                    m_wnl_builder(),
+                    m_rml_builder() {
+                }
+
+                const osmium::io::Header& header() const noexcept {
+                    return m_header;
+                }
+
+                osmium::memory::Buffer& buffer() noexcept {
+                    return m_buffer;
                 }
 
                 void start_element(const XML_Char* element, const XML_Char** attrs) {
@@ -344,7 +400,7 @@ namespace osmium {
                             assert(!m_tl_builder);
                             if (!std::strcmp(element, "node")) {
                                 mark_header_as_done();
-                                if (read_types() & osmium::osm_entity_bits::node) {
+                                if (m_read_types & osmium::osm_entity_bits::node) {
                                     m_node_builder.reset(new osmium::builder::NodeBuilder{m_buffer});
                                     m_node_builder->set_user(init_object(m_node_builder->object(), attrs));
                                     m_context = context::node;
@@ -353,7 +409,7 @@ namespace osmium {
                                 }
                             } else if (!std::strcmp(element, "way")) {
                                 mark_header_as_done();
-                                if (read_types() & osmium::osm_entity_bits::way) {
+                                if (m_read_types & osmium::osm_entity_bits::way) {
                                     m_way_builder.reset(new osmium::builder::WayBuilder{m_buffer});
                                     m_way_builder->set_user(init_object(m_way_builder->object(), attrs));
                                     m_context = context::way;
@@ -362,7 +418,7 @@ namespace osmium {
                                 }
                             } else if (!std::strcmp(element, "relation")) {
                                 mark_header_as_done();
-                                if (read_types() & osmium::osm_entity_bits::relation) {
+                                if (m_read_types & osmium::osm_entity_bits::relation) {
                                     m_relation_builder.reset(new osmium::builder::RelationBuilder{m_buffer});
                                     m_relation_builder->set_user(init_object(m_relation_builder->object(), attrs));
                                     m_context = context::relation;
@@ -371,7 +427,7 @@ namespace osmium {
                                 }
                             } else if (!std::strcmp(element, "changeset")) {
                                 mark_header_as_done();
-                                if (read_types() & osmium::osm_entity_bits::changeset) {
+                                if (m_read_types & osmium::osm_entity_bits::changeset) {
                                     m_changeset_builder.reset(new osmium::builder::ChangesetBuilder{m_buffer});
                                     init_changeset(*m_changeset_builder, attrs);
                                     m_context = context::changeset;
@@ -616,41 +672,192 @@ namespace osmium {
                     }
                 }
 
-                void flush_buffer() {
-                    if (m_buffer.committed() > buffer_size / 10 * 9) {
-                        send_to_output_queue(std::move(m_buffer));
-                        osmium::memory::Buffer buffer(buffer_size);
-                        using std::swap;
-                        swap(m_buffer, buffer);
+            }; // class XMLContentHandler
+
+            enum class xml_split_type {
+                need_more, // more data is needed to find the split point
+                none,      // there is no split point until the end of the data
+                object,    // start tag of a node, way, relation, or changeset
+                root_end   // end tag of the osm root element
+            }; // enum class xml_split_type
+
+            struct xml_split_point {
+                xml_split_type type;
+                std::size_t pos;
+            }; // struct xml_split_point
+
+            inline bool is_xml_name_end(const char c) noexcept {
+                return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '>' || c == '/';
+            }
+
+            // Is there the element name of the given length at pos in the data?
+            inline bool xml_name_at(const std::string& data, std::size_t pos, const char* name, std::size_t length) {
+                return data.compare(pos, length, name) == 0 &&
+                       pos + length < data.size() &&
+                       is_xml_name_end(data[pos + length]);
+            }
+
+            /**
+             * Find the next place from pos where the XML data can be split:
+             * The start tag of an OSM object or the end tag of the osm root
+             * element. Comments, CDATA sections, and processing instructions
+             * are skipped. The returned position is that of the '<' character.
+             *
+             * If the end of the data is reached before a split point is found
+             * and last is false, the type need_more is returned with the
+             * position from which to continue searching once more data has
+             * been appended.
+             */
+            inline xml_split_point find_xml_split_point(const std::string& data, std::size_t pos, bool last) {
+                // Enough characters to recognize "<![CDATA[" or "<changeset "
+                constexpr const std::size_t lookahead = 11;
+
+                const xml_split_type not_found = last ? xml_split_type::none : xml_split_type::need_more;
+
+                while (true) {
+                    pos = data.find('<', pos);
+                    if (pos == std::string::npos) {
+                        return {not_found, data.size()};
+                    }
+                    if (!last && data.size() - pos < lookahead) {
+                        return {xml_split_type::need_more, pos};
+                    }
+
+                    const char c = data[pos + 1];
+                    if (c == '!' || c == '?') {
+                        const char* end_marker = ">";
+                        if (c == '?') {
+                            end_marker = "?>";
+                        } else if (data.compare(pos, 4, "<!--") == 0) {
+                            end_marker = "-->";
+                        } else if (data.compare(pos, 9, "<![CDATA[") == 0) {
+                            end_marker = "]]>";
+                        }
+                        const auto end = data.find(end_marker, pos + 2);
+                        if (end == std::string::npos) {
+                            return {not_found, last ? data.size() : pos};
+                        }
+                        pos = end + 1;
+                        continue;
+                    }
+
+                    if (c == '/') {
+                        if (xml_name_at(data, pos + 2, "osm", 3)) {
+                            return {xml_split_type::root_end, pos};
+                        }
+                    } else if (xml_name_at(data, pos + 1, "node", 4) ||
+                               xml_name_at(data, pos + 1, "way", 3) ||
+                               xml_name_at(data, pos + 1, "relation", 8) ||
+                               xml_name_at(data, pos + 1, "changeset", 9)) {
+                        return {xml_split_type::object, pos};
+                    }
+                    ++pos;
+                }
+            }
+
+            /**
+             * Check whether the XML data before the first OSM object is from
+             * a plain OSM file that can be parsed in chunks: The root element
+             * must be "osm", the encoding UTF-8, and there must be no DOCTYPE
+             * (which could declare entities) and no namespace declarations.
+             */
+            inline bool is_plain_osm_xml_header(const std::string& data) {
+                if (data.find("<!DOCTYPE") != std::string::npos ||
+                    data.find("xmlns") != std::string::npos) {
+                    return false;
+                }
+
+                const auto encoding = data.find("encoding=");
+                if (encoding != std::string::npos) {
+                    const char* value = data.c_str() + encoding + 9;
+                    if (*value != '"' && *value != '\'') {
+                        return false;
+                    }
+                    static const char utf8[] = "utf-8";
+                    for (std::size_t i = 0; i < sizeof(utf8) - 1; ++i) {
+                        if (std::tolower(static_cast<unsigned char>(value[i + 1])) != utf8[i]) {
+                            return false;
+                        }
+                    }
+                    if (value[sizeof(utf8)] != *value) {
+                        return false;
+                    }
+                }
+
+                for (auto pos = data.find("<osm"); pos != std::string::npos; pos = data.find("<osm", pos + 1)) {
+                    if (is_xml_name_end(data[pos + 4])) {
+                        return true;
                     }
                 }
 
+                return false;
+            }
+
+            /**
+             * Parses a chunk of XML data containing only complete OSM objects
+             * into a buffer. The chunk is wrapped in an osm root element before
+             * parsing. These are the tasks run in the thread pool.
+             */
+            class XMLChunkParser {
+
+                std::string m_data;
+                unsigned long m_first_line;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::memory::BufferPool* m_buffer_pool;
+
             public:
 
-                explicit XMLParser(parser_arguments& args) :
-                    Parser(args),
-                    m_context(context::root),
-                    m_last_context(context::root),
-                    m_in_delete_section(false),
-                    m_header(),
-                    m_buffer(buffer_size),
-                    m_node_builder(),
-                    m_way_builder(),
-                    m_relation_builder(),
-                    m_changeset_builder(),
-                    m_changeset_discussion_builder(),
-                    m_tl_builder(),
-                    m_wnl_builder(),
-                    m_rml_builder() {
+                XMLChunkParser(std::string&& data, unsigned long first_line, osmium::osm_entity_bits::type read_types, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    m_data(std::move(data)),
+                    m_first_line(first_line),
+                    m_read_types(read_types),
+                    m_buffer_pool(buffer_pool) {
                 }
 
-                ~XMLParser() noexcept final = default;
+                void header_done(const osmium::io::Header& /*header*/) const noexcept {
+                }
 
-                void run() final {
-                    osmium::thread::set_thread_name("_osmium_xml_in");
+                void flush_buffer(osmium::memory::Buffer& /*buffer*/) const noexcept {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    XMLContentHandler<XMLChunkParser> handler{*this, m_read_types, m_data.size(), m_buffer_pool};
+
+                    // The root element is on the same line as the start of
+                    // the chunk, so line numbers in errors are only off by
+                    // this offset.
+                    ExpatXMLParser<XMLContentHandler<XMLChunkParser>> parser{&handler, m_first_line - 1};
+                    parser(std::string{"<osm version=\"0.6\">"}, false);
+                    parser(m_data, false);
+                    parser(std::string{"</osm>"}, true);
+
+                    return std::move(handler.buffer());
+                }
+
+            }; // class XMLChunkParser
 
-                    ExpatXMLParser<XMLParser> parser(this);
+            /**
+             * The XML parser. If parallel parsing was requested and the input
+             * is a plain OSM file, it splits the input into chunks of complete
+             * objects and parses them in the thread pool. The resulting
+             * buffers are sent to the output queue as futures, so they stay
+             * in order. Otherwise the whole input is parsed in this thread.
+             */
+            class XMLParser : public Parser {
+
+                static constexpr int buffer_size = 2 * 1000 * 1000;
+
+                // Chunks of XML data parsed by one task in the pool will
+                // be at least this large (except for the last one).
+                enum constant_chunk_size : std::size_t {
+                    chunk_size = 1024 * 1024
+                };
+
+                using expat_parser_type = ExpatXMLParser<XMLContentHandler<XMLParser>>;
+
+                XMLContentHandler<XMLParser> m_handler;
 
+                void parse_input(expat_parser_type& parser) {
                     while (!input_done()) {
                         const std::string data{get_input()};
                         parser(data, input_done());
@@ -658,11 +865,106 @@ namespace osmium {
                             break;
                         }
                     }
+                }
+
+                void parse_chunk(std::string&& chunk, unsigned long& line) {
+                    const unsigned long first_line = line;
+                    line += static_cast<unsigned long>(std::count(chunk.begin(), chunk.end(), '\n'));
+                    send_to_output_queue(get_pool().submit(XMLChunkParser{std::move(chunk), first_line, read_types(), buffer_pool()}));
+                }
+
+                void parse_input_in_chunks(expat_parser_type& parser) {
+                    std::string data;
+                    std::size_t pos = 0;
+                    xml_split_point split;
+
+                    // Read up to the start of the first OSM object.
+                    do {
+                        if (!input_done()) {
+                            data.append(get_input());
+                        }
+                        split = find_xml_split_point(data, pos, input_done());
+                        pos = split.pos;
+                    } while (split.type == xml_split_type::need_more);
+
+                    if (split.type == xml_split_type::none || !is_plain_osm_xml_header(data.substr(0, split.pos))) {
+                        parser(data, input_done());
+                        parse_input(parser);
+                        return;
+                    }
+
+                    // The header is parsed in this thread.
+                    std::string rest{data, split.pos};
+                    data.resize(split.pos);
+                    parser(data, false);
+                    set_header_value(m_handler.header());
+                    if (read_types() == osmium::osm_entity_bits::nothing) {
+                        return;
+                    }
+
+                    unsigned long line = 1 + static_cast<unsigned long>(std::count(data.begin(), data.end(), '\n'));
+                    data = std::move(rest);
+                    pos = 1;
+
+                    while (split.type == xml_split_type::object) {
+                        split = find_xml_split_point(data, pos, input_done());
+                        if (split.type == xml_split_type::need_more) {
+                            pos = split.pos;
+                            data.append(get_input());
+                            continue;
+                        }
+                        if (split.type == xml_split_type::object && split.pos < chunk_size) {
+                            pos = split.pos + 1;
+                            continue;
+                        }
+                        rest.assign(data, split.pos, std::string::npos);
+                        data.resize(split.pos);
+                        parse_chunk(std::move(data), line);
+                        data = std::move(rest);
+                        pos = 1;
+                    }
+
+                    // The end of the root element and anything after it
+                    // is parsed in this thread.
+                    parser(data, input_done());
+                    parse_input(parser);
+                }
+
+            public:
+
+                explicit XMLParser(parser_arguments& args) :
+                    Parser(args),
+                    m_handler(*this, args.read_which_entities, buffer_size, args.buffer_pool) {
+                }
+
+                ~XMLParser() noexcept final = default;
+
+                void header_done(const osmium::io::Header& header) {
+                    set_header_value(header);
+                }
+
+                void flush_buffer(osmium::memory::Buffer& buffer) {
+                    if (buffer.committed() > buffer_size / 10 * 9) {
+                        send_to_output_queue(std::move(buffer));
+                        buffer = new_buffer(buffer_size);
+                    }
+                }
+
+                void run() final {
+                    osmium::thread::set_thread_name("_osmium_xml_in");
+
+                    expat_parser_type parser{&m_handler};
+
+                    if (parse_in_parallel()) {
+                        parse_input_in_chunks(parser);
+                    } else {
+                        parse_input(parser);
+                    }
 
-                    mark_header_as_done();
+                    set_header_value(m_handler.header());
 
-                    if (m_buffer.committed() > 0) {
-                        send_to_output_queue(std::move(m_buffer));
+                    if (m_handler.buffer().committed() > 0) {
+                        send_to_output_queue(std::move(m_handler.buffer()));
                     }
                 }
 
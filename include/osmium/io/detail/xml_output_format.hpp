@@ -151,7 +151,7 @@ namespace osmium {
 
                         if (object.timestamp()) {
                             *m_out += " timestamp=\"";
-                            *m_out += object.timestamp().to_iso();
+                            object.timestamp().to_iso(std::back_inserter(*m_out));
                             *m_out += "\"";
                         }
 
@@ -195,7 +195,7 @@ namespace osmium {
                         *m_out += " user=\"";
                         append_xml_encoded_string(*m_out, comment.user());
                         *m_out += "\" date=\"";
-                        *m_out += comment.date().to_iso();
+                        comment.date().to_iso(std::back_inserter(*m_out));
                         *m_out += "\">\n";
                         *m_out += "    <text>";
                         append_xml_encoded_string(*m_out, comment.text());
@@ -242,13 +242,14 @@ namespace osmium {
 
             public:
 
-                XMLOutputBlock(osmium::memory::Buffer&& buffer, const xml_output_options& options) :
-                    OutputBlock(std::move(buffer)),
+                XMLOutputBlock(osmium::memory::Buffer&& buffer, const xml_output_options& options, osmium::memory::BufferPool* buffer_pool = nullptr) :
+                    OutputBlock(std::move(buffer), buffer_pool),
                     m_options(options) {
                 }
 
                 std::string operator()() {
                     osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+                    m_input_buffer.reset();
 
                     if (m_options.use_change_ops) {
                         open_close_op_tag();
@@ -369,13 +370,13 @@ namespace osmium {
 
                     if (changeset.created_at()) {
                         *m_out += " created_at=\"";
-                        *m_out += changeset.created_at().to_iso();
+                        changeset.created_at().to_iso(std::back_inserter(*m_out));
                         *m_out += "\"";
                     }
 
                     if (changeset.closed_at()) {
                         *m_out += " closed_at=\"";
-                        *m_out += changeset.closed_at().to_iso();
+                        changeset.closed_at().to_iso(std::back_inserter(*m_out));
                         *m_out += "\" open=\"false\"";
                     } else {
                         *m_out += " open=\"true\"";
@@ -467,7 +468,7 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(buffer), m_options}));
+                    m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(buffer), m_options, m_buffer_pool}));
                 }
 
                 void write_end() final {
@@ -42,12 +42,21 @@ DEALINGS IN THE SOFTWARE.
  * @attention If you include this file, you'll need to link with `libz`.
  */
 
+#include <algorithm>
 #include <cerrno>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
 #include <string>
+#include <system_error>
+#include <utility>
 
 #ifndef _MSC_VER
 # include <unistd.h>
+#else
+# include <io.h>
 #endif
 
 #include <zlib.h>
@@ -57,8 +66,10 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/util/cast.hpp>
 #include <osmium/util/compatibility.hpp>
+#include <osmium/util/file.hpp>
 
 namespace osmium {
 
@@ -96,24 +107,318 @@ namespace osmium {
                 throw osmium::gzip_error{error, errnum};
             }
 
+            OSMIUM_NORETURN inline void throw_zlib_error(const z_stream& zstream, const char* msg, int zlib_error) {
+                std::string error{"gzip error: "};
+                error += msg;
+                error += ": ";
+                if (zstream.msg) {
+                    error += zstream.msg;
+                } else {
+                    error += std::to_string(zlib_error);
+                }
+                throw osmium::gzip_error{error, zlib_error};
+            }
+
+            // Each data chunk compressed or decompressed in parallel in
+            // the thread pool will be about this large.
+            enum constant_gzip_chunk_size : std::size_t {
+                gzip_chunk_size = 1024 * 1024
+            };
+
+            // The header written for members of gzip files compressed in
+            // parallel: The fixed part (10 bytes), the length of the extra
+            // field (2 bytes), and an extra subfield with id "OM" (4 bytes)
+            // containing the size of the whole member (4 bytes).
+            enum constant_gzip_sized_header_size : std::size_t {
+                gzip_sized_header_size = 20
+            };
+
+            inline uint32_t get_uint32_le(const unsigned char* data) noexcept {
+                return uint32_t(data[0]) |
+                       uint32_t(data[1]) << 8U |
+                       uint32_t(data[2]) << 16U |
+                       uint32_t(data[3]) << 24U;
+            }
+
+            inline void set_uint32_le(char* data, uint32_t value) noexcept {
+                for (int i = 0; i < 4; ++i) {
+                    data[i] = static_cast<char>(value & 0xffU);
+                    value >>= 8U;
+                }
+            }
+
+            inline bool is_gzip_magic(const char* data) noexcept {
+                return static_cast<unsigned char>(data[0]) == 0x1fU &&
+                       static_cast<unsigned char>(data[1]) == 0x8bU;
+            }
+
+            struct gzip_member_header {
+                // Size of the header, 0 if the data ended before the end
+                // of the header.
+                std::size_t header_size;
+                // Size of the whole member, 0 if it is not known.
+                std::size_t member_size;
+            }; // struct gzip_member_header
+
+            /**
+             * Parse the header of the gzip member at the start of the data.
+             * The size of the whole member is taken from a "BC" subfield
+             * (as used in BGZF files) or an "OM" subfield (as written by the
+             * GzipCompressor in parallel mode) in the extra field.
+             *
+             * @throws osmium::gzip_error if this is not a gzip header.
+             */
+            inline gzip_member_header parse_gzip_member_header(const char* data, std::size_t size) {
+                const auto* d = reinterpret_cast<const unsigned char*>(data);
+                gzip_member_header header{0, 0};
+
+                if (size < 10) {
+                    return header;
+                }
+                if (!is_gzip_magic(data) || d[2] != Z_DEFLATED) {
+                    throw osmium::gzip_error{"gzip error: invalid member header", Z_DATA_ERROR};
+                }
+
+                const unsigned int flags = d[3];
+                std::size_t pos = 10;
+                std::size_t member_size = 0;
+
+                if (flags & 0x04U) { // FEXTRA
+                    if (size < pos + 2) {
+                        return header;
+                    }
+                    const std::size_t extra_end = pos + 2 + (std::size_t(d[pos]) | std::size_t(d[pos + 1]) << 8U);
+                    if (size < extra_end) {
+                        return header;
+                    }
+                    pos += 2;
+                    while (pos + 4 <= extra_end) {
+                        const std::size_t length = std::size_t(d[pos + 2]) | std::size_t(d[pos + 3]) << 8U;
+                        if (pos + 4 + length > extra_end) {
+                            break;
+                        }
+                        if (d[pos] == 'B' && d[pos + 1] == 'C' && length == 2) {
+                            member_size = (std::size_t(d[pos + 4]) | std::size_t(d[pos + 5]) << 8U) + 1;
+                        } else if (d[pos] == 'O' && d[pos + 1] == 'M' && length == 4) {
+                            member_size = get_uint32_le(d + pos + 4);
+                        }
+                        pos += 4 + length;
+                    }
+                    pos = extra_end;
+                }
+
+                for (const unsigned int flag : {0x08U /* FNAME */, 0x10U /* FCOMMENT */}) {
+                    if (flags & flag) {
+                        const auto* end = static_cast<const unsigned char*>(std::memchr(d + pos, 0, size - pos));
+                        if (!end) {
+                            return header;
+                        }
+                        pos = std::size_t(end - d) + 1;
+                    }
+                }
+
+                if (flags & 0x02U) { // FHCRC
+                    pos += 2;
+                    if (size < pos) {
+                        return header;
+                    }
+                }
+
+                if (member_size != 0 && member_size < pos + 8) {
+                    throw osmium::gzip_error{"gzip error: invalid member size", Z_DATA_ERROR};
+                }
+
+                header.header_size = pos;
+                header.member_size = member_size;
+                return header;
+            }
+
+            /**
+             * Compresses data into one complete gzip member with the size
+             * of the member in the header. These are the tasks run in the
+             * thread pool by the GzipCompressor in parallel mode.
+             */
+            class GzipMemberCompressor {
+
+                std::string m_data;
+
+            public:
+
+                explicit GzipMemberCompressor(std::string&& data) :
+                    m_data(std::move(data)) {
+                }
+
+                std::string operator()() const {
+                    z_stream zstream{};
+                    int result = deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+                    if (result != Z_OK) {
+                        throw_zlib_error(zstream, "deflate init failed", result);
+                    }
+
+                    const auto bound = deflateBound(&zstream, static_cast_with_assert<uLong>(m_data.size()));
+                    std::string output(gzip_sized_header_size + bound + 8, '\0');
+
+                    zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(m_data.data()));
+                    zstream.avail_in = static_cast_with_assert<uInt>(m_data.size());
+                    zstream.next_out = reinterpret_cast<Bytef*>(&output[gzip_sized_header_size]);
+                    zstream.avail_out = static_cast_with_assert<uInt>(bound);
+                    result = deflate(&zstream, Z_FINISH);
+                    const std::size_t compressed_size = zstream.total_out;
+                    deflateEnd(&zstream);
+                    if (result != Z_STREAM_END) {
+                        throw_zlib_error(zstream, "deflate failed", result);
+                    }
+
+                    const std::size_t member_size = gzip_sized_header_size + compressed_size + 8;
+                    output.resize(member_size);
+
+                    // ID1, ID2, CM, FLG (FEXTRA), MTIME, XFL, OS (unknown),
+                    // XLEN, and subfield "OM" with length 4
+                    static const char header[] = "\x1f\x8b\x08\x04\0\0\0\0\0\xff\x08\0OM\x04\0";
+                    std::copy_n(header, sizeof(header) - 1, &output[0]);
+                    set_uint32_le(&output[16], static_cast_with_assert<uint32_t>(member_size));
+
+                    const auto crc = crc32(0, reinterpret_cast<const Bytef*>(m_data.data()), static_cast_with_assert<uInt>(m_data.size()));
+                    set_uint32_le(&output[member_size - 8], static_cast<uint32_t>(crc));
+                    set_uint32_le(&output[member_size - 4], static_cast<uint32_t>(m_data.size()));
+
+                    return output;
+                }
+
+            }; // class GzipMemberCompressor
+
+            /**
+             * Decompresses data consisting of complete gzip members with
+             * known sizes. These are the tasks run in the thread pool by
+             * the GzipDecompressor for files with such members.
+             */
+            class GzipMemberDecompressor {
+
+                std::string m_data;
+
+            public:
+
+                explicit GzipMemberDecompressor(std::string&& data) :
+                    m_data(std::move(data)) {
+                }
+
+                std::string operator()() const {
+                    const auto* data = reinterpret_cast<const unsigned char*>(m_data.data());
+
+                    // The uncompressed size of each member is in its
+                    // trailer, so the output can be allocated up front.
+                    std::size_t output_size = 0;
+                    for (std::size_t pos = 0; pos < m_data.size();) {
+                        const auto header = parse_gzip_member_header(m_data.data() + pos, m_data.size() - pos);
+                        pos += header.member_size;
+                        output_size += get_uint32_le(data + pos - 4);
+                    }
+                    std::string output(output_size, '\0');
+
+                    z_stream zstream{};
+                    int result = inflateInit2(&zstream, -MAX_WBITS);
+                    if (result != Z_OK) {
+                        throw_zlib_error(zstream, "inflate init failed", result);
+                    }
+
+                    std::size_t output_pos = 0;
+                    for (std::size_t pos = 0; pos < m_data.size();) {
+                        const auto header = parse_gzip_member_header(m_data.data() + pos, m_data.size() - pos);
+                        const unsigned char* trailer = data + pos + header.member_size - 8;
+                        const uint32_t size = get_uint32_le(trailer + 4);
+
+                        inflateReset(&zstream);
+                        zstream.next_in = const_cast<Bytef*>(data + pos + header.header_size);
+                        zstream.avail_in = static_cast_with_assert<uInt>(header.member_size - header.header_size - 8);
+                        zstream.next_out = reinterpret_cast<Bytef*>(&output[output_pos]);
+                        zstream.avail_out = size;
+                        result = inflate(&zstream, Z_FINISH);
+                        if (result != Z_STREAM_END || zstream.avail_out != 0 || zstream.avail_in != 0) {
+                            const z_stream failed = zstream;
+                            inflateEnd(&zstream);
+                            throw_zlib_error(failed, "inflate failed", result == Z_STREAM_END ? Z_DATA_ERROR : result);
+                        }
+
+                        const auto crc = crc32(0, reinterpret_cast<const Bytef*>(&output[output_pos]), size);
+                        if (static_cast<uint32_t>(crc) != get_uint32_le(trailer)) {
+                            inflateEnd(&zstream);
+                            throw osmium::gzip_error{"gzip error: crc mismatch", Z_DATA_ERROR};
+                        }
+
+                        output_pos += size;
+                        pos += header.member_size;
+                    }
+
+                    inflateEnd(&zstream);
+                    return output;
+                }
+
+            }; // class GzipMemberDecompressor
+
         } // namespace detail
 
+        /**
+         * Writes gzip compressed files. Normally this uses the gzip
+         * functions from zlib and writes a single gzip member. In parallel
+         * mode the data is split into chunks which are compressed into
+         * independent members in the thread pool. Each member has its
+         * size in the header, so the GzipDecompressor can find the
+         * members without decompressing and decompress them in parallel.
+         */
         class GzipCompressor : public Compressor {
 
+            // Maximum number of members compressed at the same time
+            // (per thread in the pool).
+            enum constant_max_members_per_thread : std::size_t {
+                max_members_per_thread = 2
+            };
+
             int m_fd;
-            gzFile m_gzfile;
+            gzFile m_gzfile = nullptr;
+
+            osmium::thread::Pool* m_pool = nullptr;
+            std::string m_data;
+            std::deque<std::future<std::string>> m_members;
+            bool m_written = false;
+
+            gzFile gzfile() {
+                if (!m_gzfile) {
+                    m_gzfile = ::gzdopen(::dup(m_fd), "w");
+                    if (!m_gzfile) {
+                        detail::throw_gzip_error(m_gzfile, "write initialization failed");
+                    }
+                }
+                return m_gzfile;
+            }
+
+            void write_members(std::size_t max_waiting) {
+                while (m_members.size() > max_waiting) {
+                    const std::string member{m_members.front().get()};
+                    m_members.pop_front();
+                    osmium::io::detail::reliable_write(m_fd, member.data(), member.size());
+                    m_written = true;
+                }
+            }
+
+            void submit_member() {
+                m_members.push_back(m_pool->submit(detail::GzipMemberCompressor{std::move(m_data)}));
+                m_data.clear();
+                write_members(max_members_per_thread * std::size_t(m_pool->num_threads()));
+            }
 
         public:
 
             explicit GzipCompressor(int fd, fsync sync) :
                 Compressor(sync),
-                m_fd(::dup(fd)),
-                m_gzfile(::gzdopen(fd, "w")) {
-                if (!m_gzfile) {
-                    detail::throw_gzip_error(m_gzfile, "write initialization failed");
-                }
+                m_fd(fd) {
             }
 
+            GzipCompressor(const GzipCompressor&) = delete;
+            GzipCompressor& operator=(const GzipCompressor&) = delete;
+
+            GzipCompressor(GzipCompressor&&) = delete;
+            GzipCompressor& operator=(GzipCompressor&&) = delete;
+
             ~GzipCompressor() noexcept final {
                 try {
                     close();
@@ -122,45 +427,291 @@ namespace osmium {
                 }
             }
 
+            void compress_in_parallel(osmium::thread::Pool& pool) final {
+                if (!m_gzfile) {
+                    m_pool = &pool;
+                }
+            }
+
             void write(const std::string& data) final {
-                if (!data.empty()) {
-                    const int nwrite = ::gzwrite(m_gzfile, data.data(), static_cast_with_assert<unsigned int>(data.size()));
-                    if (nwrite == 0) {
-                        detail::throw_gzip_error(m_gzfile, "write failed");
+                if (data.empty()) {
+                    return;
+                }
+                if (m_pool) {
+                    m_data += data;
+                    if (m_data.size() >= detail::gzip_chunk_size) {
+                        submit_member();
                     }
+                    return;
+                }
+                const int nwrite = ::gzwrite(gzfile(), data.data(), static_cast_with_assert<unsigned int>(data.size()));
+                if (nwrite == 0) {
+                    detail::throw_gzip_error(m_gzfile, "write failed");
                 }
             }
 
             void close() final {
-                if (m_gzfile) {
-                    const int result = ::gzclose(m_gzfile);
+                if (m_fd < 0) {
+                    return;
+                }
+                if (m_pool) {
+                    if (!m_data.empty()) {
+                        submit_member();
+                    }
+                    write_members(0);
+                    if (!m_written) {
+                        // Always write at least one member, so that the
+                        // result is a valid gzip file.
+                        const std::string member{detail::GzipMemberCompressor{std::string{}}()};
+                        osmium::io::detail::reliable_write(m_fd, member.data(), member.size());
+                    }
+                } else {
+                    const int result = ::gzclose(gzfile());
                     m_gzfile = nullptr;
                     if (result != Z_OK) {
                         detail::throw_gzip_error(m_gzfile, "write close failed", result);
                     }
-                    if (do_fsync()) {
-                        osmium::io::detail::reliable_fsync(m_fd);
-                    }
-                    osmium::io::detail::reliable_close(m_fd);
                 }
+                const int fd = m_fd;
+                m_fd = -1;
+                if (do_fsync()) {
+                    osmium::io::detail::reliable_fsync(fd);
+                }
+                osmium::io::detail::reliable_close(fd);
             }
 
         }; // class GzipCompressor
 
+        /**
+         * Reads gzip compressed files. If the file is a regular file and
+         * its first gzip member has its size in the header (this is the
+         * case for BGZF files and for files written by the GzipCompressor
+         * in parallel mode), the members are found without decompressing
+         * them and batches of members are decompressed in parallel in the
+         * thread pool (the default pool unless use_thread_pool() is
+         * called). Otherwise the gzip functions from zlib are used.
+         */
         class GzipDecompressor : public Decompressor {
 
-            gzFile m_gzfile;
+            // Maximum number of batches decompressed at the same time
+            // (per thread in the pool).
+            enum constant_max_batches_per_thread : std::size_t {
+                max_batches_per_thread = 2
+            };
+
+            int m_fd = -1;
+            gzFile m_gzfile = nullptr;
+
+            // Are the members decompressed in parallel in the pool?
+            bool m_parallel = false;
+
+            // The pool used or nullptr for the default pool.
+            osmium::thread::Pool* m_pool = nullptr;
+            std::deque<std::future<std::string>> m_batches;
+
+            // Data read from the file but not used yet starts at
+            // m_input_pos.
+            std::string m_input;
+            std::size_t m_input_pos = 0;
+            std::size_t m_offset = 0;
+            bool m_input_done = false;
+
+            // Used for members without size, they are decompressed in
+            // this thread.
+            z_stream m_zstream;
+            bool m_zstream_initialized = false;
+            bool m_in_unsized_member = false;
+
+            osmium::thread::Pool& pool() const {
+                return m_pool ? *m_pool : osmium::thread::Pool::default_instance();
+            }
+
+            std::size_t available() const noexcept {
+                return m_input.size() - m_input_pos;
+            }
+
+            const char* input() const noexcept {
+                return m_input.data() + m_input_pos;
+            }
+
+            // Make sure at least size bytes of input are available. Returns
+            // false if the end of file is reached before that.
+            bool fill_input(std::size_t size) {
+                while (available() < size) {
+                    if (m_input_done) {
+                        return false;
+                    }
+                    m_input.erase(0, m_input_pos);
+                    m_input_pos = 0;
+                    const std::size_t old_size = m_input.size();
+                    m_input.resize(old_size + osmium::io::Decompressor::input_buffer_size);
+                    const auto nread = ::read(m_fd, &m_input[old_size], osmium::io::Decompressor::input_buffer_size);
+                    if (nread < 0) {
+                        throw std::system_error{errno, std::system_category(), "Read failed"};
+                    }
+                    m_input.resize(old_size + std::size_t(nread));
+                    m_offset += std::size_t(nread);
+                    if (nread == 0) {
+                        m_input_done = true;
+                    }
+                }
+                return true;
+            }
+
+            // Collect complete members with known size into batches and
+            // submit them to the pool. Stops at a member without size or
+            // at the end of the input. Data after the last member that
+            // doesn't look like gzip is ignored like zlib does.
+            void submit_batches() {
+                const std::size_t max_batches = max_batches_per_thread * std::size_t(pool().num_threads());
+                while (!m_in_unsized_member && m_batches.size() < max_batches) {
+                    std::size_t batch_size = 0;
+                    while (batch_size < detail::gzip_chunk_size) {
+                        if (!fill_input(batch_size + 2) || !detail::is_gzip_magic(input() + batch_size)) {
+                            if (batch_size == 0) {
+                                m_input_pos = m_input.size();
+                                m_input_done = true;
+                            }
+                            break;
+                        }
+                        fill_input(batch_size + detail::gzip_sized_header_size);
+                        const auto header = detail::parse_gzip_member_header(input() + batch_size, available() - batch_size);
+                        if (header.header_size == 0) {
+                            if (!m_input_done) {
+                                // header larger than the input buffer
+                                fill_input(available() + osmium::io::Decompressor::input_buffer_size);
+                                continue;
+                            }
+                            throw osmium::gzip_error{"gzip error: unexpected end of file", Z_DATA_ERROR};
+                        }
+                        if (header.member_size == 0) {
+                            if (batch_size == 0) {
+                                start_unsized_member();
+                            }
+                            break;
+                        }
+                        if (!fill_input(batch_size + header.member_size)) {
+                            throw osmium::gzip_error{"gzip error: unexpected end of file", Z_DATA_ERROR};
+                        }
+                        batch_size += header.member_size;
+                    }
+                    if (batch_size == 0) {
+                        return;
+                    }
+                    m_batches.push_back(pool().submit(detail::GzipMemberDecompressor{std::string(input(), batch_size)}));
+                    m_input_pos += batch_size;
+                }
+            }
+
+            void start_unsized_member() {
+                if (m_zstream_initialized) {
+                    inflateReset(&m_zstream);
+                } else {
+                    const int result = inflateInit2(&m_zstream, 16 + MAX_WBITS);
+                    if (result != Z_OK) {
+                        detail::throw_zlib_error(m_zstream, "inflate init failed", result);
+                    }
+                    m_zstream_initialized = true;
+                }
+                m_in_unsized_member = true;
+            }
+
+            std::string read_unsized_member() {
+                std::string output(detail::gzip_chunk_size, '\0');
+                m_zstream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+                m_zstream.avail_out = static_cast_with_assert<uInt>(output.size());
+                while (m_zstream.avail_out > 0) {
+                    if (!fill_input(1)) {
+                        throw osmium::gzip_error{"gzip error: unexpected end of file", Z_DATA_ERROR};
+                    }
+                    m_zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input()));
+                    m_zstream.avail_in = static_cast_with_assert<uInt>(available());
+                    const int result = inflate(&m_zstream, Z_NO_FLUSH);
+                    m_input_pos = m_input.size() - m_zstream.avail_in;
+                    if (result == Z_STREAM_END) {
+                        m_in_unsized_member = false;
+                        break;
+                    }
+                    if (result != Z_OK) {
+                        detail::throw_zlib_error(m_zstream, "inflate failed", result);
+                    }
+                }
+                output.resize(output.size() - m_zstream.avail_out);
+                return output;
+            }
+
+            std::string read_members() {
+                while (true) {
+                    submit_batches();
+                    std::string output;
+                    if (!m_batches.empty()) {
+                        output = m_batches.front().get();
+                        m_batches.pop_front();
+                    } else if (m_in_unsized_member) {
+                        output = read_unsized_member();
+                    } else {
+                        return output;
+                    }
+                    set_offset(m_offset);
+                    if (!output.empty()) {
+                        return output;
+                    }
+                }
+            }
+
+            static bool starts_with_sized_member(const char* data, std::size_t size) {
+                if (size < 2 || !detail::is_gzip_magic(data)) {
+                    return false;
+                }
+                try {
+                    return detail::parse_gzip_member_header(data, size).member_size != 0;
+                } catch (const osmium::gzip_error&) {
+                    return false;
+                }
+            }
 
         public:
 
             explicit GzipDecompressor(int fd) :
                 Decompressor(),
-                m_gzfile(::gzdopen(fd, "r")) {
+                m_zstream() {
+                // Members can only be found without decompressing in
+                // regular files. For those we look at the first member
+                // and go back to the start of the file if it doesn't
+                // have a size.
+                if (osmium::util::file_size(fd) > 0) {
+                    const auto start = osmium::util::file_offset(fd);
+                    m_fd = fd;
+                    fill_input(detail::gzip_sized_header_size);
+                    if (starts_with_sized_member(input(), available())) {
+                        m_parallel = true;
+                        return;
+                    }
+#ifdef _MSC_VER
+                    const auto offset = _lseeki64(fd, static_cast<__int64>(start), SEEK_SET);
+#else
+                    const auto offset = ::lseek(fd, static_cast<off_t>(start), SEEK_SET);
+#endif
+                    if (offset < 0) {
+                        throw std::system_error{errno, std::system_category(), "Seek failed"};
+                    }
+                    m_fd = -1;
+                    m_input.clear();
+                    m_offset = 0;
+                    m_input_done = false;
+                }
+                m_gzfile = ::gzdopen(fd, "r");
                 if (!m_gzfile) {
                     detail::throw_gzip_error(m_gzfile, "read initialization failed");
                 }
             }
 
+            GzipDecompressor(const GzipDecompressor&) = delete;
+            GzipDecompressor& operator=(const GzipDecompressor&) = delete;
+
+            GzipDecompressor(GzipDecompressor&&) = delete;
+            GzipDecompressor& operator=(GzipDecompressor&&) = delete;
+
             ~GzipDecompressor() noexcept final {
                 try {
                     close();
@@ -169,7 +720,14 @@ namespace osmium {
                 }
             }
 
+            void use_thread_pool(osmium::thread::Pool& pool) final {
+                m_pool = &pool;
+            }
+
             std::string read() final {
+                if (m_parallel) {
+                    return read_members();
+                }
                 std::string buffer(osmium::io::Decompressor::input_buffer_size, '\0');
                 int nread = ::gzread(m_gzfile, const_cast<char*>(buffer.data()), static_cast_with_assert<unsigned int>(buffer.size()));
                 if (nread < 0) {
@@ -183,6 +741,15 @@ namespace osmium {
             }
 
             void close() final {
+                if (m_zstream_initialized) {
+                    m_zstream_initialized = false;
+                    inflateEnd(&m_zstream);
+                }
+                if (m_fd >= 0) {
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
                 if (m_gzfile) {
                     const int result = ::gzclose(m_gzfile);
                     m_gzfile = nullptr;
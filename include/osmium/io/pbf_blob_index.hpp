@@ -0,0 +1,411 @@
+#ifndef OSMIUM_IO_PBF_BLOB_INDEX_HPP
+#define OSMIUM_IO_PBF_BLOB_INDEX_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+/**
+ * @file
+ *
+ * Include this file if you want to create or use an index of the blobs
+ * in an OSM PBF file.
+ *
+ * @attention If you include this file, you'll need to link with
+ *            `libz`, and enable multithreading.
+ */
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifndef _MSC_VER
+# include <unistd.h>
+#else
+# include <io.h>
+#endif
+
+#include <protozero/types.hpp>
+
+#include <osmium/io/detail/mapped_input_file.hpp>
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Information about one OSMData blob in a PBF file.
+         */
+        struct pbf_blob_info {
+
+            /// Offset of the blob in the file (this is where the length
+            /// of the BlobHeader is stored).
+            uint64_t offset;
+
+            /// Size of the blob in the file including the BlobHeader and
+            /// its length.
+            uint32_t size;
+
+            /// Types of OSM entities in this blob.
+            osmium::osm_entity_bits::type types;
+
+        }; // struct pbf_blob_info
+
+        namespace detail {
+
+            // Decode a blob and find out which entity types are in it.
+            class PBFBlobTypeDecoder {
+
+                std::shared_ptr<MappedInputFile> m_mapped_input;
+                protozero::data_view m_data;
+
+            public:
+
+                PBFBlobTypeDecoder(std::shared_ptr<MappedInputFile> mapped_input, const protozero::data_view& data) :
+                    m_mapped_input(std::move(mapped_input)),
+                    m_data(data) {
+                }
+
+                osmium::osm_entity_bits::type operator()() {
+                    std::string output;
+                    return primitive_block_entity_types(decode_blob(m_data, output));
+                }
+
+            }; // class PBFBlobTypeDecoder
+
+            template <typename T>
+            inline void append_to_index_data(std::string& data, T value) {
+                data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+            }
+
+            template <typename T>
+            inline T read_from_index_data(const char** data) {
+                T value;
+                std::memcpy(&value, *data, sizeof(T));
+                *data += sizeof(T);
+                return value;
+            }
+
+        } // namespace detail
+
+        /**
+         * Index of all OSMData blobs in a PBF file with their position
+         * in the file and the types of OSM entities in them.
+         *
+         * The index can be created by scanning a PBF file (see scan()) or
+         * loaded from a small sidecar file written earlier with dump().
+         *
+         * Give the index to an osmium::io::Reader as additional argument.
+         * The Reader will then only decode the blobs listed in the index
+         * that contain entities of the types requested from the Reader.
+         * All other blobs are skipped without decompressing them. Use the
+         * "pbf_mmap" option on the file to make the Reader jump directly
+         * to the blobs it needs instead of reading over the others.
+         *
+         * Because the Reader only decodes blobs listed in the index, you
+         * can read disjoint parts of a file in several Readers (possibly
+         * in different threads) by giving each of them one of the indexes
+         * created by split().
+         */
+        class PBFBlobIndex {
+
+            static constexpr const char* magic = "OSMPBFI1";
+            static constexpr const std::size_t magic_size = 8;
+            static constexpr const std::size_t entry_size = sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint32_t);
+
+            std::vector<pbf_blob_info> m_blobs;
+
+            std::size_t m_file_size = 0;
+
+            static osmium::pbf_error format_error() {
+                return osmium::pbf_error{"truncated data (EOF encountered) while building blob index"};
+            }
+
+        public:
+
+            using const_iterator = std::vector<pbf_blob_info>::const_iterator;
+
+            PBFBlobIndex() = default;
+
+            /**
+             * Scan the given PBF file and create an index for it. Only the
+             * BlobHeaders are read in the thread calling this function.
+             * Files written by Osmium note the entity types of each blob
+             * in its BlobHeader, for other files the blobs are decoded in
+             * parallel on the thread pool to find out which types of
+             * entities are in them.
+             *
+             * The file must be a normal uncompressed PBF file, it is memory
+             * mapped for scanning.
+             *
+             * @param filename Name of the PBF file.
+             * @param pool Thread pool used for decoding the blobs.
+             * @throws osmium::pbf_error If the file is not a valid PBF file.
+             * @throws std::system_error If the file could not be opened or
+             *         mapped.
+             */
+            static PBFBlobIndex scan(const std::string& filename, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                const int fd = osmium::io::detail::open_for_reading(filename);
+                if (osmium::util::file_size(fd) == 0) {
+                    osmium::io::detail::reliable_close(fd);
+                    throw format_error();
+                }
+
+                std::shared_ptr<detail::MappedInputFile> input;
+                try {
+                    input = std::make_shared<detail::MappedInputFile>(fd);
+                } catch (...) {
+                    osmium::io::detail::reliable_close(fd);
+                    throw;
+                }
+                osmium::io::detail::reliable_close(fd);
+
+                PBFBlobIndex index;
+                index.m_file_size = input->size();
+
+                // Futures for the types of those blobs that have to be
+                // decoded to find out about them.
+                std::vector<std::pair<std::size_t, std::future<osmium::osm_entity_bits::type>>> types;
+                const char* expected_type = "OSMHeader";
+                std::size_t offset = 0;
+
+                while (offset < input->size()) {
+                    const std::size_t available = input->size() - offset;
+                    if (available < sizeof(uint32_t)) {
+                        throw format_error();
+                    }
+
+                    const uint32_t header_size = detail::decode_blob_header_size(input->data() + offset);
+                    if (header_size > static_cast<uint32_t>(detail::max_blob_header_size)) {
+                        throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                    }
+                    if (available - sizeof(uint32_t) < header_size) {
+                        throw format_error();
+                    }
+
+                    const char* header_data = input->data() + offset + sizeof(uint32_t);
+                    const auto header = detail::decode_blob_header(protozero::data_view{header_data, header_size}, expected_type);
+                    const std::size_t blob_size = header.datasize;
+                    if (blob_size > detail::max_uncompressed_blob_size) {
+                        throw osmium::pbf_error{std::string{"invalid blob size: "} + std::to_string(blob_size)};
+                    }
+                    if (available - sizeof(uint32_t) - header_size < blob_size) {
+                        throw format_error();
+                    }
+
+                    const auto size = static_cast<uint32_t>(sizeof(uint32_t) + header_size + blob_size);
+
+                    // The first blob is always the OSMHeader blob which is
+                    // not part of the index.
+                    // If the BlobHeader already tells us the entity types,
+                    // there is no need to decode the blob.
+                    if (offset != 0) {
+                        index.m_blobs.push_back(pbf_blob_info{offset, size, header.types});
+                        if (header.types == osmium::osm_entity_bits::nothing) {
+                            types.emplace_back(index.m_blobs.size() - 1, pool.submit(detail::PBFBlobTypeDecoder{input, protozero::data_view{header_data + header_size, blob_size}}));
+                        }
+                    }
+
+                    expected_type = "OSMData";
+                    offset += size;
+                }
+
+                for (auto& type : types) {
+                    index.m_blobs[type.first].types = type.second.get();
+                }
+
+                return index;
+            }
+
+            /**
+             * Load an index written earlier with dump().
+             *
+             * @param fd File descriptor to read the index from.
+             * @throws osmium::pbf_error If the index file is invalid.
+             * @throws std::system_error If the file could not be read.
+             */
+            static PBFBlobIndex load(const int fd) {
+                std::string data;
+                char buffer[64 * 1024];
+                while (true) {
+                    const auto nread = ::read(fd, buffer, sizeof(buffer));
+                    if (nread < 0) {
+                        throw std::system_error{errno, std::system_category(), "Read failed"};
+                    }
+                    if (nread == 0) {
+                        break;
+                    }
+                    data.append(buffer, static_cast<std::size_t>(nread));
+                }
+
+                const std::size_t header_size = magic_size + sizeof(uint64_t) + sizeof(uint64_t);
+                if (data.size() < header_size || std::strncmp(data.data(), magic, magic_size)) {
+                    throw osmium::pbf_error{"invalid blob index file"};
+                }
+
+                const char* ptr = data.data() + magic_size;
+
+                PBFBlobIndex index;
+                index.m_file_size = static_cast<std::size_t>(detail::read_from_index_data<uint64_t>(&ptr));
+                const auto count = detail::read_from_index_data<uint64_t>(&ptr);
+
+                if ((data.size() - header_size) / entry_size != count ||
+                    (data.size() - header_size) % entry_size != 0) {
+                    throw osmium::pbf_error{"invalid blob index file"};
+                }
+
+                index.m_blobs.reserve(static_cast<std::size_t>(count));
+                for (uint64_t i = 0; i < count; ++i) {
+                    const auto offset = detail::read_from_index_data<uint64_t>(&ptr);
+                    const auto size = detail::read_from_index_data<uint32_t>(&ptr);
+                    const auto types = detail::read_from_index_data<uint32_t>(&ptr);
+                    if (types & ~uint32_t(osmium::osm_entity_bits::all)) {
+                        throw osmium::pbf_error{"invalid blob index file"};
+                    }
+                    index.m_blobs.push_back(pbf_blob_info{offset, size, static_cast<osmium::osm_entity_bits::type>(types)});
+                }
+
+                return index;
+            }
+
+            /**
+             * Write the index to a file so it can be loaded again with
+             * load(). The data is written in the native byte order of the
+             * machine like all other on-disk indexes in Osmium.
+             *
+             * @param fd File descriptor to write the index to.
+             * @throws std::system_error If the file could not be written.
+             */
+            void dump(const int fd) const {
+                std::string data{magic, magic_size};
+                data.reserve(magic_size + 2 * sizeof(uint64_t) + m_blobs.size() * entry_size);
+
+                detail::append_to_index_data<uint64_t>(data, m_file_size);
+                detail::append_to_index_data<uint64_t>(data, m_blobs.size());
+                for (const auto& blob : m_blobs) {
+                    detail::append_to_index_data<uint64_t>(data, blob.offset);
+                    detail::append_to_index_data<uint32_t>(data, blob.size);
+                    detail::append_to_index_data<uint32_t>(data, blob.types);
+                }
+
+                osmium::io::detail::reliable_write(fd, data.data(), data.size());
+            }
+
+            /**
+             * Split this index into (at most) the given number of indexes
+             * covering disjoint consecutive ranges of the file. The ranges
+             * will contain roughly the same number of bytes. Only blobs
+             * containing any of the given entity types are taken into
+             * account.
+             */
+            std::vector<PBFBlobIndex> split(std::size_t num_parts, osmium::osm_entity_bits::type types = osmium::osm_entity_bits::all) const {
+                std::vector<PBFBlobIndex> parts;
+                if (num_parts == 0) {
+                    return parts;
+                }
+
+                uint64_t total_size = 0;
+                for (const auto& blob : m_blobs) {
+                    if (blob.types & types) {
+                        total_size += blob.size;
+                    }
+                }
+
+                uint64_t size = 0;
+                for (const auto& blob : m_blobs) {
+                    if (!(blob.types & types)) {
+                        continue;
+                    }
+                    if (parts.empty() || (size >= total_size * parts.size() / num_parts && parts.size() < num_parts)) {
+                        parts.emplace_back();
+                        parts.back().m_file_size = m_file_size;
+                    }
+                    parts.back().m_blobs.push_back(blob);
+                    size += blob.size;
+                }
+
+                return parts;
+            }
+
+            /// The size of the PBF file this index was created for.
+            std::size_t file_size() const noexcept {
+                return m_file_size;
+            }
+
+            /// The number of blobs in the index.
+            std::size_t size() const noexcept {
+                return m_blobs.size();
+            }
+
+            bool empty() const noexcept {
+                return m_blobs.empty();
+            }
+
+            /// The types of all OSM entities in all blobs in the index.
+            osmium::osm_entity_bits::type types() const noexcept {
+                osmium::osm_entity_bits::type result = osmium::osm_entity_bits::nothing;
+                for (const auto& blob : m_blobs) {
+                    result |= blob.types;
+                }
+                return result;
+            }
+
+            const_iterator begin() const noexcept {
+                return m_blobs.cbegin();
+            }
+
+            const_iterator end() const noexcept {
+                return m_blobs.cend();
+            }
+
+            const pbf_blob_info& operator[](std::size_t n) const noexcept {
+                return m_blobs[n];
+            }
+
+        }; // class PBFBlobIndex
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_BLOB_INDEX_HPP
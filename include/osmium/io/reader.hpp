@@ -53,17 +53,22 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/input_format.hpp>
+#include <osmium/io/detail/mapped_input_file.hpp>
 #include <osmium/io/detail/read_thread.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/file.hpp>
 
 namespace osmium {
 
@@ -108,9 +113,14 @@ namespace osmium {
 
             detail::future_string_queue_type m_input_queue;
 
+            // If this is set, the parser reads the input file through this
+            // memory mapping and m_decompressor and m_read_thread_manager
+            // are not used.
+            std::shared_ptr<detail::MappedInputFile> m_mapped_input;
+
             std::unique_ptr<osmium::io::Decompressor> m_decompressor;
 
-            osmium::io::detail::ReadThreadManager m_read_thread_manager;
+            std::unique_ptr<osmium::io::detail::ReadThreadManager> m_read_thread_manager;
 
             detail::future_buffer_queue_type m_osmdata_queue;
             detail::queue_wrapper<osmium::memory::Buffer> m_osmdata_queue_wrapper;
@@ -125,6 +135,10 @@ namespace osmium {
             osmium::osm_entity_bits::type m_read_which_entities = osmium::osm_entity_bits::all;
             osmium::io::read_meta m_read_metadata = osmium::io::read_meta::yes;
 
+            const osmium::io::PBFBlobIndex* m_blob_index = nullptr;
+
+            osmium::memory::BufferPool* m_buffer_pool = nullptr;
+
             void set_option(osmium::thread::Pool& pool) noexcept {
                 m_pool = &pool;
             }
@@ -137,6 +151,17 @@ namespace osmium {
                 m_read_metadata = value;
             }
 
+            void set_option(const osmium::io::PBFBlobIndex& index) noexcept {
+                m_blob_index = &index;
+            }
+
+            // The index must outlive the Reader, so don't accept temporaries.
+            void set_option(osmium::io::PBFBlobIndex&& index) = delete;
+
+            void set_option(osmium::memory::BufferPool& buffer_pool) noexcept {
+                m_buffer_pool = &buffer_pool;
+            }
+
             // This function will run in a separate thread.
             static void parser_thread(osmium::thread::Pool& pool,
                                       const detail::ParserFactory::create_parser_type& creator,
@@ -144,7 +169,11 @@ namespace osmium {
                                       detail::future_buffer_queue_type& osmdata_queue,
                                       std::promise<osmium::io::Header>&& header_promise,
                                       osmium::osm_entity_bits::type read_which_entities,
-                                      osmium::io::read_meta read_metadata) {
+                                      osmium::io::read_meta read_metadata,
+                                      const std::shared_ptr<detail::MappedInputFile>& mapped_input,
+                                      const osmium::io::PBFBlobIndex* blob_index,
+                                      bool parallel,
+                                      osmium::memory::BufferPool* buffer_pool) {
                 std::promise<osmium::io::Header> promise{std::move(header_promise)};
                 osmium::io::detail::parser_arguments args = {
                     pool,
@@ -152,7 +181,11 @@ namespace osmium {
                     osmdata_queue,
                     promise,
                     read_which_entities,
-                    read_metadata
+                    read_metadata,
+                    mapped_input,
+                    blob_index,
+                    parallel,
+                    buffer_pool
                 };
                 creator(args)->parse();
             }
@@ -226,6 +259,47 @@ namespace osmium {
                 return osmium::io::detail::open_for_reading(filename);
             }
 
+            /**
+             * Should the input file be memory mapped and handed to the
+             * parser directly instead of being read through the
+             * decompressor and the input queue? This is only done if the
+             * user asked for it with the "pbf_mmap" option, for
+             * uncompressed PBF files, and only if the file descriptor
+             * refers to a non-empty file. Pipes (and stdin) report a size
+             * of zero and are never mapped.
+             */
+            static bool use_mapped_input(const osmium::io::File& file, int fd) {
+                return file.format() == osmium::io::file_format::pbf &&
+                       file.compression() == osmium::io::file_compression::none &&
+                       file.is_true("pbf_mmap") &&
+                       osmium::util::file_size(fd) > 0;
+            }
+
+            /**
+             * Open the input. Returns the decompressor that should be used
+             * to read the data or nullptr if m_mapped_input was set up
+             * instead.
+             */
+            std::unique_ptr<osmium::io::Decompressor> open_input() {
+                if (m_file.buffer()) {
+                    return osmium::io::CompressionFactory::instance().create_decompressor(m_file.compression(), m_file.buffer(), m_file.buffer_size());
+                }
+
+                const int fd = open_input_file_or_url(m_file.filename(), &m_childpid);
+                if (m_childpid == 0 && use_mapped_input(m_file, fd)) {
+                    try {
+                        m_mapped_input = std::make_shared<detail::MappedInputFile>(fd);
+                    } catch (...) {
+                        osmium::io::detail::reliable_close(fd);
+                        throw;
+                    }
+                    osmium::io::detail::reliable_close(fd);
+                    return nullptr;
+                }
+
+                return osmium::io::CompressionFactory::instance().create_decompressor(m_file.compression(), fd);
+            }
+
         public:
 
             /**
@@ -247,6 +321,38 @@ namespace osmium {
              *      etc.) is not read possibly speeding up the read. Not all
              *      file formats use this setting.
              *
+             * If the file is an uncompressed PBF file and the "pbf_mmap"
+             * option is set on the File (for instance by using the format
+             * string "pbf,pbf_mmap=true"), the file is memory mapped and
+             * the data blobs are decoded straight from the mapping without
+             * copying them around first.
+             *
+             * If the file is an XML file and the "xml_parallel" option is
+             * set (for instance by using the format string
+             * "osm,xml_parallel=true"), the input is split into chunks at
+             * the start of OSM objects which are parsed in parallel in the
+             * thread pool. This is not done for change files and files
+             * with a DOCTYPE, namespace declarations, or an encoding other
+             * than UTF-8, those are always parsed in one thread.
+             *
+             * * osmium::io::PBFBlobIndex: Only decode the blobs listed in
+             *      this index that contain any of the OSM entities to be
+             *      read, all other blobs are skipped. The index must have
+             *      been created for the same file and must outlive the
+             *      Reader. Only used for PBF files, best together with the
+             *      "pbf_mmap" option.
+             *
+             * * osmium::thread::Pool: Use this thread pool for parsing and
+             *      decompressing the data instead of the default pool.
+             *      The pool must outlive the Reader.
+             *
+             * * osmium::memory::BufferPool: Get the buffers the data is
+             *      decoded into from this pool instead of allocating new
+             *      ones. Put the buffers back into the pool when you are
+             *      done with them (or give the same pool to the Writer you
+             *      are writing them with). The pool must outlive the
+             *      Reader.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
@@ -257,28 +363,39 @@ namespace osmium {
                 m_status(status::okay),
                 m_childpid(0),
                 m_input_queue(detail::get_input_queue_size(), "raw_input"),
-                m_decompressor(m_file.buffer() ?
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), m_file.buffer(), m_file.buffer_size()) :
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), open_input_file_or_url(m_file.filename(), &m_childpid))),
-                m_read_thread_manager(*m_decompressor, m_input_queue),
+                m_mapped_input(),
+                m_decompressor(open_input()),
+                m_read_thread_manager(),
                 m_osmdata_queue(detail::get_osmdata_queue_size(), "parser_results"),
                 m_osmdata_queue_wrapper(m_osmdata_queue),
                 m_header_future(),
                 m_header(),
                 m_thread(),
-                m_file_size(m_decompressor->file_size()) {
+                m_file_size(m_mapped_input ? m_mapped_input->size() : m_decompressor->file_size()) {
 
                 (void)std::initializer_list<int>{
                     (set_option(args), 0)...
                 };
 
+                if (m_mapped_input) {
+                    // The parser doesn't need the input queue in this case.
+                    detail::add_end_of_data_to_queue(m_input_queue);
+                }
+
                 if (!m_pool) {
                     m_pool = &thread::Pool::default_instance();
                 }
 
+                // The read thread is only started here, because the
+                // decompressor must get the pool before the first read().
+                if (m_decompressor) {
+                    m_decompressor->use_thread_pool(*m_pool);
+                    m_read_thread_manager.reset(new detail::ReadThreadManager{*m_decompressor, m_input_queue});
+                }
+
                 std::promise<osmium::io::Header> header_promise;
                 m_header_future = header_promise.get_future();
-                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(*m_pool), std::ref(m_creator), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_read_metadata};
+                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(*m_pool), std::ref(m_creator), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_read_metadata, m_mapped_input, m_blob_index, m_file.is_true("xml_parallel"), m_buffer_pool};
             }
 
             template <typename... TArgs>
@@ -316,12 +433,18 @@ namespace osmium {
             void close() {
                 m_status = status::closed;
 
-                m_read_thread_manager.stop();
+                if (m_mapped_input) {
+                    m_mapped_input->stop();
+                } else {
+                    m_read_thread_manager->stop();
+                }
 
                 m_osmdata_queue_wrapper.drain();
 
                 try {
-                    m_read_thread_manager.close();
+                    if (m_read_thread_manager) {
+                        m_read_thread_manager->close();
+                    }
                 } catch (...) {
                     // Ignore any exceptions.
                 }
@@ -394,7 +517,9 @@ namespace osmium {
                         buffer = m_osmdata_queue_wrapper.pop();
                         if (detail::at_end_of_data(buffer)) {
                             m_status = status::eof;
-                            m_read_thread_manager.close();
+                            if (m_read_thread_manager) {
+                                m_read_thread_manager->close();
+                            }
                             return buffer;
                         }
                         if (buffer.committed() > 0) {
@@ -439,6 +564,9 @@ namespace osmium {
              * do an expensive system call.
              */
             std::size_t offset() const noexcept {
+                if (m_mapped_input) {
+                    return m_mapped_input->offset();
+                }
                 return m_decompressor->offset();
             }
 
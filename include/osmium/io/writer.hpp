@@ -53,6 +53,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/header.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
@@ -112,6 +113,8 @@ namespace osmium {
 
             size_t m_buffer_size;
 
+            osmium::memory::BufferPool* m_buffer_pool;
+
             std::future<bool> m_write_future;
 
             osmium::thread::thread_handler m_thread;
@@ -141,8 +144,7 @@ namespace osmium {
             void do_flush() {
                 osmium::thread::check_for_exception(m_write_future);
                 if (m_buffer && m_buffer.committed() > 0) {
-                    osmium::memory::Buffer buffer{m_buffer_size,
-                                                  osmium::memory::Buffer::auto_grow::no};
+                    osmium::memory::Buffer buffer{new_buffer()};
                     using std::swap;
                     swap(m_buffer, buffer);
 
@@ -150,6 +152,10 @@ namespace osmium {
                 }
             }
 
+            osmium::memory::Buffer new_buffer() {
+                return osmium::memory::detail::get_buffer(m_buffer_pool, m_buffer_size, osmium::memory::Buffer::auto_grow::no);
+            }
+
             template <typename TFunction, typename... TArgs>
             void ensure_cleanup(TFunction func, TArgs&&... args) {
                 if (m_status != status::okay) {
@@ -171,12 +177,17 @@ namespace osmium {
                 overwrite allow_overwrite = overwrite::no;
                 fsync sync = fsync::no;
                 osmium::thread::Pool* pool = nullptr;
+                osmium::memory::BufferPool* buffer_pool = nullptr;
             };
 
             static void set_option(options_type& options, osmium::thread::Pool& pool) {
                 options.pool = &pool;
             }
 
+            static void set_option(options_type& options, osmium::memory::BufferPool& buffer_pool) {
+                options.buffer_pool = &buffer_pool;
+            }
+
             static void set_option(options_type& options, const osmium::io::Header& header) {
                 options.header = header;
             }
@@ -222,6 +233,14 @@ namespace osmium {
              *       before closing it? Can be osmium::io::fsync::yes or
              *       osmium::io::fsync::no (default).
              *
+             * * osmium::memory::BufferPool: Put the buffers back into this
+             *       pool after they have been written and get the internal
+             *       buffer from it. The pool must outlive the Writer.
+             *
+             * If the file is gzip compressed and the "parallel_compression"
+             * option is set on the file, the data is compressed in chunks
+             * in the thread pool.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
@@ -232,6 +251,7 @@ namespace osmium {
                 m_output(nullptr),
                 m_buffer(),
                 m_buffer_size(default_buffer_size),
+                m_buffer_pool(nullptr),
                 m_write_future(),
                 m_thread(),
                 m_status(status::okay) {
@@ -247,6 +267,8 @@ namespace osmium {
                 }
 
                 m_output = osmium::io::detail::OutputFormatFactory::instance().create_output(*options.pool, m_file, m_output_queue);
+                m_buffer_pool = options.buffer_pool;
+                m_output->set_buffer_pool(m_buffer_pool);
 
                 if (options.header.get("generator").empty()) {
                     options.header.set("generator", "libosmium/" LIBOSMIUM_VERSION_STRING);
@@ -256,6 +278,9 @@ namespace osmium {
                     CompressionFactory::instance().create_compressor(file.compression(),
                                                                      osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite),
                                                                      options.sync);
+                if (m_file.is_true("parallel_compression")) {
+                    compressor->compress_in_parallel(*options.pool);
+                }
 
                 std::promise<bool> write_promise;
                 m_write_future = write_promise.get_future();
@@ -343,8 +368,7 @@ namespace osmium {
             void operator()(const osmium::memory::Item& item) {
                 ensure_cleanup([&](){
                     if (!m_buffer) {
-                        m_buffer = osmium::memory::Buffer{m_buffer_size,
-                                                          osmium::memory::Buffer::auto_grow::no};
+                        m_buffer = new_buffer();
                     }
                     try {
                         m_buffer.push_back(item);
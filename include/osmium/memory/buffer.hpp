@@ -69,6 +69,8 @@ namespace osmium {
      */
     namespace memory {
 
+        class BufferPool;
+
         /**
          * A memory area for storing OSM objects and other items. Each item stored
          * has a type and a length. See the Item class for details.
@@ -97,6 +99,8 @@ namespace osmium {
          */
         class Buffer {
 
+            friend class BufferPool;
+
         public:
 
             // This is needed so we can call std::back_inserter() on a Buffer.
@@ -0,0 +1,270 @@
+#ifndef OSMIUM_MEMORY_BUFFER_POOL_HPP
+#define OSMIUM_MEMORY_BUFFER_POOL_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * Statistics about the use of a BufferPool.
+         */
+        struct buffer_pool_stats {
+
+            /// The number of buffers newly allocated by get().
+            std::size_t allocated;
+
+            /// The number of buffers get() could take from the pool.
+            std::size_t reused;
+
+            /// The number of buffers put back into the pool.
+            std::size_t returned;
+
+            /// The number of buffers thrown away because the pool was full
+            /// or they were too small.
+            std::size_t dropped;
+
+        }; // struct buffer_pool_stats
+
+        /**
+         * A pool of buffers that can be used again instead of allocating
+         * new memory for every buffer and freeing it again after use.
+         *
+         * Get a buffer with get() and give it back with put() when you
+         * are done with it. Buffers given back are cleared and handed out
+         * again by later get() calls asking for at most their capacity.
+         * All functions of this class are thread safe.
+         *
+         * The Reader, the Writer, and the CallbackBuffer can use a pool.
+         * Give the same pool to a Reader and a Writer and the buffers
+         * read are put back into the pool when they have been written.
+         *
+         * Example:
+         * @code
+         *     osmium::memory::BufferPool pool;
+         *     osmium::io::Reader reader{"input.osm.pbf", pool};
+         *     while (osmium::memory::Buffer buffer = reader.read()) {
+         *         ...handle buffer...
+         *         pool.put(std::move(buffer));
+         *     }
+         * @endcode
+         */
+        class BufferPool {
+
+            static constexpr const std::size_t default_max_buffers = 64;
+
+            mutable std::mutex m_mutex;
+            std::vector<Buffer> m_buffers;
+            std::size_t m_max_buffers;
+            buffer_pool_stats m_stats;
+
+        public:
+
+            /**
+             * Create a buffer pool.
+             *
+             * @param max_buffers The maximum number of buffers kept in the
+             *                    pool. Buffers put back into a full pool
+             *                    are freed.
+             */
+            explicit BufferPool(std::size_t max_buffers = default_max_buffers) :
+                m_mutex(),
+                m_buffers(),
+                m_max_buffers(max_buffers),
+                m_stats{0, 0, 0, 0} {
+                m_buffers.reserve(max_buffers);
+            }
+
+            BufferPool(const BufferPool&) = delete;
+            BufferPool& operator=(const BufferPool&) = delete;
+
+            BufferPool(BufferPool&&) = delete;
+            BufferPool& operator=(BufferPool&&) = delete;
+
+            ~BufferPool() = default;
+
+            /**
+             * Get an empty buffer with at least the given capacity. Takes
+             * a buffer from the pool if there is one large enough,
+             * otherwise a new buffer is allocated.
+             *
+             * @param capacity The minimum capacity of the buffer.
+             * @param auto_grow Should the buffer automatically grow when
+             *        it becomes too small?
+             */
+            Buffer get(std::size_t capacity, Buffer::auto_grow auto_grow = Buffer::auto_grow::yes) {
+                Buffer buffer;
+                Buffer oldest;
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+
+                    // Look at the buffers put back last first, their
+                    // memory is more likely to be in the cache.
+                    for (auto it = m_buffers.rbegin(); it != m_buffers.rend(); ++it) {
+                        if (it->capacity() >= capacity) {
+                            buffer = std::move(*it);
+                            m_buffers.erase(std::next(it).base());
+                            ++m_stats.reused;
+                            break;
+                        }
+                    }
+
+                    if (!buffer) {
+                        ++m_stats.allocated;
+                        if (!m_buffers.empty()) {
+                            // None of the buffers is large enough, so make
+                            // room for a larger one by dropping the oldest.
+                            // It is freed after the lock is released.
+                            oldest = std::move(m_buffers.front());
+                            m_buffers.erase(m_buffers.begin());
+                            ++m_stats.dropped;
+                        }
+                    }
+                }
+
+                if (buffer) {
+                    buffer.m_auto_grow = auto_grow;
+                    return buffer;
+                }
+
+                return Buffer{capacity, auto_grow};
+            }
+
+            /**
+             * Put a buffer back into the pool. The buffer is cleared. Invalid
+             * buffers and buffers using external memory management are
+             * ignored.
+             *
+             * @pre No builder can be open on the buffer.
+             */
+            void put(Buffer&& buffer) {
+                if (!buffer || !buffer.m_memory) {
+                    return;
+                }
+
+                buffer.clear();
+                buffer.m_full = nullptr;
+
+                std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_buffers.size() < m_max_buffers) {
+                    m_buffers.push_back(std::move(buffer));
+                    ++m_stats.returned;
+                } else {
+                    ++m_stats.dropped;
+                }
+            }
+
+            /**
+             * Move the buffer into a shared_ptr that puts the buffer back
+             * into this pool when the last reference to it is gone.
+             */
+            std::shared_ptr<Buffer> share(Buffer&& buffer) {
+                return std::shared_ptr<Buffer>{new Buffer{std::move(buffer)}, [this](Buffer* ptr) {
+                    try {
+                        put(std::move(*ptr));
+                    } catch (...) {
+                        // Ignore any exceptions, the buffer is freed then.
+                    }
+                    delete ptr;
+                }};
+            }
+
+            /**
+             * The number of buffers currently in the pool.
+             */
+            std::size_t size() const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_buffers.size();
+            }
+
+            /**
+             * Free all buffers currently in the pool.
+             */
+            void clear() {
+                std::vector<Buffer> buffers;
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    using std::swap;
+                    swap(buffers, m_buffers);
+                }
+            }
+
+            buffer_pool_stats stats() const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_stats;
+            }
+
+        }; // class BufferPool
+
+        namespace detail {
+
+            /**
+             * Get a buffer from the pool or, if there is no pool, allocate
+             * a new one.
+             */
+            inline Buffer get_buffer(BufferPool* pool, std::size_t capacity, Buffer::auto_grow auto_grow = Buffer::auto_grow::yes) {
+                if (pool) {
+                    return pool->get(capacity, auto_grow);
+                }
+                return Buffer{capacity, auto_grow};
+            }
+
+            /**
+             * Move the buffer into a shared_ptr that puts it back into the
+             * pool (if there is one) when it is not used any more.
+             */
+            inline std::shared_ptr<Buffer> share_buffer(BufferPool* pool, Buffer&& buffer) {
+                if (pool) {
+                    return pool->share(std::move(buffer));
+                }
+                return std::make_shared<Buffer>(std::move(buffer));
+            }
+
+        } // namespace detail
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_POOL_HPP
@@ -38,6 +38,7 @@ DEALINGS IN THE SOFTWARE.
 #include <utility>
 
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 
 namespace osmium {
 
@@ -83,6 +84,7 @@ namespace osmium {
             std::size_t m_initial_buffer_size;
             std::size_t m_max_buffer_size;
             callback_func_type m_callback;
+            osmium::memory::BufferPool* m_buffer_pool = nullptr;
 
         public:
 
@@ -140,6 +142,20 @@ namespace osmium {
                 m_callback = callback;
             }
 
+            /**
+             * Set a buffer pool. New internal buffers are taken from this
+             * pool instead of being allocated. The callback (or whoever
+             * calls read()) should put the buffers back into the pool
+             * when done with them. The pool must outlive the
+             * CallbackBuffer.
+             *
+             * @param buffer_pool The buffer pool or nullptr to allocate
+             *                    new buffers again.
+             */
+            void set_buffer_pool(osmium::memory::BufferPool* buffer_pool) noexcept {
+                m_buffer_pool = buffer_pool;
+            }
+
             /**
              * Flush the internal buffer regardless of how full it is. Calls
              * the callback with the buffer and creates an new empty internal
@@ -174,7 +190,7 @@ namespace osmium {
              * callback.
              */
             osmium::memory::Buffer read() {
-                osmium::memory::Buffer buffer{m_initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                osmium::memory::Buffer buffer{osmium::memory::detail::get_buffer(m_buffer_pool, m_initial_buffer_size)};
                 using std::swap;
                 swap(buffer, m_buffer);
                 return buffer;
@@ -66,9 +66,65 @@ namespace osmium {
 
         constexpr const int coordinate_precision = 10000000;
 
+        inline bool is_digit(const char c) noexcept {
+            return static_cast<unsigned int>(c - '0') < 10;
+        }
+
+        // Fast path for converting the usual coordinate format with one to
+        // three digits before and, optionally, a decimal point and one to
+        // eight digits after it. Returns false without changing anything
+        // if the string is in any other format or out of range, it has to
+        // be handled by the general function then.
+        inline bool fast_string_to_location_coordinate(const char** data, int32_t* value) noexcept {
+            static const int64_t scales[] = {
+                100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1
+            };
+
+            const char* str = *data;
+            const bool negative = (*str == '-');
+            str += negative ? 1 : 0;
+
+            int64_t result = 0;
+            int digits = 0;
+            for (; digits < 3 && is_digit(*str); ++digits, ++str) {
+                result = result * 10 + (*str - '0');
+            }
+            if (digits == 0 || is_digit(*str)) {
+                return false;
+            }
+
+            int decimals = 0;
+            if (*str == '.') {
+                ++str;
+                for (; decimals < 8 && is_digit(*str); ++decimals, ++str) {
+                    result = result * 10 + (*str - '0');
+                }
+                if (decimals == 0 || is_digit(*str)) {
+                    return false;
+                }
+            }
+
+            if (*str == 'e' || *str == 'E') {
+                return false;
+            }
+
+            // scale to eight decimals (one more than the precision) and
+            // round to the precision
+            result = (result * scales[decimals] + 5) / 10;
+            if (result > std::numeric_limits<int32_t>::max()) {
+                return false;
+            }
+
+            *value = static_cast<int32_t>(negative ? -result : result);
+            *data = str;
+            return true;
+        }
+
         // Convert string with a floating point number into integer suitable
-        // for use as coordinate in a Location.
-        inline int32_t string_to_location_coordinate(const char** data) {
+        // for use as coordinate in a Location. This handles all formats,
+        // use string_to_location_coordinate() which is faster in the usual
+        // cases.
+        inline int32_t general_string_to_location_coordinate(const char** data) {
             const char* str = *data;
             const char* full = str;
 
@@ -196,6 +252,16 @@ namespace osmium {
             throw invalid_location{std::string{"wrong format for coordinate: '"} + full + "'"};
         }
 
+        // Convert string with a floating point number into integer suitable
+        // for use as coordinate in a Location.
+        inline int32_t string_to_location_coordinate(const char** data) {
+            int32_t value;
+            if (fast_string_to_location_coordinate(data, &value)) {
+                return value;
+            }
+            return general_string_to_location_coordinate(data);
+        }
+
         // Convert integer as used by location for coordinates into a string.
         template <typename T>
         inline T append_location_coordinate_to_string(T iterator, int32_t value) {
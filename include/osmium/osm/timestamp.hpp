@@ -33,7 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
-#include <cassert>
+#include <algorithm>
 #include <cstdint>
 #include <ctime>
 #include <iosfwd>
@@ -49,60 +49,169 @@ namespace osmium {
 
     namespace detail {
 
+        // The date/time arithmetic below uses the algorithms from
+        // http://howardhinnant.github.io/date_algorithms.html . Years
+        // are counted from March 1st, so the leap day is at the end of
+        // the year. An "era" is a 400 year cycle.
+
+        constexpr int64_t days_in_era_before_year(int64_t year_of_era) noexcept {
+            return year_of_era * 365 + year_of_era / 4 - year_of_era / 100;
+        }
+
+        constexpr int64_t day_of_year_from_march(int64_t month, int64_t day) noexcept {
+            return (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        }
+
+        constexpr int64_t days_from_civil_march_based(int64_t year, int64_t month, int64_t day) noexcept {
+            return (year / 400) * 146097 +
+                   days_in_era_before_year(year % 400) +
+                   day_of_year_from_march(month, day) -
+                   719468;
+        }
+
+        /**
+         * Number of days since 1970-01-01 for the given date in the
+         * Gregorian calendar. Only works for years from 1 on.
+         */
+        constexpr int64_t days_from_civil(int64_t year, int64_t month, int64_t day) noexcept {
+            return days_from_civil_march_based(month <= 2 ? year - 1 : year, month, day);
+        }
+
+        /**
+         * Seconds since the epoch for the given date and time (UTC).
+         */
+        constexpr int64_t seconds_from_civil(int64_t year, int64_t month, int64_t day,
+                                             int64_t hour, int64_t minute, int64_t second) noexcept {
+            return days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+        }
+
+        constexpr int64_t year_of_era_from_day_of_era(int64_t day_of_era) noexcept {
+            return (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+        }
+
+        constexpr int64_t march_based_month(int64_t day_of_year) noexcept {
+            return (5 * day_of_year + 2) / 153;
+        }
+
+        constexpr int64_t civil_month(int64_t march_month) noexcept {
+            return march_month < 10 ? march_month + 3 : march_month - 9;
+        }
+
+        constexpr int64_t day_of_era(int64_t days) noexcept {
+            return (days + 719468) % 146097;
+        }
+
+        constexpr int64_t day_of_year(int64_t days) noexcept {
+            return day_of_era(days) - days_in_era_before_year(year_of_era_from_day_of_era(day_of_era(days)));
+        }
+
+        /// Year for the given number of days since 1970-01-01 (must be >= 0).
+        constexpr int64_t civil_year(int64_t days) noexcept {
+            return (days + 719468) / 146097 * 400 +
+                   year_of_era_from_day_of_era(day_of_era(days)) +
+                   (march_based_month(day_of_year(days)) >= 10 ? 1 : 0);
+        }
+
+        /// Month (1-12) for the given number of days since 1970-01-01 (must be >= 0).
+        constexpr int64_t civil_month_from_days(int64_t days) noexcept {
+            return civil_month(march_based_month(day_of_year(days)));
+        }
+
+        /// Day of month (1-31) for the given number of days since 1970-01-01 (must be >= 0).
+        constexpr int64_t civil_day(int64_t days) noexcept {
+            return day_of_year(days) - (153 * march_based_month(day_of_year(days)) + 2) / 5 + 1;
+        }
+
+        inline constexpr bool is_digit_at(const char* str, int pos) noexcept {
+            return str[pos] >= '0' && str[pos] <= '9';
+        }
+
+        inline constexpr int two_digits_at(const char* str, int pos) noexcept {
+            return (str[pos] - '0') * 10 + (str[pos + 1] - '0');
+        }
+
+        /**
+         * Parse timestamp in the format "yyyy-mm-ddThh:mm:ssZ". Returns the
+         * seconds since the epoch.
+         *
+         * @throws std::invalid_argument if the timestamp can not be parsed.
+         */
         inline time_t parse_timestamp(const char* str) {
             static const int mon_lengths[] = {
                 31, 29, 31, 30, 31, 30,
                 31, 31, 30, 31, 30, 31
             };
-            if (str[ 0] >= '0' && str[ 0] <= '9' &&
-                str[ 1] >= '0' && str[ 1] <= '9' &&
-                str[ 2] >= '0' && str[ 2] <= '9' &&
-                str[ 3] >= '0' && str[ 3] <= '9' &&
+            if (is_digit_at(str, 0) &&
+                is_digit_at(str, 1) &&
+                is_digit_at(str, 2) &&
+                is_digit_at(str, 3) &&
                 str[ 4] == '-' &&
-                str[ 5] >= '0' && str[ 5] <= '9' &&
-                str[ 6] >= '0' && str[ 6] <= '9' &&
+                is_digit_at(str, 5) &&
+                is_digit_at(str, 6) &&
                 str[ 7] == '-' &&
-                str[ 8] >= '0' && str[ 8] <= '9' &&
-                str[ 9] >= '0' && str[ 9] <= '9' &&
+                is_digit_at(str, 8) &&
+                is_digit_at(str, 9) &&
                 str[10] == 'T' &&
-                str[11] >= '0' && str[11] <= '9' &&
-                str[12] >= '0' && str[12] <= '9' &&
+                is_digit_at(str, 11) &&
+                is_digit_at(str, 12) &&
                 str[13] == ':' &&
-                str[14] >= '0' && str[14] <= '9' &&
-                str[15] >= '0' && str[15] <= '9' &&
+                is_digit_at(str, 14) &&
+                is_digit_at(str, 15) &&
                 str[16] == ':' &&
-                str[17] >= '0' && str[17] <= '9' &&
-                str[18] >= '0' && str[18] <= '9' &&
+                is_digit_at(str, 17) &&
+                is_digit_at(str, 18) &&
                 str[19] == 'Z') {
-                struct tm tm;
-                tm.tm_year = (str[ 0] - '0') * 1000 +
-                             (str[ 1] - '0') *  100 +
-                             (str[ 2] - '0') *   10 +
-                             (str[ 3] - '0')        - 1900;
-                tm.tm_mon  = (str[ 5] - '0') * 10 + (str[ 6] - '0') - 1;
-                tm.tm_mday = (str[ 8] - '0') * 10 + (str[ 9] - '0');
-                tm.tm_hour = (str[11] - '0') * 10 + (str[12] - '0');
-                tm.tm_min  = (str[14] - '0') * 10 + (str[15] - '0');
-                tm.tm_sec  = (str[17] - '0') * 10 + (str[18] - '0');
-                tm.tm_wday = 0;
-                tm.tm_yday = 0;
-                tm.tm_isdst = 0;
-                if (tm.tm_year >= 0 &&
-                    tm.tm_mon  >= 0 && tm.tm_mon  <= 11 &&
-                    tm.tm_mday >= 1 && tm.tm_mday <= mon_lengths[tm.tm_mon] &&
-                    tm.tm_hour >= 0 && tm.tm_hour <= 23 &&
-                    tm.tm_min  >= 0 && tm.tm_min  <= 59 &&
-                    tm.tm_sec  >= 0 && tm.tm_sec  <= 60) {
-#ifndef _WIN32
-                    return timegm(&tm);
-#else
-                    return _mkgmtime(&tm);
-#endif
+                const int year   = two_digits_at(str, 0) * 100 + two_digits_at(str, 2);
+                const int month  = two_digits_at(str, 5);
+                const int day    = two_digits_at(str, 8);
+                const int hour   = two_digits_at(str, 11);
+                const int minute = two_digits_at(str, 14);
+                const int second = two_digits_at(str, 17);
+                if (year >= 1900 &&
+                    month  >= 1 && month  <= 12 &&
+                    day    >= 1 && day    <= mon_lengths[month - 1] &&
+                    hour   >= 0 && hour   <= 23 &&
+                    minute >= 0 && minute <= 59 &&
+                    second >= 0 && second <= 60) {
+                    return static_cast<time_t>(seconds_from_civil(year, month, day, hour, minute, second));
                 }
             }
             throw std::invalid_argument{"can not parse timestamp"};
         }
 
+        inline char* write_two_digits(char* out, int64_t value) noexcept {
+            *out++ = static_cast<char>('0' + value / 10);
+            *out++ = static_cast<char>('0' + value % 10);
+            return out;
+        }
+
+        /**
+         * Write timestamp given as seconds since the epoch in the format
+         * "yyyy-mm-ddThh:mm:ssZ" to out. Exactly 20 characters will be
+         * written, no \0 character is added.
+         */
+        inline char* format_timestamp(uint32_t timestamp, char* out) noexcept {
+            const int64_t days = timestamp / 86400;
+            const int64_t seconds_of_day = timestamp % 86400;
+
+            const int64_t year = civil_year(days);
+            out = write_two_digits(out, year / 100);
+            out = write_two_digits(out, year % 100);
+            *out++ = '-';
+            out = write_two_digits(out, civil_month_from_days(days));
+            *out++ = '-';
+            out = write_two_digits(out, civil_day(days));
+            *out++ = 'T';
+            out = write_two_digits(out, seconds_of_day / 3600);
+            *out++ = ':';
+            out = write_two_digits(out, seconds_of_day / 60 % 60);
+            *out++ = ':';
+            out = write_two_digits(out, seconds_of_day % 60);
+            *out++ = 'Z';
+
+            return out;
+        }
+
     } // namespace detail
 
     /**
@@ -114,15 +223,8 @@ namespace osmium {
      */
     class Timestamp {
 
-        // length of ISO timestamp string yyyy-mm-ddThh:mm:ssZ\0
-        static constexpr const int timestamp_length = 20 + 1;
-
-        // The timestamp format for OSM timestamps in strftime(3) format.
-        // This is the ISO-Format "yyyy-mm-ddThh:mm:ssZ".
-        static const char* timestamp_format() {
-            static const char f[timestamp_length] = "%Y-%m-%dT%H:%M:%SZ";
-            return f;
-        }
+        // length of ISO timestamp string yyyy-mm-ddThh:mm:ssZ
+        static constexpr const int timestamp_length = 20;
 
         uint32_t m_timestamp;
 
@@ -225,31 +327,31 @@ namespace osmium {
             std::string s;
 
             if (m_timestamp != 0) {
-                struct tm tm;
-                time_t sse = seconds_since_epoch();
-#ifndef NDEBUG
-                auto result =
-#endif
-#ifndef _WIN32
-                gmtime_r(&sse, &tm);
-                assert(result != nullptr);
-#else
-                gmtime_s(&tm, &sse);
-                assert(result == 0);
-#endif
-
-                s.resize(timestamp_length);
-                /* This const_cast is ok, because we know we have enough space
-                in the string for the format we are using (well at least until
-                the year will have 5 digits). And by setting the size
-                afterwards from the result of strftime we make sure thats set
-                right, too. */
-                s.resize(strftime(const_cast<char*>(s.c_str()), timestamp_length, timestamp_format(), &tm));
+                char buffer[timestamp_length];
+                detail::format_timestamp(m_timestamp, buffer);
+                s.assign(buffer, timestamp_length);
             }
 
             return s;
         }
 
+        /**
+         * Write the timestamp in ISO date/time ("yyyy-mm-ddThh:mm:ssZ")
+         * format to the output iterator. If the timestamp is invalid,
+         * nothing will be written. This doesn't need any temporary string.
+         *
+         * @returns Output iterator after the written characters.
+         */
+        template <typename T>
+        T to_iso(T iterator) const {
+            if (m_timestamp != 0) {
+                char buffer[timestamp_length];
+                detail::format_timestamp(m_timestamp, buffer);
+                iterator = std::copy_n(buffer, timestamp_length, iterator);
+            }
+            return iterator;
+        }
+
     }; // class Timestamp
 
     /**
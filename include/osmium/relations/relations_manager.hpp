@@ -440,6 +440,17 @@ namespace osmium {
             void after_relation(const osmium::Relation& /*relation*/) const noexcept {
             }
 
+            /**
+             * This method is called before the output buffer is flushed
+             * with flush_output() or its contents are returned with read().
+             *
+             * Overwrite this method in a derived class if it creates its
+             * output asynchronously and has to add it to the output buffer
+             * first.
+             */
+            void before_flush_output() const noexcept {
+            }
+
             TManager& derived() noexcept {
                 return *static_cast<TManager*>(this);
             }
@@ -473,6 +484,18 @@ namespace osmium {
                 return m_handler_pass2;
             }
 
+            /// Flush the output buffer.
+            void flush_output() {
+                derived().before_flush_output();
+                RelationsManagerBase::flush_output();
+            }
+
+            /// Return the contents of the output buffer.
+            osmium::memory::Buffer read() {
+                derived().before_flush_output();
+                return RelationsManagerBase::read();
+            }
+
             /**
              * Add the specified relation to the list of relations we want to
              * build. This calls the new_relation() and new_member()
@@ -0,0 +1,269 @@
+#ifndef OSMIUM_THREAD_BOUNDED_QUEUE_HPP
+#define OSMIUM_THREAD_BOUNDED_QUEUE_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <osmium/thread/queue.hpp>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A thread-safe queue with a fixed maximum size implemented as a
+         * lock-free ring buffer. Any number of threads can push and pop
+         * concurrently.
+         *
+         * Pushing to and popping from the queue doesn't need any locks as
+         * long as the queue is neither full nor empty. Only if a thread has
+         * to wait, it goes to sleep on a condition variable and is woken up
+         * as soon as there is space or data available.
+         *
+         * This has the same interface as osmium::thread::Queue (except that
+         * the size must be given) and can be used in its place.
+         */
+        template <typename T>
+        class BoundedQueue {
+
+            struct cell {
+                std::atomic<std::size_t> sequence;
+                T data;
+            };
+
+            // Cache line size to keep the producer and consumer positions
+            // from sharing a cache line.
+            enum {
+                cache_line_size = 64
+            };
+
+            /// Maximum size of this queue.
+            const std::size_t m_max_size;
+
+            /// Name of this queue (for debugging only).
+            const std::string m_name;
+
+            std::unique_ptr<cell[]> m_cells;
+
+            char m_pad0[cache_line_size];
+            std::atomic<std::size_t> m_enqueue_pos{0};
+            char m_pad1[cache_line_size];
+            std::atomic<std::size_t> m_dequeue_pos{0};
+            char m_pad2[cache_line_size];
+
+            std::mutex m_mutex;
+
+            /// Used to signal consumers when data is available in the queue.
+            std::condition_variable m_data_available;
+
+            /// Used to signal producers when queue is not full.
+            std::condition_variable m_space_available;
+
+            std::atomic<int> m_waiting_consumers{0};
+            std::atomic<int> m_waiting_producers{0};
+
+            detail::queue_counters m_counters;
+
+            bool try_push_impl(T& value) {
+                auto pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                cell* c;
+                while (true) {
+                    c = &m_cells[pos % m_max_size];
+                    const auto seq = c->sequence.load(std::memory_order_acquire);
+                    const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                    if (diff == 0) {
+                        if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    } else if (diff < 0) {
+                        return false; // queue is full
+                    } else {
+                        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+                c->data = std::move(value);
+                c->sequence.store(pos + 1, std::memory_order_release);
+                m_counters.pushed(size());
+                return true;
+            }
+
+            bool try_pop_impl(T& value) {
+                auto pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                cell* c;
+                while (true) {
+                    c = &m_cells[pos % m_max_size];
+                    const auto seq = c->sequence.load(std::memory_order_acquire);
+                    const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+                    if (diff == 0) {
+                        if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    } else if (diff < 0) {
+                        return false; // queue is empty
+                    } else {
+                        pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                    }
+                }
+                value = std::move(c->data);
+                c->sequence.store(pos + m_max_size, std::memory_order_release);
+                return true;
+            }
+
+            // Wake up one of the threads waiting on the condition variable
+            // if there are any. The fence makes sure a thread going to sleep
+            // either sees the change to the queue or is counted here.
+            static void wake_up(std::mutex& mutex, std::condition_variable& cv, std::atomic<int>& waiting) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (waiting.load(std::memory_order_relaxed) > 0) {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    cv.notify_one();
+                }
+            }
+
+        public:
+
+            /**
+             * Construct a multithreaded queue.
+             *
+             * @param max_size Maximum number of elements in the queue. Must
+             *                 be larger than 0.
+             * @param name Optional name for this queue. (Used for debugging.)
+             */
+            explicit BoundedQueue(std::size_t max_size, const std::string& name = "") :
+                m_max_size(max_size),
+                m_name(name),
+                m_cells(new cell[max_size]) {
+                assert(max_size > 0);
+                for (std::size_t i = 0; i < m_max_size; ++i) {
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            BoundedQueue(const BoundedQueue&) = delete;
+            BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+            BoundedQueue(BoundedQueue&&) = delete;
+            BoundedQueue& operator=(BoundedQueue&&) = delete;
+
+            ~BoundedQueue() {
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                detail::print_queue_stats(m_name, m_max_size, stats());
+#endif
+            }
+
+            /**
+             * Push an element onto the queue. If the queue is full, this
+             * call will block until there is space.
+             */
+            void push(T value) {
+                if (!try_push_impl(value)) {
+                    m_counters.full();
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    ++m_waiting_producers;
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    m_space_available.wait(lock, [this, &value] {
+                        return try_push_impl(value);
+                    });
+                    --m_waiting_producers;
+                }
+                wake_up(m_mutex, m_data_available, m_waiting_consumers);
+            }
+
+            /**
+             * Pop an element from the queue. If the queue is empty, this
+             * call will block until there is data.
+             */
+            void wait_and_pop(T& value) {
+                m_counters.popped();
+                if (!try_pop_impl(value)) {
+                    m_counters.empty();
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    ++m_waiting_consumers;
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    m_data_available.wait(lock, [this, &value] {
+                        return try_pop_impl(value);
+                    });
+                    --m_waiting_consumers;
+                }
+                wake_up(m_mutex, m_space_available, m_waiting_producers);
+            }
+
+            /**
+             * Pop an element from the queue if there is one.
+             *
+             * @returns true if an element was popped, false if the queue
+             *          was empty.
+             */
+            bool try_pop(T& value) {
+                m_counters.popped();
+                if (!try_pop_impl(value)) {
+                    m_counters.empty();
+                    return false;
+                }
+                wake_up(m_mutex, m_space_available, m_waiting_producers);
+                return true;
+            }
+
+            /// Is the queue empty? (Only a snapshot.)
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            /// Number of elements in the queue. (Only a snapshot.)
+            std::size_t size() const noexcept {
+                const auto dequeue_pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                const auto enqueue_pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+            }
+
+            /// Get statistics about the use of this queue.
+            queue_stats stats() const noexcept {
+                return m_counters.stats();
+            }
+
+        }; // class BoundedQueue
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_BOUNDED_QUEUE_HPP
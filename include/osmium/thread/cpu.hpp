@@ -0,0 +1,293 @@
+#ifndef OSMIUM_THREAD_CPU_HPP
+#define OSMIUM_THREAD_CPU_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2017 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+# include <pthread.h>
+# include <sched.h>
+#endif
+
+namespace osmium {
+
+    namespace thread {
+
+        namespace detail {
+
+            /**
+             * Parse a Linux CPU list like "0-3,8,10-11" into a sorted
+             * vector of CPU numbers. Invalid parts are ignored.
+             */
+            inline std::vector<int> parse_cpu_list(const std::string& list) {
+                std::vector<int> cpus;
+
+                std::string::size_type pos = 0;
+                while (pos < list.size()) {
+                    auto end = list.find(',', pos);
+                    if (end == std::string::npos) {
+                        end = list.size();
+                    }
+                    const std::string part = list.substr(pos, end - pos);
+                    pos = end + 1;
+
+                    const char* str = part.c_str();
+                    char* next = nullptr;
+                    const long first = std::strtol(str, &next, 10);
+                    if (next == str || first < 0) {
+                        continue;
+                    }
+                    long last = first;
+                    if (*next == '-') {
+                        str = next + 1;
+                        last = std::strtol(str, &next, 10);
+                        if (next == str || last < first) {
+                            continue;
+                        }
+                    }
+                    for (long cpu = first; cpu <= last; ++cpu) {
+                        cpus.push_back(static_cast<int>(cpu));
+                    }
+                }
+
+                std::sort(cpus.begin(), cpus.end());
+                cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+
+                return cpus;
+            }
+
+            /**
+             * Get the number of CPUs a quota of quota microseconds per
+             * period microseconds amounts to, rounded up. Returns 0 if
+             * there is no limit.
+             */
+            inline int cpu_limit_from_quota(long quota, long period) noexcept {
+                if (quota <= 0 || period <= 0) {
+                    return 0;
+                }
+                return static_cast<int>((quota + period - 1) / period);
+            }
+
+            /**
+             * Parse the contents of the cpu.max file of a cgroup (v2).
+             * It contains the quota (or "max" for none) and the period.
+             * Returns 0 if there is no limit.
+             */
+            inline int parse_cgroup_cpu_max(const std::string& content) {
+                if (content.compare(0, 3, "max") == 0) {
+                    return 0;
+                }
+                const char* str = content.c_str();
+                char* next = nullptr;
+                const long quota = std::strtol(str, &next, 10);
+                if (next == str) {
+                    return 0;
+                }
+                const long period = std::strtol(next, nullptr, 10);
+                return cpu_limit_from_quota(quota, period);
+            }
+
+            inline std::string read_first_line(const std::string& filename) {
+                std::ifstream file{filename};
+                std::string line;
+                if (file.is_open()) {
+                    std::getline(file, line);
+                }
+                return line;
+            }
+
+            /**
+             * Get the path of the cgroup (v2) this process is in relative
+             * to the cgroup root from the /proc/self/cgroup file.
+             */
+            inline std::string get_cgroup_path() {
+                std::ifstream file{"/proc/self/cgroup"};
+                std::string line;
+                while (std::getline(file, line)) {
+                    if (line.compare(0, 3, "0::") == 0) {
+                        return line.substr(3);
+                    }
+                }
+                return "";
+            }
+
+        } // namespace detail
+
+        /**
+         * Get the CPUs this process is allowed to run on. On Linux this
+         * is the affinity mask of the process (as set by taskset(1),
+         * numactl(8), or container runtimes). On other systems this is
+         * every CPU.
+         */
+        inline std::vector<int> available_cpus() {
+            std::vector<int> cpus;
+
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                    if (CPU_ISSET(cpu, &set)) {
+                        cpus.push_back(cpu);
+                    }
+                }
+            }
+#endif
+
+            if (cpus.empty()) {
+                const int num = static_cast<int>(std::thread::hardware_concurrency());
+                for (int cpu = 0; cpu < std::max(num, 1); ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+
+            return cpus;
+        }
+
+        /**
+         * Get the CPU limit set through the CPU quota of the cgroup this
+         * process is in, rounded up to whole CPUs. Both cgroup v2 and v1
+         * are supported. Returns 0 if there is no limit or the system is
+         * not Linux.
+         */
+        inline int cgroup_cpu_limit() {
+#ifdef __linux__
+            const std::string root{"/sys/fs/cgroup"};
+
+            // cgroup v2
+            const std::string path = detail::get_cgroup_path();
+            if (!path.empty() && path != "/") {
+                const std::string content = detail::read_first_line(root + path + "/cpu.max");
+                if (!content.empty()) {
+                    return detail::parse_cgroup_cpu_max(content);
+                }
+            }
+            const std::string content = detail::read_first_line(root + "/cpu.max");
+            if (!content.empty()) {
+                return detail::parse_cgroup_cpu_max(content);
+            }
+
+            // cgroup v1
+            for (const char* dir : {"/cpu", "/cpu,cpuacct"}) {
+                const std::string quota = detail::read_first_line(root + dir + "/cpu.cfs_quota_us");
+                const std::string period = detail::read_first_line(root + dir + "/cpu.cfs_period_us");
+                if (!quota.empty() && !period.empty()) {
+                    return detail::cpu_limit_from_quota(std::atol(quota.c_str()), std::atol(period.c_str()));
+                }
+            }
+#endif
+            return 0;
+        }
+
+        /**
+         * Get the number of CPUs this process can actually use. This
+         * takes the affinity mask and the cgroup CPU quota into account,
+         * so it is the right number to size thread pools in containers.
+         * It is always at least 1.
+         */
+        inline int available_cpu_count() {
+            int count = static_cast<int>(available_cpus().size());
+
+            const int limit = cgroup_cpu_limit();
+            if (limit > 0 && limit < count) {
+                count = limit;
+            }
+
+            return std::max(count, 1);
+        }
+
+        /**
+         * Get the CPUs of each NUMA node that are in the given set of
+         * CPUs. Nodes without any of those CPUs are left out. Returns an
+         * empty vector if the NUMA topology is not known (on non-Linux
+         * systems or if /sys is not available).
+         */
+        inline std::vector<std::vector<int>> numa_node_cpus(const std::vector<int>& cpus) {
+            std::vector<std::vector<int>> nodes;
+
+#ifdef __linux__
+            const std::vector<int> node_ids = detail::parse_cpu_list(detail::read_first_line("/sys/devices/system/node/online"));
+            for (const int node : node_ids) {
+                const std::string filename = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+                std::vector<int> node_cpus;
+                for (const int cpu : detail::parse_cpu_list(detail::read_first_line(filename))) {
+                    if (std::binary_search(cpus.begin(), cpus.end(), cpu)) {
+                        node_cpus.push_back(cpu);
+                    }
+                }
+                if (!node_cpus.empty()) {
+                    nodes.push_back(std::move(node_cpus));
+                }
+            }
+#endif
+
+            return nodes;
+        }
+
+        /**
+         * Restrict the current thread to run on the given CPUs. Returns
+         * true on success. This only works on Linux, on other systems it
+         * always returns false.
+         */
+#ifdef __linux__
+        inline bool pin_current_thread(const std::vector<int>& cpus) noexcept {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            if (CPU_COUNT(&set) == 0) {
+                return false;
+            }
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+        }
+#else
+        inline bool pin_current_thread(const std::vector<int>&) noexcept {
+            return false;
+        }
+#endif
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_CPU_HPP
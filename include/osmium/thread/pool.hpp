@@ -33,15 +33,20 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include <osmium/thread/cpu.hpp>
 #include <osmium/thread/function_wrapper.hpp>
-#include <osmium/thread/queue.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
 
@@ -54,11 +59,12 @@ namespace osmium {
 
         namespace detail {
 
-            // Maximum number of allowed pool threads (just to keep the user
-            // from setting something silly).
+            // Default maximum number of allowed pool threads (just to keep
+            // the user from setting something silly). Can be changed with
+            // the OSMIUM_MAX_POOL_THREADS environment variable.
             constexpr const int max_pool_threads = 32;
 
-            inline int get_pool_size(int num_threads, int user_setting, unsigned hardware_concurrency) {
+            inline int get_pool_size(int num_threads, int user_setting, unsigned hardware_concurrency, int max_threads = max_pool_threads) {
                 if (num_threads == 0) {
                     num_threads = user_setting ? user_setting : -2;
                 }
@@ -69,8 +75,8 @@ namespace osmium {
 
                 if (num_threads < 1) {
                     num_threads = 1;
-                } else if (num_threads > max_pool_threads) {
-                    num_threads = max_pool_threads;
+                } else if (num_threads > max_threads) {
+                    num_threads = max_threads;
                 }
 
                 return num_threads;
@@ -81,10 +87,97 @@ namespace osmium {
                 return n > 2 ? n : 2;
             }
 
+            /**
+             * The queue of tasks of one worker thread. Other workers can
+             * steal tasks from it.
+             */
+            class WorkQueue {
+
+                std::mutex m_mutex;
+                std::deque<function_wrapper> m_tasks;
+
+            public:
+
+                void push(function_wrapper&& task) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_tasks.push_back(std::move(task));
+                }
+
+                bool try_pop(function_wrapper& task) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_tasks.empty()) {
+                        return false;
+                    }
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                    return true;
+                }
+
+            }; // class WorkQueue
+
         } // namespace detail
 
         /**
-         *  Thread pool.
+         * How the worker threads of a Pool should be pinned to CPUs.
+         */
+        enum class pool_pinning {
+            none       = 0, ///< Do not pin worker threads.
+            cores      = 1, ///< Pin each worker thread to one CPU.
+            numa_nodes = 2  ///< Pin worker threads to the CPUs of a NUMA node, distributing them over all nodes.
+        }; // enum class pool_pinning
+
+        /**
+         * Options for creating a Pool.
+         */
+        struct pool_options {
+
+            /**
+             * Number of threads. See the Pool constructor for the
+             * meaning of 0 and negative numbers.
+             */
+            int num_threads = 0;
+
+            /**
+             * Maximum number of tasks waiting. If 0, the queue size is
+             * read from the environment variable
+             * OSMIUM_MAX_WORK_QUEUE_SIZE.
+             */
+            std::size_t max_queue_size = 0;
+
+            /**
+             * If this is set, the number of CPUs negative numbers of
+             * threads are relative to is the number of CPUs available
+             * to the process according to its affinity mask and cgroup
+             * CPU quota. Otherwise it is the number of CPUs in the
+             * system.
+             */
+            bool use_cpu_limits = true;
+
+            /**
+             * How to pin the worker threads to CPUs. Only CPUs in the
+             * affinity mask of the process are used. Pinning only works
+             * on Linux, on other systems this is ignored.
+             */
+            pool_pinning pinning = pool_pinning::none;
+
+        }; // struct pool_options
+
+        /**
+         * Thread pool.
+         *
+         * Every worker thread has its own queue of tasks. New tasks are
+         * distributed over those queues. A worker takes tasks from its
+         * own queue and, if that is empty, steals tasks from the queues
+         * of the other workers. So there is no single lock all threads
+         * have to go through. Tasks are always taken from the front of
+         * a queue, so they are run roughly in the order they have been
+         * submitted, which is what the readers and writers consuming the
+         * results in order need.
+         *
+         * The total number of tasks waiting in the pool is limited, if
+         * the limit is reached, submit() blocks until a worker takes a
+         * task. Tasks submitted from a worker thread of the pool itself
+         * never block to avoid deadlocks.
          */
         class Pool {
 
@@ -112,16 +205,148 @@ namespace osmium {
 
             }; // class thread_joiner
 
-            osmium::thread::Queue<function_wrapper> m_work_queue;
+            struct worker_info {
+                const Pool* pool;
+                std::size_t index;
+            };
+
+            // Which pool and which worker in it does the current thread
+            // belong to?
+            static worker_info& current_worker() noexcept {
+                static thread_local worker_info info{nullptr, 0};
+                return info;
+            }
+
+            std::vector<std::unique_ptr<detail::WorkQueue>> m_work_queues;
+            std::size_t m_max_queue_size;
+
+            // Number of tasks in all the work queues.
+            std::atomic<std::size_t> m_num_tasks{0};
+
+            // Used to select the work queue for the next task submitted
+            // from outside the pool.
+            std::atomic<std::size_t> m_next_queue{0};
+
+            std::mutex m_mutex;
+            std::condition_variable m_work_available;
+            std::condition_variable m_space_available;
+            std::atomic<int> m_num_sleeping_workers{0};
+            std::atomic<int> m_num_waiting_submitters{0};
+
+            int m_num_threads;
+
+            // The CPUs each worker thread is pinned to. Empty if the
+            // workers are not pinned. This must be declared before the
+            // threads, workers read it when they start and are only
+            // joined when m_joiner is destroyed.
+            std::vector<std::vector<int>> m_worker_cpus;
+
             std::vector<std::thread> m_threads;
             thread_joiner m_joiner;
-            int m_num_threads;
 
-            void worker_thread() {
+            static pool_options make_options(int num_threads, std::size_t max_queue_size) noexcept {
+                pool_options options;
+                options.num_threads = num_threads;
+                options.max_queue_size = max_queue_size;
+                return options;
+            }
+
+            static std::vector<std::vector<int>> get_worker_cpus(pool_pinning pinning, int num_threads) {
+                std::vector<std::vector<int>> worker_cpus;
+
+                if (pinning == pool_pinning::none) {
+                    return worker_cpus;
+                }
+
+                const auto cpus = available_cpus();
+                std::vector<std::vector<int>> groups;
+                if (pinning == pool_pinning::numa_nodes) {
+                    groups = numa_node_cpus(cpus);
+                }
+                if (groups.empty()) {
+                    for (const int cpu : cpus) {
+                        groups.emplace_back(1, cpu);
+                    }
+                }
+
+                for (int i = 0; i < num_threads; ++i) {
+                    worker_cpus.push_back(groups[std::size_t(i) % groups.size()]);
+                }
+
+                return worker_cpus;
+            }
+
+            void push_to_queue(std::size_t queue, function_wrapper&& task) {
+                // Count the task first, so that the counter never goes
+                // below zero when a worker takes the task immediately.
+                ++m_num_tasks;
+                m_work_queues[queue]->push(std::move(task));
+                if (m_num_sleeping_workers > 0) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_work_available.notify_one();
+                }
+            }
+
+            void wait_for_space() {
+                if (m_num_tasks < m_max_queue_size) {
+                    return;
+                }
+                std::unique_lock<std::mutex> lock{m_mutex};
+                ++m_num_waiting_submitters;
+                m_space_available.wait(lock, [this] {
+                    return m_num_tasks < m_max_queue_size;
+                });
+                --m_num_waiting_submitters;
+            }
+
+            void submit_task(function_wrapper&& task) {
+                const auto& worker = current_worker();
+                if (worker.pool == this) {
+                    push_to_queue(worker.index, std::move(task));
+                    return;
+                }
+
+                wait_for_space();
+                push_to_queue(m_next_queue++ % m_work_queues.size(), std::move(task));
+            }
+
+            // Get next task from own queue or steal one from the queues of
+            // the other workers.
+            bool try_get_task(std::size_t index, function_wrapper& task) {
+                const auto size = m_work_queues.size();
+                for (std::size_t i = 0; i < size; ++i) {
+                    if (m_work_queues[(index + i) % size]->try_pop(task)) {
+                        --m_num_tasks;
+                        if (m_num_waiting_submitters > 0) {
+                            std::lock_guard<std::mutex> lock{m_mutex};
+                            m_space_available.notify_one();
+                        }
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void get_task(std::size_t index, function_wrapper& task) {
+                while (!try_get_task(index, task)) {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    ++m_num_sleeping_workers;
+                    m_work_available.wait(lock, [this] {
+                        return m_num_tasks > 0;
+                    });
+                    --m_num_sleeping_workers;
+                }
+            }
+
+            void worker_thread(std::size_t index) {
                 osmium::thread::set_thread_name("_osmium_worker");
+                if (!m_worker_cpus.empty()) {
+                    pin_current_thread(m_worker_cpus[index]);
+                }
+                current_worker() = worker_info{this, index};
                 while (true) {
                     function_wrapper task;
-                    m_work_queue.wait_and_pop(task);
+                    get_task(index, task);
                     if (task && task()) {
                         // The called tasks returns true only when the
                         // worker thread should shut down.
@@ -142,23 +367,46 @@ namespace osmium {
              * value in that case is -2.
              *
              * If the number of threads is a negative number, it will be
-             * set to the actual number of cores on the system plus the
-             * given number, ie it will leave a number of cores unused.
+             * set to the number of CPUs available to the process plus
+             * the given number, ie it will leave a number of CPUs unused.
+             * The number of available CPUs takes the affinity mask and
+             * the cgroup CPU quota into account.
              *
              * In all cases the minimum number of threads in the pool is 1.
+             * The maximum is 32 unless it is changed with the environment
+             * variable OSMIUM_MAX_POOL_THREADS.
              *
              * If max_queue_size is 0, the queue size is read from
-             * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE.
+             * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE. This is
+             * the maximum number of tasks waiting in all the queues of
+             * the pool together.
              */
             explicit Pool(int num_threads = default_num_threads, std::size_t max_queue_size = default_queue_size) :
-                m_work_queue(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size(), "work"),
+                Pool(make_options(num_threads, max_queue_size)) {
+            }
+
+            /**
+             * Create thread pool with the given options.
+             */
+            explicit Pool(const pool_options& options) :
+                m_work_queues(),
+                m_max_queue_size(options.max_queue_size > 0 ? options.max_queue_size : detail::get_work_queue_size()),
+                m_num_threads(detail::get_pool_size(options.num_threads,
+                                                    osmium::config::get_pool_threads(),
+                                                    options.use_cpu_limits ? unsigned(available_cpu_count())
+                                                                           : std::thread::hardware_concurrency(),
+                                                    osmium::config::get_max_pool_threads(detail::max_pool_threads))),
+                m_worker_cpus(get_worker_cpus(options.pinning, m_num_threads)),
                 m_threads(),
-                m_joiner(m_threads),
-                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())) {
+                m_joiner(m_threads) {
+
+                for (int i = 0; i < m_num_threads; ++i) {
+                    m_work_queues.emplace_back(new detail::WorkQueue{});
+                }
 
                 try {
                     for (int i = 0; i < m_num_threads; ++i) {
-                        m_threads.emplace_back(&Pool::worker_thread, this);
+                        m_threads.emplace_back(&Pool::worker_thread, this, std::size_t(i));
                     }
                 } catch (...) {
                     shutdown_all_workers();
@@ -172,9 +420,12 @@ namespace osmium {
             }
 
             void shutdown_all_workers() {
-                for (int i = 0; i < m_num_threads; ++i) {
-                    // The special function wrapper makes a worker shut down.
-                    m_work_queue.push(function_wrapper{0});
+                // The special function wrapper makes a worker shut down.
+                // Each work queue gets one of them after all other tasks
+                // in it. So when the last worker shuts down, all tasks
+                // have been done.
+                for (std::size_t i = 0; i < m_work_queues.size(); ++i) {
+                    push_to_queue(i, function_wrapper{0});
                 }
             }
 
@@ -186,12 +437,21 @@ namespace osmium {
                 return m_num_threads;
             }
 
+            /**
+             * The CPUs the worker thread with the given index is pinned
+             * to. Empty if the worker threads are not pinned.
+             */
+            const std::vector<int>& worker_cpus(int index) const {
+                static const std::vector<int> none;
+                return m_worker_cpus.empty() ? none : m_worker_cpus[std::size_t(index)];
+            }
+
             std::size_t queue_size() const {
-                return m_work_queue.size();
+                return m_num_tasks;
             }
 
             bool queue_empty() const {
-                return m_work_queue.empty();
+                return m_num_tasks == 0;
             }
 
             template <typename TFunction>
@@ -200,7 +460,7 @@ namespace osmium {
 
                 std::packaged_task<result_type()> task{std::forward<TFunction>(func)};
                 std::future<result_type> future_result{task.get_future()};
-                m_work_queue.push(std::move(task));
+                submit_task(std::move(task));
 
                 return future_result;
             }
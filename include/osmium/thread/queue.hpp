@@ -33,7 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
-#include <chrono>
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
 #include <mutex>
@@ -42,7 +42,6 @@ DEALINGS IN THE SOFTWARE.
 #include <utility> // IWYU pragma: keep
 
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
-# include <atomic>
 # include <iostream>
 #endif
 
@@ -50,6 +49,95 @@ namespace osmium {
 
     namespace thread {
 
+        /**
+         * Statistics about the use of a queue. Can be used to find out
+         * whether the queue sizes are set correctly.
+         */
+        struct queue_stats {
+
+            /// The largest size the queue has been so far.
+            std::size_t largest_size;
+
+            /// The number of times push() was called on the queue.
+            std::size_t push_count;
+
+            /// The number of times the queue was full and a thread pushing
+            /// to the queue was blocked.
+            std::size_t full_count;
+
+            /// The number of times a pop function was called on the queue.
+            std::size_t pop_count;
+
+            /// The number of times the queue was empty when a pop function
+            /// was called.
+            std::size_t empty_count;
+
+        }; // struct queue_stats
+
+        namespace detail {
+
+            /**
+             * Counters for the queue_stats. They are updated without
+             * synchronization with anything else, so they are cheap enough
+             * to be always on.
+             */
+            class queue_counters {
+
+                std::atomic<std::size_t> m_largest_size{0};
+                std::atomic<std::size_t> m_push_count{0};
+                std::atomic<std::size_t> m_full_count{0};
+                std::atomic<std::size_t> m_pop_count{0};
+                std::atomic<std::size_t> m_empty_count{0};
+
+            public:
+
+                void pushed(std::size_t size) noexcept {
+                    m_push_count.fetch_add(1, std::memory_order_relaxed);
+                    auto largest = m_largest_size.load(std::memory_order_relaxed);
+                    while (largest < size &&
+                           !m_largest_size.compare_exchange_weak(largest, size, std::memory_order_relaxed)) {
+                    }
+                }
+
+                void full() noexcept {
+                    m_full_count.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                void popped() noexcept {
+                    m_pop_count.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                void empty() noexcept {
+                    m_empty_count.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                queue_stats stats() const noexcept {
+                    return queue_stats{
+                        m_largest_size.load(std::memory_order_relaxed),
+                        m_push_count.load(std::memory_order_relaxed),
+                        m_full_count.load(std::memory_order_relaxed),
+                        m_pop_count.load(std::memory_order_relaxed),
+                        m_empty_count.load(std::memory_order_relaxed)
+                    };
+                }
+
+            }; // class queue_counters
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+            inline void print_queue_stats(const std::string& name, std::size_t max_size, const queue_stats& stats) {
+                std::cerr << "queue '" << name
+                          << "' with max_size=" << max_size
+                          << " had largest size " << stats.largest_size
+                          << " and was full " << stats.full_count
+                          << " times in " << stats.push_count
+                          << " push() calls and was empty " << stats.empty_count
+                          << " times in " << stats.pop_count
+                          << " pop() calls\n";
+            }
+#endif
+
+        } // namespace detail
+
         /**
          *  A thread-safe queue.
          */
@@ -73,27 +161,7 @@ namespace osmium {
             /// Used to signal producers when queue is not full.
             std::condition_variable m_space_available;
 
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-            /// The largest size the queue has been so far.
-            std::size_t m_largest_size;
-
-            /// The number of times push() was called on the queue.
-            std::atomic<int> m_push_counter;
-
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_full_counter;
-
-            /**
-             * The number of times wait_and_pop(with_timeout)() was called
-             * on the queue.
-             */
-            std::atomic<int> m_pop_counter;
-
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_empty_counter;
-#endif
+            detail::queue_counters m_counters;
 
         public:
 
@@ -110,28 +178,13 @@ namespace osmium {
                 m_mutex(),
                 m_queue(),
                 m_data_available(),
-                m_space_available()
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ,
-                m_largest_size(0),
-                m_push_counter(0),
-                m_full_counter(0),
-                m_pop_counter(0),
-                m_empty_counter(0)
-#endif
-            {
+                m_space_available(),
+                m_counters() {
             }
 
             ~Queue() {
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                std::cerr << "queue '" << m_name
-                          << "' with max_size=" << m_max_size
-                          << " had largest size " << m_largest_size
-                          << " and was full " << m_full_counter
-                          << " times in " << m_push_counter
-                          << " push() calls and was empty " << m_empty_counter
-                          << " times in " << m_pop_counter
-                          << " pop() calls\n";
+                detail::print_queue_stats(m_name, m_max_size, stats());
 #endif
             }
 
@@ -140,41 +193,25 @@ namespace osmium {
              * this call will block if the queue is full.
              */
             void push(T value) {
-                constexpr const std::chrono::milliseconds max_wait{10};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_push_counter;
-#endif
-                if (m_max_size) {
-                    while (size() >= m_max_size) {
-                        std::unique_lock<std::mutex> lock{m_mutex};
-                        m_space_available.wait_for(lock, max_wait, [this] {
-                            return m_queue.size() < m_max_size;
-                        });
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_full_counter;
-#endif
-                    }
+                std::unique_lock<std::mutex> lock{m_mutex};
+                if (m_max_size && m_queue.size() >= m_max_size) {
+                    m_counters.full();
+                    m_space_available.wait(lock, [this] {
+                        return m_queue.size() < m_max_size;
+                    });
                 }
-                std::lock_guard<std::mutex> lock{m_mutex};
                 m_queue.push(std::move(value));
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                if (m_largest_size < m_queue.size()) {
-                    m_largest_size = m_queue.size();
-                }
-#endif
+                m_counters.pushed(m_queue.size());
+                lock.unlock();
                 m_data_available.notify_one();
             }
 
             void wait_and_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_pop_counter;
-#endif
+                m_counters.popped();
                 std::unique_lock<std::mutex> lock{m_mutex};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 if (m_queue.empty()) {
-                    ++m_empty_counter;
+                    m_counters.empty();
                 }
-#endif
                 m_data_available.wait(lock, [this] {
                     return !m_queue.empty();
                 });
@@ -189,15 +226,11 @@ namespace osmium {
             }
 
             bool try_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_pop_counter;
-#endif
+                m_counters.popped();
                 {
                     std::lock_guard<std::mutex> lock{m_mutex};
                     if (m_queue.empty()) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_empty_counter;
-#endif
+                        m_counters.empty();
                         return false;
                     }
                     value = std::move(m_queue.front());
@@ -219,6 +252,11 @@ namespace osmium {
                 return m_queue.size();
             }
 
+            /// Get statistics about the use of this queue.
+            queue_stats stats() const noexcept {
+                return m_counters.stats();
+            }
+
         }; // class Queue
 
     } // namespace thread
@@ -55,6 +55,15 @@ namespace osmium {
             return 0;
         }
 
+        inline int get_max_pool_threads(int default_value) noexcept {
+            const char* env = getenv("OSMIUM_MAX_POOL_THREADS");
+            if (env) {
+                const auto value = std::atoi(env);
+                return value > 0 ? value : default_value;
+            }
+            return default_value;
+        }
+
         inline bool use_pool_threads_for_pbf_parsing() noexcept {
             const char* env = getenv("OSMIUM_USE_POOL_THREADS_FOR_PBF_PARSING");
             if (env) {
@@ -75,8 +84,8 @@ namespace osmium {
             name += "_QUEUE_SIZE";
             const char* env = getenv(name.c_str());
             if (env) {
-                auto value = std::atoi(env);
-                return value == 0 ? default_value : value;
+                const auto value = std::atoi(env);
+                return value > 0 ? static_cast<std::size_t>(value) : default_value;
             }
             return default_value;
         }
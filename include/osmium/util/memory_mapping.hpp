@@ -33,10 +33,15 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <stdexcept>
+#include <string>
 #include <system_error>
 
 #include <osmium/util/compatibility.hpp>
@@ -55,6 +60,74 @@ namespace osmium {
 
     namespace util {
 
+        /**
+         * Options for memory mappings. They tell the operating system how
+         * the memory is going to be used. Options not supported on the
+         * current system are ignored. All options except
+         * huge_pages_mode::hugetlb are only hints, if the system can not
+         * follow them the mapping is created anyway.
+         */
+        struct mapping_options {
+
+            enum class huge_pages_mode {
+                /// Use normal pages.
+                none        = 0,
+                /// Ask for transparent huge pages with madvise(MADV_HUGEPAGE) (Linux only).
+                transparent = 1,
+                /**
+                 * Use pre-allocated huge pages with MAP_HUGETLB (Linux only,
+                 * anonymous mappings only). The mapping fails if not enough
+                 * huge pages are available.
+                 */
+                hugetlb     = 2
+            };
+
+            enum class access_mode {
+                /// No special access pattern.
+                normal     = 0,
+                /// Memory will be accessed sequentially (MADV_SEQUENTIAL).
+                sequential = 1,
+                /// Memory will be accessed in random order (MADV_RANDOM).
+                random     = 2
+            };
+
+            /// Which kind of huge pages to use.
+            huge_pages_mode huge_pages = huge_pages_mode::none;
+
+            /// Expected access pattern.
+            access_mode access = access_mode::normal;
+
+            /**
+             * Pre-fault all pages of the mapping when it is created or
+             * resized instead of on first access (MAP_POPULATE, Linux
+             * only).
+             */
+            bool populate = false;
+
+        }; // struct mapping_options
+
+        /**
+         * Get the size of huge pages on this system. Returns 0 if it can
+         * not be determined. This only works on Linux.
+         */
+        inline std::size_t get_huge_pagesize() {
+#ifdef __linux__
+            static const std::size_t size = [](){
+                std::ifstream meminfo{"/proc/meminfo"};
+                std::string line;
+                while (std::getline(meminfo, line)) {
+                    if (line.compare(0, 13, "Hugepagesize:") == 0) {
+                        return static_cast<std::size_t>(std::strtoull(line.c_str() + 13, nullptr, 10)) * 1024;
+                    }
+                }
+                return std::size_t{0};
+            }();
+            return size;
+#else
+            return 0;
+#endif
+        }
+
         /**
          * Class for wrapping memory mapping system calls.
          *
@@ -91,6 +164,10 @@ namespace osmium {
          *
          * On Windows the file will be set to binary mode before the memory
          * mapping.
+         *
+         * Use the mapping_options to ask for huge pages, pre-faulted pages,
+         * or to tell the system about the access pattern. On Windows these
+         * options are ignored.
          */
         class MemoryMapping {
 
@@ -116,6 +193,9 @@ namespace osmium {
             /// Mapping mode
             mapping_mode m_mapping_mode;
 
+            /// Mapping options
+            mapping_options m_options;
+
 #ifdef _WIN32
             HANDLE m_handle;
 #endif
@@ -137,6 +217,14 @@ namespace osmium {
 
             flag_type get_flags() const noexcept;
 
+#ifndef _WIN32
+            bool use_hugetlb() const noexcept;
+            bool populate_after_advise() const noexcept;
+            std::size_t mapped_size() const noexcept;
+            void* map() const noexcept;
+            void advise() const noexcept;
+#endif
+
             static std::size_t check_size(std::size_t size) {
                 if (size == 0) {
                     return osmium::util::get_pagesize();
@@ -179,9 +267,10 @@ namespace osmium {
              * @param mode Mapping mode: readonly, or writable (shared or private)
              * @param fd Open file descriptor of a file we want to map
              * @param offset Offset into the file where the mapping should start
+             * @param options Options for huge pages, pre-faulting and access pattern
              * @throws std::system_error if the mapping fails
              */
-            MemoryMapping(std::size_t size, mapping_mode mode, int fd=-1, off_t offset=0);
+            MemoryMapping(std::size_t size, mapping_mode mode, int fd=-1, off_t offset=0, const mapping_options& options = mapping_options{});
 
             /**
              * @deprecated
@@ -275,6 +364,13 @@ namespace osmium {
                 return m_mapping_mode != mapping_mode::readonly;
             }
 
+            /**
+             * The options this mapping was created with.
+             */
+            const mapping_options& options() const noexcept {
+                return m_options;
+            }
+
             /**
              * Get the address of the mapping as any pointer type you like.
              *
@@ -304,8 +400,8 @@ namespace osmium {
 
         public:
 
-            explicit AnonymousMemoryMapping(std::size_t size) :
-                MemoryMapping(size, mapping_mode::write_private) {
+            explicit AnonymousMemoryMapping(std::size_t size, const mapping_options& options = mapping_options{}) :
+                MemoryMapping(size, mapping_mode::write_private, -1, 0, options) {
             }
 
 #ifndef __linux__
@@ -338,10 +434,11 @@ namespace osmium {
              * Create anonymous typed memory mapping of given size.
              *
              * @param size Number of objects of type T to be mapped
+             * @param options Options for huge pages, pre-faulting and access pattern
              * @throws std::system_error if the mapping fails
              */
-            explicit TypedMemoryMapping(std::size_t size) :
-                m_mapping(sizeof(T) * size, MemoryMapping::mapping_mode::write_private) {
+            explicit TypedMemoryMapping(std::size_t size, const mapping_options& options = mapping_options{}) :
+                m_mapping(sizeof(T) * size, MemoryMapping::mapping_mode::write_private, -1, 0, options) {
             }
 
             /**
@@ -352,10 +449,11 @@ namespace osmium {
              * @param mode Mapping mode: readonly, or writable (shared or private)
              * @param fd Open file descriptor of a file we want to map
              * @param offset Offset into the file where the mapping should start
+             * @param options Options for huge pages, pre-faulting and access pattern
              * @throws std::system_error if the mapping fails
              */
-            TypedMemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset = 0) :
-                m_mapping(sizeof(T) * size, mode, fd, sizeof(T) * offset) {
+            TypedMemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset = 0, const mapping_options& options = mapping_options{}) :
+                m_mapping(sizeof(T) * size, mode, fd, sizeof(T) * offset, options) {
             }
 
             /**
@@ -451,6 +549,13 @@ namespace osmium {
                 return m_mapping.writable();
             }
 
+            /**
+             * The options this mapping was created with.
+             */
+            const mapping_options& options() const noexcept {
+                return m_mapping.options();
+            }
+
             /**
              * Get the address of the beginning of the mapping.
              *
@@ -492,8 +597,8 @@ namespace osmium {
 
         public:
 
-            explicit AnonymousTypedMemoryMapping(std::size_t size) :
-                TypedMemoryMapping<T>(size) {
+            explicit AnonymousTypedMemoryMapping(std::size_t size, const mapping_options& options = mapping_options{}) :
+                TypedMemoryMapping<T>(size, options) {
             }
 
 #ifndef __linux__
@@ -540,26 +645,95 @@ inline int osmium::util::MemoryMapping::get_protection() const noexcept {
     return PROT_READ | PROT_WRITE;
 }
 
+inline bool osmium::util::MemoryMapping::use_hugetlb() const noexcept {
+#ifdef MAP_HUGETLB
+    return m_fd == -1 && m_options.huge_pages == mapping_options::huge_pages_mode::hugetlb;
+#else
+    return false;
+#endif
+}
+
+// With MAP_POPULATE the pages would be faulted in before we can ask for
+// transparent huge pages with madvise(), so in that case we populate the
+// mapping with madvise() after that.
+inline bool osmium::util::MemoryMapping::populate_after_advise() const noexcept {
+#if defined(MADV_HUGEPAGE) && defined(MADV_POPULATE_WRITE)
+    return m_options.populate && m_options.huge_pages == mapping_options::huge_pages_mode::transparent;
+#else
+    return false;
+#endif
+}
+
 inline int osmium::util::MemoryMapping::get_flags() const noexcept {
+    int flags = 0;
     if (m_fd == -1) {
-        return MAP_PRIVATE | MAP_ANONYMOUS;
+        flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    } else if (m_mapping_mode == mapping_mode::write_shared) {
+        flags = MAP_SHARED;
+    } else {
+        flags = MAP_PRIVATE;
+    }
+#ifdef MAP_HUGETLB
+    if (use_hugetlb()) {
+        flags |= MAP_HUGETLB;
+    }
+#endif
+#ifdef MAP_POPULATE
+    if (m_options.populate && !populate_after_advise()) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    return flags;
+}
+
+// Huge page mappings must be unmapped with a size that is a multiple of
+// the huge page size.
+inline std::size_t osmium::util::MemoryMapping::mapped_size() const noexcept {
+    if (use_hugetlb()) {
+        std::size_t huge_pagesize = get_huge_pagesize();
+        if (huge_pagesize == 0) {
+            huge_pagesize = 2 * 1024 * 1024;
+        }
+        return (m_size + huge_pagesize - 1) / huge_pagesize * huge_pagesize;
+    }
+    return m_size;
+}
+
+inline void* osmium::util::MemoryMapping::map() const noexcept {
+    return ::mmap(nullptr, mapped_size(), get_protection(), get_flags(), m_fd, m_offset);
+}
+
+// The advice is only a hint, so errors are ignored.
+inline void osmium::util::MemoryMapping::advise() const noexcept {
+#ifdef MADV_HUGEPAGE
+    if (m_options.huge_pages == mapping_options::huge_pages_mode::transparent) {
+        ::madvise(m_addr, m_size, MADV_HUGEPAGE);
+    }
+#endif
+    if (m_options.access == mapping_options::access_mode::sequential) {
+        ::madvise(m_addr, m_size, MADV_SEQUENTIAL);
+    } else if (m_options.access == mapping_options::access_mode::random) {
+        ::madvise(m_addr, m_size, MADV_RANDOM);
     }
-    if (m_mapping_mode == mapping_mode::write_shared) {
-        return MAP_SHARED;
+#ifdef MADV_POPULATE_WRITE
+    if (populate_after_advise()) {
+        ::madvise(m_addr, m_size, writable() ? MADV_POPULATE_WRITE : MADV_POPULATE_READ);
     }
-    return MAP_PRIVATE;
+#endif
 }
 
-inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, mapping_mode mode, int fd, off_t offset) :
+inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, mapping_mode mode, int fd, off_t offset, const mapping_options& options) :
     m_size(check_size(size)),
     m_offset(offset),
     m_fd(resize_fd(fd)),
     m_mapping_mode(mode),
-    m_addr(::mmap(nullptr, m_size, get_protection(), get_flags(), m_fd, m_offset)) {
+    m_options(options),
+    m_addr(map()) {
     assert(!(fd == -1 && mode == mapping_mode::readonly));
     if (!is_valid()) {
         throw std::system_error{errno, std::system_category(), "mmap failed"};
     }
+    advise();
 }
 
 inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcept :
@@ -567,6 +741,7 @@ inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcep
     m_offset(other.m_offset),
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
+    m_options(other.m_options),
     m_addr(other.m_addr) {
     other.make_invalid();
 }
@@ -577,6 +752,7 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
     m_offset       = other.m_offset;
     m_fd           = other.m_fd;
     m_mapping_mode = other.m_mapping_mode;
+    m_options      = other.m_options;
     m_addr         = other.m_addr;
     other.make_invalid();
     return *this;
@@ -584,7 +760,7 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
 
 inline void osmium::util::MemoryMapping::unmap() {
     if (is_valid()) {
-        if (::munmap(m_addr, m_size) != 0) {
+        if (::munmap(m_addr, mapped_size()) != 0) {
             throw std::system_error{errno, std::system_category(), "munmap failed"};
         }
         make_invalid();
@@ -593,13 +769,38 @@ inline void osmium::util::MemoryMapping::unmap() {
 
 inline void osmium::util::MemoryMapping::resize(std::size_t new_size) {
     assert(new_size > 0 && "can not resize to zero size");
-    if (m_fd == -1) { // anonymous mapping
+    if (use_hugetlb()) {
+        // Linux can not grow huge page mappings with mremap(), so we
+        // create a new mapping and copy the data over.
+        const std::size_t old_size = m_size;
+        void* old_addr = m_addr;
+        const std::size_t old_mapped_size = mapped_size();
+        m_size = new_size;
+        m_addr = map();
+        if (!is_valid()) {
+            const int error = errno;
+            m_addr = old_addr;
+            m_size = old_size;
+            throw std::system_error{error, std::system_category(), "mmap (remap) failed"};
+        }
+        advise();
+        std::memcpy(m_addr, old_addr, std::min(old_size, new_size));
+        if (::munmap(old_addr, old_mapped_size) != 0) {
+            throw std::system_error{errno, std::system_category(), "munmap failed"};
+        }
+    } else if (m_fd == -1) { // anonymous mapping
 #ifdef __linux__
         m_addr = ::mremap(m_addr, m_size, new_size, MREMAP_MAYMOVE);
         if (!is_valid()) {
             throw std::system_error{errno, std::system_category(), "mremap failed"};
         }
         m_size = new_size;
+        // mremap() keeps the advice but doesn't populate the new pages.
+#ifdef MADV_POPULATE_WRITE
+        if (m_options.populate) {
+            ::madvise(m_addr, m_size, MADV_POPULATE_WRITE);
+        }
+#endif
 #else
         assert(false && "can't resize anonymous mappings on non-linux systems");
 #endif
@@ -607,10 +808,11 @@ inline void osmium::util::MemoryMapping::resize(std::size_t new_size) {
         unmap();
         m_size = new_size;
         resize_fd(m_fd);
-        m_addr = ::mmap(nullptr, new_size, get_protection(), get_flags(), m_fd, m_offset);
+        m_addr = map();
         if (!is_valid()) {
             throw std::system_error{errno, std::system_category(), "mmap (remap) failed"};
         }
+        advise();
     }
 }
 
@@ -707,11 +909,12 @@ inline int last_error() noexcept {
     return static_cast<int>(GetLastError());
 }
 
-inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset) :
+inline osmium::util::MemoryMapping::MemoryMapping(std::size_t size, MemoryMapping::mapping_mode mode, int fd, off_t offset, const mapping_options& options) :
     m_size(check_size(size)),
     m_offset(offset),
     m_fd(resize_fd(fd)),
     m_mapping_mode(mode),
+    m_options(options),
     m_handle(create_file_mapping()),
     m_addr(nullptr) {
 
@@ -730,6 +933,7 @@ inline osmium::util::MemoryMapping::MemoryMapping(MemoryMapping&& other) noexcep
     m_offset(other.m_offset),
     m_fd(other.m_fd),
     m_mapping_mode(other.m_mapping_mode),
+    m_options(other.m_options),
     m_handle(std::move(other.m_handle)),
     m_addr(other.m_addr) {
     other.make_invalid();
@@ -742,6 +946,7 @@ inline osmium::util::MemoryMapping& osmium::util::MemoryMapping::operator=(osmiu
     m_offset       = other.m_offset;
     m_fd           = other.m_fd;
     m_mapping_mode = other.m_mapping_mode;
+    m_options      = other.m_options;
     m_handle       = std::move(other.m_handle);
     m_addr         = other.m_addr;
     other.make_invalid();
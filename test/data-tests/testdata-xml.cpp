@@ -76,8 +76,8 @@ static std::string read_gz_file(const char* test_id, const char* suffix) {
 // cppcheck-suppress passedByValue
 static header_buffer_type parse_xml(std::string input) {
     osmium::thread::Pool pool;
-    osmium::io::detail::future_string_queue_type input_queue;
-    osmium::io::detail::future_buffer_queue_type output_queue;
+    osmium::io::detail::future_string_queue_type input_queue{20};
+    osmium::io::detail::future_buffer_queue_type output_queue{20};
     std::promise<osmium::io::Header> header_promise;
     std::future<osmium::io::Header> header_future = header_promise.get_future();
 
@@ -90,7 +90,11 @@ static header_buffer_type parse_xml(std::string input) {
         output_queue,
         header_promise,
         osmium::osm_entity_bits::all,
-        osmium::io::read_meta::yes
+        osmium::io::read_meta::yes,
+        nullptr,
+        nullptr,
+        false,
+        nullptr
     };
     osmium::io::detail::XMLParser parser{args};
     parser.parse();
@@ -1,4 +1,5 @@
 
+#include <cstddef>
 #include <cstdlib>
 #include <string>
 
@@ -16,3 +17,13 @@ inline std::string with_data_dir(const char* filename) {
     return result;
 }
 
+// Some lines of text of the given size for compression tests. The text is
+// not too repetitive so it doesn't compress too well.
+inline std::string test_data(std::size_t size) {
+    std::string data;
+    for (unsigned int i = 0; data.size() < size; ++i) {
+        data += "line " + std::to_string(i * 2654435761U) + " with some text\n";
+    }
+    data.resize(size);
+    return data;
+}
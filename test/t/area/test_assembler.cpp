@@ -1,6 +1,14 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <utility>
+#include <vector>
+
 #include <osmium/area/assembler.hpp>
+#include <osmium/area/assembler_legacy.hpp>
 #include <osmium/builder/attr.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/area.hpp>
@@ -141,3 +149,220 @@ TEST_CASE("Build area from way with ignored invalid location") {
     REQUIRE(s.invalid_locations == 1);
 }
 
+
+TEST_CASE("Reuse assembler for several areas") {
+    osmium::memory::Buffer buffer{10240};
+
+    // Two squares touching in node 3, needs the complex case.
+    const auto w1 = osmium::builder::add_way(buffer,
+        _id(20),
+        _nodes({
+            {1, {0.0, 0.0}},
+            {2, {0.0, 4.0}},
+            {3, {4.0, 4.0}},
+            {4, {4.0, 8.0}},
+            {5, {8.0, 8.0}}
+        })
+    );
+    const auto w2 = osmium::builder::add_way(buffer,
+        _id(21),
+        _nodes({
+            {5, {8.0, 8.0}},
+            {6, {8.0, 4.0}},
+            {3, {4.0, 4.0}},
+            {7, {4.0, 0.0}},
+            {1, {0.0, 0.0}}
+        })
+    );
+    const auto r1 = osmium::builder::add_relation(buffer,
+        _id(1),
+        _member(osmium::item_type::way, 20, "outer"),
+        _member(osmium::item_type::way, 21, "outer"),
+        _tag("type", "multipolygon")
+    );
+
+    // Outer ring with inner ring.
+    const auto w3 = osmium::builder::add_way(buffer,
+        _id(30),
+        _nodes({
+            {11, {0.0, 0.0}},
+            {12, {0.0, 9.0}},
+            {13, {9.0, 9.0}},
+            {14, {9.0, 0.0}},
+            {11, {0.0, 0.0}}
+        })
+    );
+    const auto w4 = osmium::builder::add_way(buffer,
+        _id(31),
+        _nodes({
+            {15, {1.0, 1.0}},
+            {16, {1.0, 2.0}},
+            {17, {2.0, 2.0}},
+            {15, {1.0, 1.0}}
+        })
+    );
+    const auto r2 = osmium::builder::add_relation(buffer,
+        _id(2),
+        _member(osmium::item_type::way, 30, "outer"),
+        _member(osmium::item_type::way, 31, "inner"),
+        _tag("type", "multipolygon")
+    );
+
+    const auto& relation1 = buffer.get<osmium::Relation>(r1);
+    const std::vector<const osmium::Way*> members1 = {&buffer.get<osmium::Way>(w1), &buffer.get<osmium::Way>(w2)};
+    const auto& relation2 = buffer.get<osmium::Relation>(r2);
+    const std::vector<const osmium::Way*> members2 = {&buffer.get<osmium::Way>(w3), &buffer.get<osmium::Way>(w4)};
+
+    osmium::area::AssemblerConfig config;
+    osmium::area::Assembler assembler{config};
+
+    osmium::memory::Buffer area_buffer{10240};
+    for (int i = 0; i < 2; ++i) {
+        REQUIRE(assembler(relation1, members1, area_buffer));
+        REQUIRE(assembler(relation2, members2, area_buffer));
+        REQUIRE(assembler(buffer.get<osmium::Way>(w3), area_buffer));
+    }
+
+    const std::vector<std::pair<std::size_t, std::size_t>> expected = {{2, 0}, {1, 1}, {1, 0}};
+    std::size_t n = 0;
+    for (const auto& area : area_buffer.select<osmium::Area>()) {
+        REQUIRE(area.num_rings() == expected[n % expected.size()]);
+        for (const auto& ring : area.outer_rings()) {
+            REQUIRE(ring.size() == 5);
+        }
+        ++n;
+    }
+    REQUIRE(n == 6);
+
+    const auto& s = assembler.stats();
+    REQUIRE(s.from_relations == 4);
+    REQUIRE(s.from_ways == 2);
+    REQUIRE(s.touching_rings == 2);
+}
+
+TEST_CASE("Clear assembler") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto wpos = osmium::builder::add_way(buffer,
+        _id(1),
+        _nodes({
+            {1, {1.0, 1.0}},
+            {2, {1.0, 2.0}},
+            {3, {2.0, 2.0}},
+            {4, {2.0, 1.0}},
+            {1, {1.0, 1.0}}
+        })
+    );
+
+    osmium::area::AssemblerConfig config;
+    osmium::area::Assembler assembler{config};
+
+    osmium::memory::Buffer area_buffer{10240};
+    REQUIRE(assembler(buffer.get<osmium::Way>(wpos), area_buffer));
+    REQUIRE(assembler.stats().from_ways == 1);
+
+    assembler.clear();
+    REQUIRE(assembler.stats().from_ways == 0);
+    REQUIRE(assembler.stats().nodes == 0);
+
+    REQUIRE(assembler(buffer.get<osmium::Way>(wpos), area_buffer));
+
+    const auto& s = assembler.stats();
+    REQUIRE(s.area_simple_case == 1);
+    REQUIRE(s.from_ways == 1);
+    REQUIRE(s.nodes == 4);
+
+    for (const auto& area : area_buffer.select<osmium::Area>()) {
+        REQUIRE(area.id() == 2);
+        REQUIRE(area.num_rings().first == 1);
+        REQUIRE(area.outer_rings().begin()->size() == 5);
+    }
+}
+
+// Assemble the way with the Assembler (which writes simple rings directly)
+// and the AssemblerLegacy (which always does the full assembly) and check
+// that the results are the same.
+static bool compare_with_full_assembly(const osmium::Way& way) {
+    osmium::area::AssemblerConfig config;
+    osmium::area::Assembler assembler{config};
+    osmium::area::AssemblerLegacy assembler_legacy{config};
+
+    osmium::memory::Buffer buffer{10240};
+    osmium::memory::Buffer buffer_legacy{10240};
+    const bool okay = assembler(way, buffer);
+    REQUIRE(okay == assembler_legacy(way, buffer_legacy));
+    REQUIRE(buffer.committed() == buffer_legacy.committed());
+
+    if (okay) {
+        const auto& area = buffer.get<osmium::Area>(0);
+        const auto& area_legacy = buffer_legacy.get<osmium::Area>(0);
+        REQUIRE(area.id() == area_legacy.id());
+        REQUIRE(area.num_rings() == area_legacy.num_rings());
+        auto it_legacy = area_legacy.outer_rings().begin();
+        for (const auto& ring : area.outer_rings()) {
+            REQUIRE(ring.size() == it_legacy->size());
+            REQUIRE(std::equal(ring.cbegin(), ring.cend(), it_legacy->cbegin(), [](const osmium::NodeRef& a, const osmium::NodeRef& b) {
+                return a.ref() == b.ref() && a.location() == b.location();
+            }));
+            ++it_legacy;
+        }
+    }
+
+    const auto& s = assembler.stats();
+    const auto& sl = assembler_legacy.stats();
+    REQUIRE(s.from_ways == sl.from_ways);
+    REQUIRE(s.nodes == sl.nodes);
+    REQUIRE(s.area_simple_case == sl.area_simple_case);
+    REQUIRE(s.outer_rings == sl.outer_rings);
+    REQUIRE(s.inner_rings == sl.inner_rings);
+    REQUIRE(s.intersections == sl.intersections);
+    REQUIRE(s.touching_rings == sl.touching_rings);
+
+    return okay;
+}
+
+static bool assemble_closed_way(std::vector<osmium::NodeRef>& nodes) {
+    osmium::memory::Buffer buffer{10240};
+    nodes.push_back(nodes.front());
+    const auto wpos = osmium::builder::add_way(buffer, _id(1), _nodes(nodes));
+    return compare_with_full_assembly(buffer.get<osmium::Way>(wpos));
+}
+
+TEST_CASE("Simple rings are assembled like in the full assembly") {
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_int_distribution<int> num_nodes_dist{3, 12};
+    std::uniform_int_distribution<int> coord_dist{0, 4};
+    std::uniform_real_distribution<double> angle_dist{0.0, 6.28};
+    std::uniform_real_distribution<double> radius_dist{0.5, 2.0};
+
+    int okay = 0;
+    for (int n = 0; n < 2000; ++n) {
+        const int num_nodes = num_nodes_dist(gen);
+        std::vector<osmium::NodeRef> nodes;
+        if (n % 2 == 0) {
+            // Random locations on a small grid, often invalid
+            for (int i = 1; i <= num_nodes; ++i) {
+                nodes.emplace_back(i, osmium::Location{coord_dist(gen), coord_dist(gen)});
+            }
+        } else {
+            // Star shaped polygons, valid unless locations are the same
+            std::vector<double> angles;
+            for (int i = 0; i < num_nodes; ++i) {
+                angles.push_back(angle_dist(gen));
+            }
+            std::sort(angles.begin(), angles.end());
+            if (n % 4 == 1) {
+                std::reverse(angles.begin(), angles.end());
+            }
+            for (int i = 0; i < num_nodes; ++i) {
+                const double radius = radius_dist(gen);
+                nodes.emplace_back(i + 1, osmium::Location{radius * std::cos(angles[i]), radius * std::sin(angles[i])});
+            }
+        }
+        if (assemble_closed_way(nodes)) {
+            ++okay;
+        }
+    }
+
+    REQUIRE(okay > 1000);
+}
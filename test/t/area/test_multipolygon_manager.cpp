@@ -0,0 +1,190 @@
+#include "catch.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_manager.hpp>
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+using namespace osmium::builder::attr;
+
+static osmium::memory::Buffer create_data() {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    // outer and inner ring of multipolygon relation 1
+    osmium::builder::add_way(buffer, _id(10), _nodes({
+        {1, {0.0, 0.0}}, {2, {0.0, 10.0}}, {3, {10.0, 10.0}}, {4, {10.0, 0.0}}, {1, {0.0, 0.0}}
+    }));
+    osmium::builder::add_way(buffer, _id(11), _nodes({
+        {5, {2.0, 2.0}}, {6, {2.0, 3.0}}, {7, {3.0, 3.0}}, {8, {3.0, 2.0}}, {5, {2.0, 2.0}}
+    }));
+
+    // lots of buildings with ids 100, 103, 106, ...
+    for (int i = 0; i < 5000; ++i) {
+        const double x = 20.0 + (i % 100) * 0.01;
+        const double y = 20.0 + (i / 100) * 0.01;
+        const osmium::object_id_type n = 100 + i * 4;
+        osmium::builder::add_way(buffer, _id(100 + 3 * i), _tag("building", "yes"), _nodes({
+            {n,     {x,         y}},
+            {n + 1, {x,         y + 0.005}},
+            {n + 2, {x + 0.005, y + 0.005}},
+            {n + 3, {x + 0.005, y}},
+            {n,     {x,         y}}
+        }));
+
+        // member of multipolygon relation 2
+        if (i == 2500) {
+            osmium::builder::add_way(buffer, _id(7601), _nodes({
+                {1000001, {30.0, 30.0}}, {1000002, {30.0, 31.0}}, {1000003, {31.0, 31.0}}
+            }));
+            osmium::builder::add_way(buffer, _id(7602), _nodes({
+                {1000003, {31.0, 31.0}}, {1000004, {31.0, 30.0}}, {1000001, {30.0, 30.0}}
+            }));
+        }
+    }
+
+    osmium::builder::add_relation(buffer, _id(1), _tag("type", "multipolygon"), _tag("landuse", "forest"),
+        _member(osmium::item_type::way, 10, "outer"),
+        _member(osmium::item_type::way, 11, "inner"),
+        _member(osmium::item_type::node, 1, "")
+    );
+    osmium::builder::add_relation(buffer, _id(2), _tag("type", "multipolygon"), _tag("natural", "water"),
+        _member(osmium::item_type::way, 7601, "outer"),
+        _member(osmium::item_type::way, 7602, "outer")
+    );
+
+    return buffer;
+}
+
+struct assembly_result {
+    std::vector<osmium::object_id_type> ids;
+    std::vector<std::size_t> inner_rings;
+    osmium::area::area_stats stats;
+};
+
+static assembly_result assemble(const osmium::memory::Buffer& data, osmium::thread::Pool* pool) {
+    osmium::area::AssemblerConfig config;
+    osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config};
+    if (pool) {
+        manager.set_thread_pool(*pool);
+    }
+
+    osmium::apply(data, manager);
+    manager.prepare_for_lookup();
+
+    assembly_result result;
+    const auto collect = [&](const osmium::memory::Buffer& buffer) {
+        for (const auto& area : buffer.select<osmium::Area>()) {
+            result.ids.push_back(area.id());
+            result.inner_rings.push_back(area.subitems<osmium::InnerRing>().size());
+        }
+    };
+
+    osmium::apply(data, manager.handler([&](osmium::memory::Buffer&& buffer) {
+        collect(buffer);
+    }));
+    collect(manager.read());
+
+    result.stats = manager.stats();
+    return result;
+}
+
+TEST_CASE("Multipolygon manager assembles areas from ways and relations") {
+    const auto data = create_data();
+    const auto result = assemble(data, nullptr);
+
+    REQUIRE(result.ids.size() == 5002);
+    REQUIRE(result.ids[0] == 3); // relation 1 is complete after way 11
+    REQUIRE(result.ids[1] == 200);
+    REQUIRE(result.stats.from_ways == 5000);
+    REQUIRE(result.stats.from_relations == 2);
+    REQUIRE(result.stats.inner_rings == 1);
+
+    // relation 2 is complete after its second member way
+    const auto it = std::find(result.ids.begin(), result.ids.end(), 5);
+    REQUIRE(it != result.ids.end());
+    REQUIRE(*std::prev(it) == 2 * 7600);
+}
+
+TEST_CASE("Multipolygon manager assembles areas in thread pool") {
+    const auto data = create_data();
+    const auto expected = assemble(data, nullptr);
+
+    for (const int num_threads : {1, 2, 4}) {
+        osmium::thread::Pool pool{num_threads};
+        const auto result = assemble(data, &pool);
+
+        REQUIRE(result.ids == expected.ids);
+        REQUIRE(result.inner_rings == expected.inner_rings);
+        REQUIRE(result.stats.from_ways == expected.stats.from_ways);
+        REQUIRE(result.stats.from_relations == expected.stats.from_relations);
+        REQUIRE(result.stats.nodes == expected.stats.nodes);
+        REQUIRE(result.stats.inner_rings == expected.stats.inner_rings);
+        REQUIRE(result.stats.outer_rings == expected.stats.outer_rings);
+        REQUIRE(result.stats.area_simple_case == expected.stats.area_simple_case);
+    }
+}
+
+namespace {
+
+    class ThreadCheckingProblemReporter : public osmium::area::ProblemReporter {
+
+        std::thread::id m_thread_id{std::this_thread::get_id()};
+
+    public:
+
+        int count = 0;
+        bool other_thread = false;
+
+        void report_intersection(osmium::object_id_type /*way1_id*/, osmium::Location /*way1_seg_start*/, osmium::Location /*way1_seg_end*/,
+                                 osmium::object_id_type /*way2_id*/, osmium::Location /*way2_seg_start*/, osmium::Location /*way2_seg_end*/, osmium::Location /*intersection*/) override {
+            ++count;
+            if (std::this_thread::get_id() != m_thread_id) {
+                other_thread = true;
+            }
+        }
+
+    }; // class ThreadCheckingProblemReporter
+
+} // anonymous namespace
+
+TEST_CASE("Multipolygon manager doesn't use thread pool with problem reporter") {
+    osmium::memory::Buffer data{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    // self-intersecting buildings
+    for (int i = 0; i < 2000; ++i) {
+        const double x = (i % 100) * 0.01;
+        const double y = (i / 100) * 0.01;
+        const osmium::object_id_type n = 1 + i * 4;
+        osmium::builder::add_way(data, _id(1 + i), _tag("building", "yes"), _nodes({
+            {n,     {x,         y}},
+            {n + 1, {x + 0.005, y + 0.005}},
+            {n + 2, {x + 0.005, y}},
+            {n + 3, {x,         y + 0.005}},
+            {n,     {x,         y}}
+        }));
+    }
+
+    ThreadCheckingProblemReporter reporter;
+    osmium::area::AssemblerConfig config{&reporter};
+    osmium::area::MultipolygonManager<osmium::area::Assembler> manager{config};
+
+    osmium::thread::Pool pool{4};
+    manager.set_thread_pool(pool);
+
+    osmium::apply(data, manager);
+    manager.prepare_for_lookup();
+    osmium::apply(data, manager.handler());
+    manager.read();
+
+    REQUIRE(reporter.count == 2000);
+    REQUIRE_FALSE(reporter.other_thread);
+}
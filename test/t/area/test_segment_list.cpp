@@ -0,0 +1,130 @@
+#include "catch.hpp"
+
+#include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace osmium::builder::attr;
+
+using intersection_type = std::tuple<osmium::Location, osmium::Location, osmium::Location, osmium::Location, osmium::Location>;
+
+class IntersectionRecorder : public osmium::area::ProblemReporter {
+
+public:
+
+    std::vector<intersection_type> intersections;
+
+    void report_intersection(osmium::object_id_type /*way1_id*/, osmium::Location way1_seg_start, osmium::Location way1_seg_end,
+                             osmium::object_id_type /*way2_id*/, osmium::Location way2_seg_start, osmium::Location way2_seg_end, osmium::Location intersection) override {
+        intersections.emplace_back(way1_seg_start, way1_seg_end, way2_seg_start, way2_seg_end, intersection);
+    }
+
+}; // class IntersectionRecorder
+
+// Check all pairs of segments.
+static std::vector<intersection_type> brute_force(const osmium::area::detail::SegmentList& segments) {
+    std::vector<intersection_type> intersections;
+
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        for (std::size_t j = i + 1; j < segments.size(); ++j) {
+            const auto& s1 = segments[i];
+            const auto& s2 = segments[j];
+            if (!osmium::area::detail::outside_x_range(s2, s1) && osmium::area::detail::y_range_overlap(s1, s2)) {
+                const osmium::Location intersection{osmium::area::detail::calculate_intersection(s1, s2)};
+                if (intersection) {
+                    intersections.emplace_back(s1.first().location(), s1.second().location(), s2.first().location(), s2.second().location(), intersection);
+                }
+            }
+        }
+    }
+
+    return intersections;
+}
+
+static void check_intersections(const std::vector<osmium::NodeRef>& nodes) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes(nodes));
+    const auto& way = buffer.get<osmium::Way>(pos);
+
+    osmium::area::detail::SegmentList segments{false};
+    uint64_t duplicate_nodes = 0;
+    uint64_t duplicate_segments = 0;
+    uint64_t overlapping_segments = 0;
+    segments.extract_segments_from_way(nullptr, duplicate_nodes, way);
+    segments.sort();
+    segments.erase_duplicate_segments(nullptr, duplicate_segments, overlapping_segments);
+
+    IntersectionRecorder recorder;
+    const auto count = segments.find_intersections(&recorder);
+
+    const auto expected = brute_force(segments);
+    REQUIRE(count == expected.size());
+    REQUIRE(recorder.intersections == expected);
+}
+
+TEST_CASE("Find intersections in small segment list") {
+    check_intersections({
+        {1, {1.0, 1.0}},
+        {2, {1.0, 2.0}},
+        {3, {2.0, 1.0}},
+        {4, {2.0, 2.0}},
+        {1, {1.0, 1.0}}
+    });
+}
+
+TEST_CASE("Find intersections in random segments") {
+    std::mt19937 gen{42};
+    std::uniform_real_distribution<double> dist{-10.0, 10.0};
+
+    std::vector<osmium::NodeRef> nodes;
+    for (int i = 1; i <= 2000; ++i) {
+        nodes.emplace_back(i, osmium::Location{dist(gen), dist(gen)});
+    }
+    nodes.push_back(nodes.front());
+
+    check_intersections(nodes);
+}
+
+TEST_CASE("Find intersections in random walk") {
+    std::mt19937 gen{23};
+    std::uniform_real_distribution<double> dist{-0.01, 0.01};
+
+    std::vector<osmium::NodeRef> nodes;
+    double x = 0.0;
+    double y = 0.0;
+    for (int i = 1; i <= 20000; ++i) {
+        x += dist(gen);
+        y += dist(gen);
+        nodes.emplace_back(i, osmium::Location{x, y});
+    }
+    nodes.push_back(nodes.front());
+
+    check_intersections(nodes);
+}
+
+TEST_CASE("Find intersections in long boundary") {
+    // A large circle with a few long segments crossing it.
+    std::vector<osmium::NodeRef> nodes;
+    const int num = 10000;
+    for (int i = 0; i < num; ++i) {
+        const double angle = 2 * 3.14159265358979 * i / num;
+        nodes.emplace_back(i + 1, osmium::Location{10.0 * std::cos(angle), 5.0 * std::sin(angle)});
+    }
+    nodes.emplace_back(num + 1, osmium::Location{-20.0, 0.1});
+    nodes.emplace_back(num + 2, osmium::Location{20.0, 0.2});
+    nodes.emplace_back(num + 3, osmium::Location{0.3, -20.0});
+    nodes.emplace_back(num + 4, osmium::Location{0.4, 20.0});
+    nodes.push_back(nodes.front());
+
+    check_intersections(nodes);
+}
@@ -0,0 +1,126 @@
+#include "catch.hpp"
+
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/opl.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <vector>
+
+static osmium::memory::Buffer fill_buffer() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    REQUIRE(osmium::opl_parse("n-2 x1.5 y2.5", buffer));
+    REQUIRE(osmium::opl_parse("n-1 x1.0 y2.0", buffer));
+    REQUIRE(osmium::opl_parse("n1 x3.0 y4.0", buffer));
+    REQUIRE(osmium::opl_parse("n2 x3.5 y4.5", buffer));
+    REQUIRE(osmium::opl_parse("n5 x5.0 y6.0", buffer));
+    REQUIRE(osmium::opl_parse("w1 Nn1,n2,n5", buffer));
+    REQUIRE(osmium::opl_parse("w2 Nn-1,n1,n-2", buffer));
+    REQUIRE(osmium::opl_parse("w3 Nn5,n1", buffer));
+
+    return buffer;
+}
+
+static std::vector<osmium::Location> way_locations(const osmium::memory::Buffer& buffer) {
+    std::vector<osmium::Location> locations;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        for (const auto& node_ref : way.nodes()) {
+            locations.push_back(node_ref.location());
+        }
+    }
+    return locations;
+}
+
+template <typename TIndex>
+void test_process_buffer() {
+    auto buffer1 = fill_buffer();
+    auto buffer2 = fill_buffer();
+
+    {
+        TIndex index_pos;
+        TIndex index_neg;
+        osmium::handler::NodeLocationsForWays<TIndex, TIndex> handler{index_pos, index_neg};
+        osmium::apply(buffer1, handler);
+    }
+
+    {
+        TIndex index_pos;
+        TIndex index_neg;
+        osmium::handler::NodeLocationsForWays<TIndex, TIndex> handler{index_pos, index_neg};
+        handler.process_buffer(buffer2);
+    }
+
+    const auto locations = way_locations(buffer2);
+    REQUIRE(locations == way_locations(buffer1));
+    REQUIRE(locations.size() == 8);
+    REQUIRE(locations[0] == osmium::Location(3.0, 4.0));
+    REQUIRE(locations[3] == osmium::Location(1.0, 2.0));
+    REQUIRE(locations[5] == osmium::Location(1.5, 2.5));
+    REQUIRE(locations[7] == osmium::Location(3.0, 4.0));
+}
+
+TEST_CASE("NodeLocationsForWays with buffer: DenseMemArray") {
+    test_process_buffer<osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>>();
+}
+
+TEST_CASE("NodeLocationsForWays with buffer: SparseMemArray") {
+    test_process_buffer<osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>>();
+}
+
+TEST_CASE("NodeLocationsForWays with buffer: FlexMem") {
+    test_process_buffer<osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>>();
+}
+
+TEST_CASE("NodeLocationsForWays with buffer: missing locations") {
+    using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+    osmium::memory::Buffer buffer{1024};
+    REQUIRE(osmium::opl_parse("n1 x3.0 y4.0", buffer));
+    REQUIRE(osmium::opl_parse("w1 Nn1,n2", buffer));
+    REQUIRE(osmium::opl_parse("w2 Nn1", buffer));
+
+    index_type index;
+    osmium::handler::NodeLocationsForWays<index_type> handler{index};
+
+    SECTION("throw") {
+        REQUIRE_THROWS_AS(handler.process_buffer(buffer), const osmium::not_found&);
+    }
+
+    SECTION("ignore errors") {
+        handler.ignore_errors();
+        handler.process_buffer(buffer);
+    }
+
+    const auto locations = way_locations(buffer);
+    REQUIRE(locations.size() == 3);
+    REQUIRE(locations[0] == osmium::Location(3.0, 4.0));
+    REQUIRE_FALSE(locations[1]);
+    REQUIRE(locations[2] == osmium::Location(3.0, 4.0));
+}
+
+TEST_CASE("Map get_many") {
+    using index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index;
+    for (osmium::unsigned_object_id_type id = 1; id < 100; id += 2) {
+        index.set(id, osmium::Location{int32_t(id), int32_t(id * 2)});
+    }
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 0; id < 120; ++id) {
+        ids.push_back((id * 7) % 120);
+    }
+
+    std::vector<osmium::Location> locations(ids.size());
+    const osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>& map = index;
+    map.get_many(ids.data(), locations.data(), ids.size());
+
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(locations[i] == index.get_noexcept(ids[i]));
+    }
+}
@@ -0,0 +1,128 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/compact_mem.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+using index_type = osmium::index::map::CompactMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location location_for(osmium::unsigned_object_id_type id) {
+    return osmium::Location{int32_t(int64_t(id * 37 % 3600000000) - 1800000000),
+                            int32_t(int64_t(id * 11 % 1800000000) - 900000000)};
+}
+
+TEST_CASE("CompactMem with many entries in order") {
+    index_type index;
+
+    for (osmium::unsigned_object_id_type id = 10; id < 10000; id += 3) {
+        index.set(id, location_for(id));
+    }
+    index.sort();
+
+    REQUIRE(index.size() == 3330);
+    REQUIRE(index.used_memory() < index.size() * 16);
+
+    for (osmium::unsigned_object_id_type id = 0; id < 10010; ++id) {
+        if (id >= 10 && id < 10000 && (id - 10) % 3 == 0) {
+            REQUIRE(index.get(id) == location_for(id));
+        } else {
+            REQUIRE(index.get_noexcept(id) == osmium::Location{});
+        }
+    }
+}
+
+TEST_CASE("CompactMem with entries out of order and duplicates") {
+    index_type index;
+
+    for (osmium::unsigned_object_id_type id = 1000; id < 2000; ++id) {
+        index.set(id, location_for(id));
+    }
+    for (osmium::unsigned_object_id_type id = 500; id > 0; --id) {
+        index.set(id, location_for(id));
+    }
+    index.set(1500, osmium::Location{1.0, 2.0});
+    index.set(1500, osmium::Location{3.0, 4.0});
+    index.sort();
+
+    REQUIRE(index.size() == 1500);
+    REQUIRE(index.get(1) == location_for(1));
+    REQUIRE(index.get(500) == location_for(500));
+    REQUIRE(index.get(1000) == location_for(1000));
+    REQUIRE(index.get(1999) == location_for(1999));
+    REQUIRE(index.get(1500) == (osmium::Location{3.0, 4.0}));
+    REQUIRE_THROWS_AS(index.get(750), const osmium::not_found&);
+}
+
+TEST_CASE("CompactMem stores invalid locations") {
+    index_type index;
+
+    index.set(1, osmium::Location{1.0, 1.0});
+    index.set(2, osmium::Location{});
+    index.set(3, osmium::Location{-179.9, 89.9});
+
+    REQUIRE(index.get_noexcept(2) == osmium::Location{});
+    REQUIRE(index.get(3) == (osmium::Location{-179.9, 89.9}));
+}
+
+TEST_CASE("CompactMem can be dumped as list") {
+    index_type index;
+
+    for (osmium::unsigned_object_id_type id = 1; id <= 200; ++id) {
+        index.set(id * 2, location_for(id));
+    }
+
+    FILE* file = std::tmpfile();
+    REQUIRE(file);
+    const int fd = fileno(file);
+    index.dump_as_list(fd);
+
+    using element_type = std::pair<osmium::unsigned_object_id_type, osmium::Location>;
+    REQUIRE(osmium::util::file_size(fd) == 200 * sizeof(element_type));
+
+    std::vector<element_type> elements(200);
+    REQUIRE(::lseek(fd, 0, SEEK_SET) == 0);
+    REQUIRE(::read(fd, elements.data(), 200 * sizeof(element_type)) == static_cast<ssize_t>(200 * sizeof(element_type)));
+    for (osmium::unsigned_object_id_type id = 1; id <= 200; ++id) {
+        REQUIRE(elements[id - 1].first == id * 2);
+        REQUIRE(elements[id - 1].second == location_for(id));
+    }
+
+    std::fclose(file);
+}
+
+TEST_CASE("CompactMem can be created through the map factory") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    REQUIRE(map_factory.has_map_type("compact_mem"));
+
+    auto index = map_factory.create_map("compact_mem");
+    index->set(7, osmium::Location{1.5, 2.5});
+    index->sort();
+    REQUIRE(index->get(7) == (osmium::Location{1.5, 2.5}));
+}
+
+TEST_CASE("CompactMem get_many") {
+    index_type index;
+
+    for (osmium::unsigned_object_id_type id = 1; id < 1000; id += 2) {
+        index.set(id, location_for(id));
+    }
+
+    const std::vector<osmium::unsigned_object_id_type> ids = {999, 1, 2, 500, 501, 0, 1001, 37};
+    std::vector<osmium::Location> locations(ids.size());
+    index.get_many(ids.data(), locations.data(), ids.size());
+
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(locations[i] == index.get_noexcept(ids[i]));
+    }
+    REQUIRE(locations[0] == location_for(999));
+    REQUIRE(locations[2] == osmium::Location{});
+}
@@ -3,6 +3,7 @@
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/location.hpp>
 
+#include <osmium/index/map/compact_mem.hpp>
 #include <osmium/index/map/dense_file_array.hpp>
 #include <osmium/index/map/dense_mem_array.hpp>
 #include <osmium/index/map/dense_mmap_array.hpp>
@@ -233,6 +234,21 @@ TEST_CASE("Map Id to location: FlexMem switch") {
     REQUIRE(index.get_noexcept(2000000000) == osmium::Location{});
 }
 
+TEST_CASE("Map Id to location: CompactMem") {
+    using index_type = osmium::index::map::CompactMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+
+    REQUIRE(0 == index1.size());
+
+    test_func_all<index_type>(index1);
+
+    REQUIRE(2 == index1.size());
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
 TEST_CASE("Map Id to location: Dynamic map choice") {
     using map_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
     const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
@@ -0,0 +1,108 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/parse_mapping_options.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/index/map/dense_mmap_array.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/index/map/sparse_mmap_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+using options_type = osmium::util::mapping_options;
+
+TEST_CASE("Parse empty mapping options") {
+    const auto options = osmium::index::detail::parse_mapping_options({"dense_mmap_array"}, 1);
+    REQUIRE(options.huge_pages == options_type::huge_pages_mode::none);
+    REQUIRE(options.access == options_type::access_mode::normal);
+    REQUIRE_FALSE(options.populate);
+}
+
+TEST_CASE("Parse mapping options") {
+    const auto options = osmium::index::detail::parse_mapping_options({"dense_mmap_array", "hugepages", "populate", "random"}, 1);
+    REQUIRE(options.huge_pages == options_type::huge_pages_mode::transparent);
+    REQUIRE(options.access == options_type::access_mode::random);
+    REQUIRE(options.populate);
+
+    const auto options2 = osmium::index::detail::parse_mapping_options({"dense_file_array", "index.dat", "hugetlb", "sequential"}, 2);
+    REQUIRE(options2.huge_pages == options_type::huge_pages_mode::hugetlb);
+    REQUIRE(options2.access == options_type::access_mode::sequential);
+    REQUIRE_FALSE(options2.populate);
+}
+
+TEST_CASE("Parse unknown mapping option") {
+    REQUIRE_THROWS_AS(osmium::index::detail::parse_mapping_options({"dense_mmap_array", "foo"}, 1), const osmium::map_factory_error&);
+    REQUIRE_THROWS_WITH(osmium::index::detail::parse_mapping_options({"dense_mmap_array", "foo"}, 1), "Unknown option 'foo' for map type 'dense_mmap_array'");
+}
+
+#ifdef __linux__
+TEST_CASE("Create dense mmap array with mapping options") {
+    using index_type = osmium::index::map::DenseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    std::unique_ptr<index_type> index{osmium::index::map::create_map<osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseMmapArray>()({"dense_mmap_array", "hugepages", "populate"})};
+
+    const osmium::Location loc{1.2, 4.5};
+    index->set(17, loc);
+    index->set(3000000, loc);
+    REQUIRE(index->get(17) == loc);
+    REQUIRE(index->get(3000000) == loc);
+    REQUIRE(index->size() == 3000001);
+}
+
+TEST_CASE("Create sparse mmap array with mapping options") {
+    using index_type = osmium::index::map::SparseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    std::unique_ptr<index_type> index{osmium::index::map::create_map<osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMmapArray>()({"sparse_mmap_array", "random"})};
+
+    const osmium::Location loc{1.2, 4.5};
+    index->set(17, loc);
+    index->sort();
+    REQUIRE(index->get(17) == loc);
+}
+
+TEST_CASE("Create mmap array with unknown mapping option") {
+    REQUIRE_THROWS_AS((osmium::index::map::create_map<osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseMmapArray>()({"dense_mmap_array", "foo"})), const osmium::map_factory_error&);
+}
+#endif
+
+TEST_CASE("Create dense file array with mapping options") {
+    using index_type = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const std::string filename{"test_mapping_options_dense.idx"};
+    const osmium::Location loc{1.2, 4.5};
+
+    {
+        std::unique_ptr<index_type> index{osmium::index::map::create_map<osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseFileArray>()({"dense_file_array", filename, "populate", "sequential"})};
+        index->set(17, loc);
+        REQUIRE(index->get(17) == loc);
+    }
+
+    {
+        std::unique_ptr<index_type> index{osmium::index::map::create_map<osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseFileArray>()({"dense_file_array", filename})};
+        REQUIRE(index->get(17) == loc);
+    }
+
+    REQUIRE(0 == std::remove(filename.c_str()));
+}
+
+TEST_CASE("Create sparse file array with mapping options") {
+    using index_type = osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const std::string filename{"test_mapping_options_sparse.idx"};
+    const osmium::Location loc{1.2, 4.5};
+
+    {
+        std::unique_ptr<index_type> index{osmium::index::map::create_map<osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseFileArray>()({"sparse_file_array", filename, "random"})};
+        index->set(17, loc);
+        index->sort();
+        REQUIRE(index->get(17) == loc);
+    }
+
+    REQUIRE(0 == std::remove(filename.c_str()));
+}
@@ -6,6 +6,15 @@
 #include <fcntl.h>
 
 #include <osmium/io/bzip2_compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
+#include <chrono>
+#include <future>
+#include <random>
+#include <string>
+#include <thread>
 
 TEST_CASE("Read bzip2-compressed file") {
     const std::string input_file = with_data_dir("t/io/data_bzip2.txt.bz2");
@@ -27,3 +36,203 @@ TEST_CASE("Read bzip2-compressed file") {
     REQUIRE("TESTDATA\n" == all);
 }
 
+static void write_bzip2(const char* filename, const std::string& data, bool append = false) {
+    const int fd = append ? ::open(filename, O_WRONLY | O_APPEND) : osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    REQUIRE(fd >= 0);
+    osmium::io::Bzip2Compressor compressor{fd, osmium::io::fsync::no};
+    if (!data.empty()) {
+        compressor.write(data);
+    }
+    compressor.close();
+    osmium::io::detail::reliable_close(fd);
+}
+
+static std::string read_bzip2_parallel(const char* filename) {
+    osmium::thread::Pool pool{3};
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    osmium::io::Bzip2ParallelDecompressor decompressor{fd, pool};
+    std::string all;
+    for (std::string data = decompressor.read(); !data.empty(); data = decompressor.read()) {
+        all += data;
+    }
+    decompressor.close();
+    return all;
+}
+
+TEST_CASE("Read small bzip2-compressed file in parallel") {
+    const std::string input_file = with_data_dir("t/io/data_bzip2.txt.bz2");
+    REQUIRE(read_bzip2_parallel(input_file.c_str()) == "TESTDATA\n");
+}
+
+TEST_CASE("Read bzip2-compressed file with many blocks in parallel") {
+    const std::string data = test_data(5 * 1024 * 1024 + 7);
+    write_bzip2("test-bzip2-blocks.bz2", data);
+    REQUIRE(read_bzip2_parallel("test-bzip2-blocks.bz2") == data);
+}
+
+TEST_CASE("Read bzip2-compressed file with several streams in parallel") {
+    const std::string data1 = test_data(1024 * 1024);
+    const std::string data2 = test_data(100);
+    write_bzip2("test-bzip2-streams.bz2", data1);
+    write_bzip2("test-bzip2-streams.bz2", "", true);
+    write_bzip2("test-bzip2-streams.bz2", data2, true);
+    write_bzip2("test-bzip2-streams.bz2", data1, true);
+    REQUIRE(read_bzip2_parallel("test-bzip2-streams.bz2") == data1 + data2 + data1);
+}
+
+TEST_CASE("Read empty bzip2-compressed file in parallel") {
+    write_bzip2("test-bzip2-empty.bz2", "");
+    REQUIRE(read_bzip2_parallel("test-bzip2-empty.bz2").empty());
+}
+
+TEST_CASE("Read corrupted bzip2-compressed file in parallel") {
+    write_bzip2("test-bzip2-corrupt.bz2", test_data(2 * 1024 * 1024));
+    const int fd = ::open("test-bzip2-corrupt.bz2", O_RDWR);
+    REQUIRE(fd >= 0);
+    REQUIRE(::lseek(fd, 1000, SEEK_SET) == 1000);
+    osmium::io::detail::reliable_write(fd, "xxxxxxxx", 8);
+    osmium::io::detail::reliable_close(fd);
+
+    REQUIRE_THROWS_AS(read_bzip2_parallel("test-bzip2-corrupt.bz2"), const osmium::bzip2_error&);
+}
+
+TEST_CASE("Read truncated bzip2-compressed file in parallel") {
+    const std::string data = test_data(2 * 1024 * 1024);
+    write_bzip2("test-bzip2-truncated.bz2", data);
+    const int fd = ::open("test-bzip2-truncated.bz2", O_RDWR);
+    REQUIRE(fd >= 0);
+    osmium::util::resize_file(fd, osmium::util::file_size(fd) - 100);
+    osmium::io::detail::reliable_close(fd);
+
+    REQUIRE_THROWS_AS(read_bzip2_parallel("test-bzip2-truncated.bz2"), const osmium::bzip2_error&);
+}
+
+TEST_CASE("Find bzip2 magic numbers at all bit positions") {
+    namespace oid = osmium::io::detail;
+
+    for (std::size_t offset = 0; offset < 24; ++offset) {
+        std::string data(20, '\0');
+        for (std::size_t i = 0; i < 48; ++i) {
+            if ((oid::bzip2_block_magic >> (47 - i)) & 1U) {
+                const std::size_t bit = offset + 40 + i;
+                data[bit / 8] = static_cast<char>(data[bit / 8] | (0x80U >> (bit % 8)));
+            }
+        }
+        REQUIRE(oid::find_bzip2_magic(data.data(), data.size(), 0) == offset + 40);
+        REQUIRE(oid::find_bzip2_magic(data.data(), data.size(), offset + 3) == offset + 40);
+        REQUIRE(oid::find_bzip2_magic(data.data(), data.size(), offset + 40) == offset + 40);
+        REQUIRE(oid::find_bzip2_magic(data.data(), data.size(), offset + 41) == data.size() * 8);
+    }
+}
+
+TEST_CASE("Decompress bzip2 block with magic number inside data") {
+    namespace oid = osmium::io::detail;
+
+    write_bzip2("test-bzip2-magic.bz2", test_data(1000));
+    const int fd = osmium::io::detail::open_for_reading("test-bzip2-magic.bz2");
+    std::string input(osmium::util::file_size(fd), '\0');
+    REQUIRE(::read(fd, &input[0], input.size()) == static_cast<ssize_t>(input.size()));
+    osmium::io::detail::reliable_close(fd);
+
+    const std::size_t begin = 32;
+    const std::size_t end = oid::find_bzip2_magic(input.data(), input.size(), begin + 48);
+    REQUIRE(oid::get_bits(input.data(), begin, 48) == oid::bzip2_block_magic);
+    REQUIRE(oid::get_bits(input.data(), end, 48) == oid::bzip2_eos_magic);
+
+    // Split the block at some bit position as if a magic number was found
+    // there. The parts can't be decompressed, but together they can.
+    const std::size_t split = begin + (end - begin) / 2 + 3;
+    oid::bzip2_block block1{input.data(), begin, split};
+    oid::bzip2_block block2{input.data(), split, end};
+    REQUIRE_THROWS_AS(oid::Bzip2BlockDecompressor{oid::bzip2_block{block1}}(), const osmium::bzip2_error&);
+    block1.append(block2);
+    REQUIRE(oid::Bzip2BlockDecompressor{std::move(block1)}() == test_data(1000));
+}
+
+// Create data which contains exactly the bytes for which the symbol map
+// in the header of each bzip2 block is the block magic number twice. The
+// magic numbers then appear at bits 121 and 169 of each block, so every
+// block is split into three presumed blocks by the parallel decompressor.
+static std::string data_with_magic_in_symbol_map(std::size_t size) {
+    const uint16_t maps[] = {0x3141, 0x5926, 0x5359, 0x3141, 0x5926, 0x5359};
+    std::string symbols;
+    for (unsigned int range = 0; range < 6; ++range) {
+        for (unsigned int n = 0; n < 16; ++n) {
+            if (maps[range] & (0x8000U >> n)) {
+                symbols += static_cast<char>(range * 16 + n);
+            }
+        }
+    }
+
+    std::mt19937 gen{17}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_int_distribution<std::size_t> dist{0, symbols.size() - 1};
+    std::string data;
+    while (data.size() < size) {
+        // no runs of the same byte, bzip2 would add run lengths as symbols
+        const char c = symbols[dist(gen)];
+        if (data.empty() || data.back() != c) {
+            data += c;
+        }
+    }
+    return data;
+}
+
+TEST_CASE("Read bzip2-compressed file with magic numbers inside blocks in parallel") {
+    namespace oid = osmium::io::detail;
+
+    const std::string data = data_with_magic_in_symbol_map(2 * 1024 * 1024);
+    write_bzip2("test-bzip2-magic-in-blocks.bz2", data);
+
+    const int fd = osmium::io::detail::open_for_reading("test-bzip2-magic-in-blocks.bz2");
+    std::string input(osmium::util::file_size(fd), '\0');
+    REQUIRE(::read(fd, &input[0], input.size()) == static_cast<ssize_t>(input.size()));
+    osmium::io::detail::reliable_close(fd);
+
+    // The first block starts after the 32 bit stream header and has two
+    // more magic numbers inside.
+    REQUIRE(oid::find_bzip2_magic(input.data(), input.size(), 32) == 32);
+    REQUIRE(oid::find_bzip2_magic(input.data(), input.size(), 32 + 48) == 32 + 121);
+    REQUIRE(oid::find_bzip2_magic(input.data(), input.size(), 32 + 121 + 48) == 32 + 169);
+
+    REQUIRE(read_bzip2_parallel("test-bzip2-magic-in-blocks.bz2") == data);
+}
+
+TEST_CASE("Bzip2 decompressor from factory uses the thread pool it is given") {
+    const std::string data = test_data(2 * 1024 * 1024);
+    write_bzip2("test-bzip2-pool.bz2", data);
+
+    // Block the only worker of the pool, so the decompression tasks
+    // stay in its queue if they are submitted to this pool.
+    osmium::thread::Pool pool{1};
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::promise<void> started;
+    auto blocker = pool.submit([&started, released] {
+        started.set_value();
+        released.wait();
+    });
+    started.get_future().wait();
+
+    const int fd = osmium::io::detail::open_for_reading("test-bzip2-pool.bz2");
+    const auto decompressor = osmium::io::CompressionFactory::instance().create_decompressor(osmium::io::file_compression::bzip2, fd);
+    decompressor->use_thread_pool(pool);
+
+    auto result = std::async(std::launch::async, [&decompressor] {
+        std::string all;
+        for (std::string buffer = decompressor->read(); !buffer.empty(); buffer = decompressor->read()) {
+            all += buffer;
+        }
+        return all;
+    });
+
+    for (int i = 0; i < 1000 && pool.queue_empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    const bool tasks_in_pool = !pool.queue_empty();
+    release.set_value();
+    blocker.get();
+    REQUIRE(tasks_in_pool);
+
+    REQUIRE(result.get() == data);
+    decompressor->close();
+}
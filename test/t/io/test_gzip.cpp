@@ -0,0 +1,198 @@
+#include "catch.hpp"
+#include "utils.hpp"
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/pool.hpp>
+
+static void write_gzip(const char* filename, const std::string& data, osmium::thread::Pool* pool, bool append = false) {
+    const int fd = append ? ::open(filename, O_WRONLY | O_APPEND) : osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    REQUIRE(fd >= 0);
+    osmium::io::GzipCompressor compressor{fd, osmium::io::fsync::no};
+    if (pool) {
+        compressor.compress_in_parallel(*pool);
+    }
+    // write in pieces of different sizes
+    for (std::size_t pos = 0, n = 1; pos < data.size(); pos += n, n = n * 3 + 1) {
+        compressor.write(data.substr(pos, n));
+    }
+    compressor.close();
+}
+
+static std::string read_gzip(const char* filename) {
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    osmium::io::GzipDecompressor decompressor{fd};
+    std::string all;
+    for (std::string data = decompressor.read(); !data.empty(); data = decompressor.read()) {
+        all += data;
+    }
+    decompressor.close();
+    return all;
+}
+
+static std::string read_gzip_with_zlib(const char* filename) {
+    gzFile gzfile = ::gzopen(filename, "rb");
+    REQUIRE(gzfile);
+    std::string all;
+    char buffer[10000];
+    int n;
+    while ((n = ::gzread(gzfile, buffer, sizeof(buffer))) > 0) {
+        all.append(buffer, std::size_t(n));
+    }
+    REQUIRE(n == 0);
+    ::gzclose(gzfile);
+    return all;
+}
+
+TEST_CASE("Parse gzip member headers") {
+    namespace oid = osmium::io::detail;
+
+    // BGZF header with BSIZE 0x1234
+    const std::string bgzf("\x1f\x8b\x08\x04\0\0\0\0\0\xff\x06\0BC\x02\0\x34\x12", 18);
+    auto header = oid::parse_gzip_member_header(bgzf.data(), bgzf.size());
+    REQUIRE(header.header_size == 18);
+    REQUIRE(header.member_size == 0x1235);
+
+    REQUIRE(oid::parse_gzip_member_header(bgzf.data(), 17).header_size == 0);
+
+    // header with file name and without size
+    const std::string named("\x1f\x8b\x08\x08\0\0\0\0\0\x03name\0", 15);
+    header = oid::parse_gzip_member_header(named.data(), named.size());
+    REQUIRE(header.header_size == 15);
+    REQUIRE(header.member_size == 0);
+
+    REQUIRE(oid::parse_gzip_member_header(named.data(), 14).header_size == 0);
+
+    REQUIRE_THROWS_AS(oid::parse_gzip_member_header("not a gzip file", 15), const osmium::gzip_error&);
+}
+
+TEST_CASE("Compress gzip file in parallel and decompress it") {
+    osmium::thread::Pool pool{2};
+    const std::string data = test_data(5 * 1024 * 1024 + 123);
+
+    write_gzip("test-gzip-parallel.gz", data, &pool);
+    REQUIRE(read_gzip_with_zlib("test-gzip-parallel.gz") == data);
+    REQUIRE(read_gzip("test-gzip-parallel.gz") == data);
+}
+
+TEST_CASE("Compress empty gzip file in parallel") {
+    osmium::thread::Pool pool{2};
+
+    write_gzip("test-gzip-parallel-empty.gz", "", &pool);
+    REQUIRE(read_gzip_with_zlib("test-gzip-parallel-empty.gz").empty());
+    REQUIRE(read_gzip("test-gzip-parallel-empty.gz").empty());
+}
+
+TEST_CASE("Decompress gzip file with members with and without size") {
+    osmium::thread::Pool pool{2};
+    const std::string data1 = test_data(3 * 1024 * 1024);
+    const std::string data2 = test_data(2 * 1024 * 1024 + 17);
+
+    write_gzip("test-gzip-mixed.gz", data1, &pool);
+    write_gzip("test-gzip-mixed.gz", data2, nullptr, true);
+    write_gzip("test-gzip-mixed.gz", data1, &pool, true);
+    REQUIRE(read_gzip("test-gzip-mixed.gz") == data1 + data2 + data1);
+}
+
+TEST_CASE("Decompress normal gzip file") {
+    const std::string data = test_data(3 * 1024 * 1024);
+
+    write_gzip("test-gzip-normal.gz", data, nullptr);
+    REQUIRE(read_gzip("test-gzip-normal.gz") == data);
+}
+
+TEST_CASE("Decompress corrupted gzip file compressed in parallel") {
+    osmium::thread::Pool pool{2};
+    const std::string data = test_data(3 * 1024 * 1024);
+
+    write_gzip("test-gzip-corrupt.gz", data, &pool);
+    const int fd = ::open("test-gzip-corrupt.gz", O_RDWR);
+    REQUIRE(fd >= 0);
+    REQUIRE(::lseek(fd, 100, SEEK_SET) == 100);
+    osmium::io::detail::reliable_write(fd, "xxxxxxxx", 8);
+    osmium::io::detail::reliable_close(fd);
+
+    REQUIRE_THROWS_AS(read_gzip("test-gzip-corrupt.gz"), const osmium::gzip_error&);
+}
+
+TEST_CASE("Write and read gzip compressed OSM file with parallel_compression") {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= 50000; ++i) {
+        osmium::builder::add_node(buffer, osmium::builder::attr::_id(i));
+    }
+
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-gzip-writer.osm.gz", "osm.gz,parallel_compression=true"}, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    osmium::io::Reader reader{"test-gzip-writer.osm.gz"};
+    osmium::object_id_type id = 0;
+    while (const osmium::memory::Buffer read_buffer = reader.read()) {
+        for (const auto& node : read_buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == ++id);
+        }
+    }
+    reader.close();
+    REQUIRE(id == 50000);
+}
+
+TEST_CASE("Reader decompresses gzip file in its own thread pool") {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 1; i <= 50000; ++i) {
+        osmium::builder::add_node(buffer, osmium::builder::attr::_id(i));
+    }
+
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-gzip-reader-pool.osm.gz", "osm.gz,parallel_compression=true"}, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    // Block the only worker of the pool, so the decompression tasks of
+    // the Reader stay in its queue if they are submitted to this pool.
+    osmium::thread::Pool pool{1};
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::promise<void> started;
+    auto blocker = pool.submit([&started, released] {
+        started.set_value();
+        released.wait();
+    });
+    started.get_future().wait();
+
+    osmium::io::Reader reader{"test-gzip-reader-pool.osm.gz", pool};
+    for (int i = 0; i < 1000 && pool.queue_empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    const bool tasks_in_pool = !pool.queue_empty();
+    release.set_value();
+    blocker.get();
+    REQUIRE(tasks_in_pool);
+
+    osmium::object_id_type id = 0;
+    while (const osmium::memory::Buffer read_buffer = reader.read()) {
+        for (const auto& node : read_buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == ++id);
+        }
+    }
+    reader.close();
+    REQUIRE(id == 50000);
+}
@@ -0,0 +1,156 @@
+#include "catch.hpp"
+#include "utils.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/o5m_input.hpp>
+#include <osmium/io/o5m_output.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+
+static std::vector<osmium::memory::Buffer> create_test_buffers(bool with_deleted) {
+    using namespace osmium::builder::attr;
+
+    std::vector<osmium::memory::Buffer> buffers;
+
+    buffers.emplace_back(1024, osmium::memory::Buffer::auto_grow::yes);
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        // o5m can't store a user name for anonymous users (uid 0)
+        const auto uid = id % 3 == 0 ? 0 : id % 11;
+        // more different tags than fit into the string table
+        osmium::builder::add_node(buffers.back(),
+            _id(id),
+            _version(id % 5 + 1),
+            _cid(1000 + id / 7),
+            _timestamp(osmium::Timestamp{uint32_t(1400000000 + id * 13)}),
+            _uid(uid),
+            _user(uid == 0 ? "" : "user" + std::to_string(uid)),
+            _location(id * 0.001, -1.0 + id * 0.0001),
+            _tag("n", std::to_string(id % 100)),
+            _tag("name", "node " + std::to_string(id / 2)));
+    }
+    osmium::builder::add_node(buffers.back(), _id(-5), _version(1), _location(-179.9, -89.9), _tag("long", std::string(300, 'x')));
+    osmium::builder::add_node(buffers.back(), _id(-5), _version(1), _location(-179.9, -89.9), _tag("long", std::string(300, 'x')));
+    osmium::builder::add_node(buffers.back(), _id(20001), _version(1), _location(1.0, 2.0), _tag("n", "1"), _tag("n", "1"));
+    if (with_deleted) {
+        osmium::builder::add_node(buffers.back(), _id(20002), _version(2), _timestamp(osmium::Timestamp{uint32_t(1500000000)}), _uid(7), _user("u"), _deleted());
+    }
+
+    buffers.emplace_back(1024, osmium::memory::Buffer::auto_grow::yes);
+    osmium::builder::add_way(buffers.back(), _id(20), _version(1), _timestamp(osmium::Timestamp{uint32_t(1500000000)}), _cid(5), _uid(7), _user("u"),
+                             _nodes({1, 2, 3}), _tag("highway", "primary"));
+    osmium::builder::add_way(buffers.back(), _id(21), _version(1), _nodes({3, 4, 1000000000000}));
+    osmium::builder::add_way(buffers.back(), _id(22), _version(3), _tag("empty", ""));
+    if (with_deleted) {
+        osmium::builder::add_way(buffers.back(), _id(23), _version(2), _deleted());
+    }
+    osmium::builder::add_relation(buffers.back(), _id(30), _version(1),
+                                  _member(osmium::item_type::way, 20, "outer"),
+                                  _member(osmium::item_type::way, 21, "outer"),
+                                  _member(osmium::item_type::node, 1, ""),
+                                  _member(osmium::item_type::relation, 31, "sub"),
+                                  _tag("type", "multipolygon"));
+    osmium::builder::add_relation(buffers.back(), _id(31), _version(1), _member(osmium::item_type::node, 5, "outer"));
+    if (with_deleted) {
+        osmium::builder::add_relation(buffers.back(), _id(32), _version(4), _deleted());
+    }
+
+    return buffers;
+}
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream file{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+static std::string write_opl(std::vector<osmium::memory::Buffer>&& buffers, const std::string& filename) {
+    osmium::io::Writer writer{osmium::io::File{filename, "opl"}, osmium::io::overwrite::allow};
+    for (auto& buffer : buffers) {
+        writer(std::move(buffer));
+    }
+    writer.close();
+    return read_file(filename);
+}
+
+static void check_round_trip(const char* suffix, const char* format, bool with_deleted) {
+    const std::string filename = std::string{"test-o5m-output."} + suffix;
+    {
+        osmium::io::Header header;
+        osmium::io::Writer writer{osmium::io::File{filename, format}, header, osmium::io::overwrite::allow};
+        for (auto& buffer : create_test_buffers(with_deleted)) {
+            writer(std::move(buffer));
+        }
+        writer.close();
+    }
+
+    std::vector<osmium::memory::Buffer> buffers;
+    osmium::io::Reader reader{filename};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        buffers.push_back(std::move(buffer));
+    }
+    reader.close();
+
+    const auto expected = write_opl(create_test_buffers(with_deleted), "test-o5m-output-expected.opl");
+    REQUIRE_FALSE(expected.empty());
+    REQUIRE(write_opl(std::move(buffers), "test-o5m-output-result.opl") == expected);
+}
+
+TEST_CASE("Write o5m file and read it back") {
+    check_round_trip("o5m", "o5m", false);
+}
+
+TEST_CASE("Write o5c file with deleted objects and read it back") {
+    check_round_trip("o5c", "o5c", true);
+}
+
+TEST_CASE("Write o5m file without metadata") {
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-o5m-output-nometa.o5m", "o5m,add_metadata=false"}, osmium::io::overwrite::allow};
+        for (auto& buffer : create_test_buffers(false)) {
+            writer(std::move(buffer));
+        }
+        writer.close();
+    }
+
+    osmium::io::Reader reader{"test-o5m-output-nometa.o5m"};
+    std::size_t count = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            REQUIRE(object.version() == 0);
+            REQUIRE(object.timestamp() == osmium::Timestamp{});
+            REQUIRE(object.uid() == 0);
+            ++count;
+        }
+    }
+    reader.close();
+    REQUIRE(count == 20003 + 3 + 2);
+}
+
+TEST_CASE("Write o5m header") {
+    osmium::io::Header header;
+    header.add_box(osmium::Box{-1.5, -2.5, 3.5, 4.5});
+    header.set("timestamp", "2017-02-03T04:05:06Z");
+    {
+        osmium::io::Writer writer{osmium::io::File{"test-o5m-output-header.o5m", "o5m"}, header, osmium::io::overwrite::allow};
+        writer.close();
+    }
+
+    const auto data = read_file("test-o5m-output-header.o5m");
+    const std::string magic("\xff\xe0\x04o5m2", 7);
+    REQUIRE(data.substr(0, 7) == magic);
+    REQUIRE(data.back() == '\xfe');
+
+    osmium::io::Reader reader{"test-o5m-output-header.o5m"};
+    const auto read_header = reader.header();
+    REQUIRE(read_header.get("timestamp") == "2017-02-03T04:05:06Z");
+    REQUIRE(read_header.box() == osmium::Box(-1.5, -2.5, 3.5, 4.5));
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
+
@@ -0,0 +1,144 @@
+
+#include "catch.hpp"
+#include "utils.hpp"
+
+#include <string>
+#include <vector>
+
+#include <osmium/io/detail/o5m.hpp>
+#include <osmium/io/o5m_input.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+namespace oid = osmium::io::detail;
+
+// Create o5m data with the given number of nodes and one way at the end.
+// A reset is written before every reset_every nodes (none if 0).
+static std::string create_o5m(int num_nodes, int reset_every) {
+    std::string data{"\xff\xe0\x04o5m2", 7};
+
+    std::string bbox;
+    oid::o5m_append_zvarint(bbox, 20000000);
+    oid::o5m_append_zvarint(bbox, 10000000);
+    oid::o5m_append_zvarint(bbox, 40000000);
+    oid::o5m_append_zvarint(bbox, 30000000);
+    oid::o5m_append_dataset(data, oid::o5m_dataset::bounding_box, bbox);
+
+    int64_t last_id = 0;
+    int64_t last_lon = 0;
+    for (int id = 1; id <= num_nodes; ++id) {
+        if (reset_every > 0 && (id - 1) % reset_every == 0) {
+            data += static_cast<char>(oid::o5m_dataset::reset);
+            last_id = 0;
+            last_lon = 0;
+        }
+        std::string node;
+        oid::o5m_append_zvarint(node, id - last_id);
+        node += '\0'; // no info section
+        oid::o5m_append_zvarint(node, id - last_lon);
+        oid::o5m_append_zvarint(node, 0);
+        if (id % 100 == 0) {
+            // inline string, added to the reference table
+            node += '\0';
+            node += "n";
+            node += '\0';
+            node += std::to_string(id);
+            node += '\0';
+        }
+        oid::o5m_append_dataset(data, oid::o5m_dataset::node, node);
+        last_id = id;
+        last_lon = id;
+    }
+
+    data += static_cast<char>(oid::o5m_dataset::reset);
+    std::string way;
+    oid::o5m_append_zvarint(way, 7);
+    way += '\0';
+    std::string refs;
+    oid::o5m_append_zvarint(refs, 1);
+    oid::o5m_append_zvarint(refs, 1);
+    oid::o5m_append_varint(way, refs.size());
+    way += refs;
+    oid::o5m_append_dataset(data, oid::o5m_dataset::way, way);
+
+    data += static_cast<char>(oid::o5m_dataset::end_of_file);
+    return data;
+}
+
+static std::vector<osmium::object_id_type> read_ids(const std::string& data, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::all) {
+    std::vector<osmium::object_id_type> ids;
+    osmium::io::File file{data.data(), data.size(), "o5m"};
+    osmium::io::Reader reader{file, entities};
+    REQUIRE(reader.header().box() == osmium::Box(2, 1, 4, 3));
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            if (object.type() == osmium::item_type::node) {
+                const auto& node = static_cast<const osmium::Node&>(object);
+                REQUIRE(node.location().x() == node.id());
+                if (node.id() % 100 == 0) {
+                    REQUIRE(std::to_string(node.id()) == node.tags()["n"]);
+                } else {
+                    REQUIRE(node.tags().empty());
+                }
+                ids.push_back(node.id());
+            } else {
+                const auto& way = static_cast<const osmium::Way&>(object);
+                REQUIRE(way.nodes().size() == 2);
+                REQUIRE(way.nodes()[1].ref() == 2);
+                ids.push_back(-way.id());
+            }
+        }
+    }
+    reader.close();
+    return ids;
+}
+
+static void check_ids(const std::vector<osmium::object_id_type>& ids, int num_nodes) {
+    REQUIRE(ids.size() == static_cast<std::size_t>(num_nodes + 1));
+    for (int i = 0; i < num_nodes; ++i) {
+        REQUIRE(ids[i] == i + 1);
+    }
+    REQUIRE(ids.back() == -7);
+}
+
+TEST_CASE("Read o5m file with many resets") {
+    const auto data = create_o5m(500000, 1000);
+    REQUIRE(data.size() > 2 * 1024 * 1024);
+    check_ids(read_ids(data), 500000);
+}
+
+TEST_CASE("Read o5m file with few resets") {
+    const auto data = create_o5m(700000, 0);
+    REQUIRE(data.size() > 4 * 1024 * 1024);
+    check_ids(read_ids(data), 700000);
+}
+
+TEST_CASE("Read only ways from o5m file") {
+    const auto data = create_o5m(100000, 1000);
+    const auto ids = read_ids(data, osmium::osm_entity_bits::way);
+    REQUIRE(ids.size() == 1);
+    REQUIRE(ids.front() == -7);
+}
+
+TEST_CASE("Read only header from o5m file") {
+    const auto data = create_o5m(1000, 10);
+    osmium::io::File file{data.data(), data.size(), "o5m"};
+    osmium::io::Reader reader{file, osmium::osm_entity_bits::nothing};
+    REQUIRE(reader.header().box() == osmium::Box(2, 1, 4, 3));
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
+
+TEST_CASE("Truncated o5m file") {
+    auto data = create_o5m(1000, 10);
+    data.resize(data.size() - 4);
+    osmium::io::File file{data.data(), data.size(), "o5m"};
+    osmium::io::Reader reader{file};
+    REQUIRE_THROWS_AS([&]() {
+        while (reader.read()) {
+        }
+    }(), const osmium::o5m_error&);
+}
+
@@ -1,12 +1,16 @@
 
 #include <algorithm>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "catch.hpp"
 #include "utils.hpp"
 
 #include <osmium/io/detail/opl_input_format.hpp>
+#include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/opl_input.hpp>
+#include <osmium/io/reader.hpp>
 #include <osmium/opl.hpp>
 
 namespace oid = osmium::io::detail;
@@ -1227,3 +1231,111 @@ TEST_CASE("line_by_line for OPL parser 28") {
     check_lbl({"foo\nb", "ar"}, {"foo", "bar"});
 }
 
+
+class cbl_tester {
+
+    std::vector<std::string> m_inputs;
+    std::vector<std::string> m_outputs;
+
+public:
+
+    cbl_tester(const std::initializer_list<std::string>& inputs, const std::initializer_list<std::string>& outputs) :
+        m_inputs(inputs),
+        m_outputs(outputs) {
+    }
+
+    bool input_done() {
+        return m_inputs.empty();
+    }
+
+    std::string get_input() {
+        REQUIRE_FALSE(m_inputs.empty());
+        std::string data = std::move(m_inputs.front());
+        m_inputs.erase(m_inputs.begin());
+        return data;
+    }
+
+    void parse_chunk(std::string&& data) {
+        REQUIRE_FALSE(m_outputs.empty());
+        REQUIRE(m_outputs.front() == data);
+        m_outputs.erase(m_outputs.begin());
+    }
+
+    void check() {
+        REQUIRE(m_inputs.empty());
+        REQUIRE(m_outputs.empty());
+    }
+
+}; // class cbl_tester
+
+void check_cbl(const std::initializer_list<std::string>& in,
+               const std::initializer_list<std::string>& out) {
+    cbl_tester tester{in, out};
+    osmium::io::detail::chunk_by_lines(tester, 5);
+    tester.check();
+}
+
+TEST_CASE("chunk_by_lines for OPL parser") {
+    check_cbl({""}, {});
+    check_cbl({"foo\n"}, {"foo\n"});
+    check_cbl({"foo"}, {"foo"});
+    check_cbl({"foo\nbar\n"}, {"foo\nbar\n"});
+    check_cbl({"foo\nbar"}, {"foo\n", "bar"});
+    check_cbl({"foo", "bar\n", "baz"}, {"foobar\n", "baz"});
+    check_cbl({"foobar", "baz\n"}, {"foobarbaz\n"});
+    check_cbl({"foo\nbar", "baz\r\nx"}, {"foo\n", "barbaz\r\n", "x"});
+}
+
+TEST_CASE("count lines for OPL parser") {
+    REQUIRE(oid::count_opl_lines("") == 0);
+    REQUIRE(oid::count_opl_lines("\n") == 0);
+    REQUIRE(oid::count_opl_lines("foo") == 1);
+    REQUIRE(oid::count_opl_lines("foo\nbar\n") == 2);
+    REQUIRE(oid::count_opl_lines("foo\r\nbar\r\n\n\nbaz") == 3);
+}
+
+static std::string write_large_opl_file(int num_nodes, int error_line = -1) {
+    const std::string filename{"test-opl-parser-large.opl"};
+    std::string data;
+    for (int i = 1; i <= num_nodes; ++i) {
+        if (i - 1 == error_line) {
+            data += "x\n";
+        } else {
+            data += "n" + std::to_string(i) + " v1 dV c1 t2017-01-01T00:00:00Z i1 utest Tname=test x1.5 y2.5\n";
+        }
+    }
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+    return filename;
+}
+
+TEST_CASE("Parse large OPL file in chunks") {
+    const std::string filename = write_large_opl_file(50000);
+
+    osmium::io::Reader reader{filename};
+    osmium::object_id_type last_id = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == last_id + 1);
+            REQUIRE(node.location() == osmium::Location(1.5, 2.5));
+            last_id = node.id();
+        }
+    }
+    reader.close();
+
+    REQUIRE(last_id == 50000);
+}
+
+TEST_CASE("Errors in large OPL file report the right line") {
+    const std::string filename = write_large_opl_file(50000, 45000);
+
+    osmium::io::Reader reader{filename};
+    try {
+        while (reader.read()) {
+        }
+        REQUIRE(false);
+    } catch (const osmium::opl_error& e) {
+        REQUIRE(e.line == 45000);
+    }
+}
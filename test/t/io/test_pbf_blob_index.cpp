@@ -0,0 +1,242 @@
+#include "catch.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include <unistd.h>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/visitor.hpp>
+
+struct CountHandler : public osmium::handler::Handler {
+
+    int nodes = 0;
+    int ways = 0;
+    int relations = 0;
+
+    void node(const osmium::Node&) {
+        ++nodes;
+    }
+
+    void way(const osmium::Way&) {
+        ++ways;
+    }
+
+    void relation(const osmium::Relation&) {
+        ++relations;
+    }
+
+}; // struct CountHandler
+
+static std::string write_test_file() {
+    using namespace osmium::builder::attr;
+
+    const std::string filename{"test-pbf-blob-index.osm.pbf"};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 2.0));
+    osmium::builder::add_node(buffer, _id(2), _location(1.5, 2.5));
+    osmium::builder::add_way(buffer, _id(10), _nodes({1, 2}));
+    osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::way, 10, "outer"));
+
+    osmium::io::Header header;
+    osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    return filename;
+}
+
+TEST_CASE("Scan PBF file for blob index") {
+    const auto index = osmium::io::PBFBlobIndex::scan(with_data_dir("t/io/deleted_nodes.osh.pbf"));
+
+    REQUIRE_FALSE(index.empty());
+    REQUIRE(index.types() == osmium::osm_entity_bits::node);
+    REQUIRE(index.begin()->offset > 0);
+
+    const auto& last = index[index.size() - 1];
+    REQUIRE(last.offset + last.size == index.file_size());
+}
+
+TEST_CASE("Scanning a file that is not a PBF file fails") {
+    REQUIRE_THROWS_AS(osmium::io::PBFBlobIndex::scan(with_data_dir("t/io/data.osm")), const osmium::pbf_error&);
+}
+
+static CountHandler read_with_index(const std::string& filename, const char* format, osmium::osm_entity_bits::type types, const osmium::io::PBFBlobIndex& index) {
+    osmium::io::Reader reader{osmium::io::File{filename, format}, types, index};
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    reader.close();
+    return handler;
+}
+
+TEST_CASE("Read PBF file with blob index") {
+    const std::string filename = write_test_file();
+    const auto index = osmium::io::PBFBlobIndex::scan(filename);
+
+    REQUIRE(index.size() == 3);
+    REQUIRE(index[0].types == osmium::osm_entity_bits::node);
+    REQUIRE(index[1].types == osmium::osm_entity_bits::way);
+    REQUIRE(index[2].types == osmium::osm_entity_bits::relation);
+
+    std::string format;
+
+    SECTION("stream") {
+        format = "pbf";
+    }
+
+    SECTION("memory mapped") {
+        format = "pbf,pbf_mmap=true";
+    }
+
+    const auto all = read_with_index(filename, format.c_str(), osmium::osm_entity_bits::all, index);
+    REQUIRE(all.nodes == 2);
+    REQUIRE(all.ways == 1);
+    REQUIRE(all.relations == 1);
+
+    const auto ways = read_with_index(filename, format.c_str(), osmium::osm_entity_bits::way, index);
+    REQUIRE(ways.nodes == 0);
+    REQUIRE(ways.ways == 1);
+    REQUIRE(ways.relations == 0);
+
+    const auto parts = index.split(2);
+    REQUIRE(parts.size() == 2);
+
+    const auto first = read_with_index(filename, format.c_str(), osmium::osm_entity_bits::all, parts[0]);
+    const auto second = read_with_index(filename, format.c_str(), osmium::osm_entity_bits::all, parts[1]);
+    REQUIRE(first.nodes + second.nodes == 2);
+    REQUIRE(first.ways + second.ways == 1);
+    REQUIRE(first.relations + second.relations == 1);
+}
+
+TEST_CASE("Split blob index by entity types") {
+    const std::string filename = write_test_file();
+    const auto index = osmium::io::PBFBlobIndex::scan(filename);
+
+    const auto parts = index.split(4, osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation);
+    REQUIRE(parts.size() == 2);
+    REQUIRE(parts[0].types() == osmium::osm_entity_bits::way);
+    REQUIRE(parts[1].types() == osmium::osm_entity_bits::relation);
+
+    REQUIRE(index.split(0).empty());
+}
+
+TEST_CASE("Blob index can be written and read again") {
+    const std::string filename = write_test_file();
+    const auto index = osmium::io::PBFBlobIndex::scan(filename);
+
+    const std::string index_filename{"test-pbf-blob-index.idx"};
+    const int out = osmium::io::detail::open_for_writing(index_filename, osmium::io::overwrite::allow);
+    index.dump(out);
+    osmium::io::detail::reliable_close(out);
+
+    const int in = osmium::io::detail::open_for_reading(index_filename);
+    const auto loaded = osmium::io::PBFBlobIndex::load(in);
+    osmium::io::detail::reliable_close(in);
+
+    REQUIRE(loaded.file_size() == index.file_size());
+    REQUIRE(loaded.size() == index.size());
+    for (std::size_t i = 0; i < index.size(); ++i) {
+        REQUIRE(loaded[i].offset == index[i].offset);
+        REQUIRE(loaded[i].size == index[i].size);
+        REQUIRE(loaded[i].types == index[i].types);
+    }
+}
+
+TEST_CASE("Loading an invalid blob index fails") {
+    const int in = osmium::io::detail::open_for_reading(with_data_dir("t/io/data.osm"));
+    REQUIRE_THROWS_AS(osmium::io::PBFBlobIndex::load(in), const osmium::pbf_error&);
+    osmium::io::detail::reliable_close(in);
+}
+
+TEST_CASE("Reading with blob index for a different file fails") {
+    const std::string filename = write_test_file();
+    const auto index = osmium::io::PBFBlobIndex::scan(with_data_dir("t/io/deleted_nodes.osh.pbf"));
+
+    osmium::io::Reader reader{osmium::io::File{filename, "pbf,pbf_mmap=true"}, index};
+    REQUIRE_THROWS_AS(reader.read(), const osmium::pbf_error&);
+}
+
+TEST_CASE("Blob types marker in BlobHeader") {
+    const auto marker = osmium::io::detail::encode_blob_types_marker(osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation);
+    REQUIRE(marker == "osmium:wr");
+    REQUIRE(osmium::io::detail::decode_blob_types_marker(marker) == (osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation));
+
+    REQUIRE(osmium::io::detail::decode_blob_types_marker(std::string{"osmium:"}) == osmium::osm_entity_bits::nothing);
+    REQUIRE(osmium::io::detail::decode_blob_types_marker(std::string{"osmium:nx"}) == osmium::osm_entity_bits::nothing);
+    REQUIRE(osmium::io::detail::decode_blob_types_marker(std::string{"something else"}) == osmium::osm_entity_bits::nothing);
+}
+
+TEST_CASE("PBF files written by Osmium have blob types marker") {
+    const std::string filename = write_test_file();
+    const auto index = osmium::io::PBFBlobIndex::scan(filename);
+
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    std::string data(index.file_size(), '\0');
+    REQUIRE(::read(fd, &data[0], data.size()) == static_cast<ssize_t>(data.size()));
+    osmium::io::detail::reliable_close(fd);
+
+    const osmium::osm_entity_bits::type expected[] = {
+        osmium::osm_entity_bits::node,
+        osmium::osm_entity_bits::way,
+        osmium::osm_entity_bits::relation
+    };
+
+    REQUIRE(index.size() == 3);
+    for (std::size_t i = 0; i < index.size(); ++i) {
+        const char* blob = data.data() + index[i].offset;
+        const auto header_size = osmium::io::detail::decode_blob_header_size(blob);
+        const auto header = osmium::io::detail::decode_blob_header(protozero::data_view{blob + 4, header_size}, "OSMData");
+        REQUIRE(header.types == expected[i]);
+    }
+}
+
+TEST_CASE("Reader skips blobs with types not requested") {
+    const std::string filename = write_test_file();
+    const auto index = osmium::io::PBFBlobIndex::scan(filename);
+    REQUIRE(index.size() == 3);
+
+    int fd = osmium::io::detail::open_for_reading(filename);
+    std::string data(index.file_size(), '\0');
+    REQUIRE(::read(fd, &data[0], data.size()) == static_cast<ssize_t>(data.size()));
+    osmium::io::detail::reliable_close(fd);
+
+    // Overwrite the data of the node and way blobs (but not their
+    // BlobHeaders) with garbage. The decoder fails if it ever sees it.
+    for (std::size_t i = 0; i < 2; ++i) {
+        const auto offset = static_cast<std::size_t>(index[i].offset);
+        const auto header_size = osmium::io::detail::decode_blob_header_size(data.data() + offset);
+        const std::size_t begin = offset + 4 + header_size;
+        std::fill(data.begin() + begin, data.begin() + offset + index[i].size, 'x');
+    }
+
+    const std::string corrupted_filename{"test-pbf-blob-index-corrupted.osm.pbf"};
+    fd = osmium::io::detail::open_for_writing(corrupted_filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+
+    SECTION("reading all types decodes the corrupted blobs") {
+        osmium::io::Reader reader{corrupted_filename};
+        CountHandler handler;
+        REQUIRE_THROWS_AS(osmium::apply(reader, handler), const osmium::pbf_error&);
+    }
+
+    SECTION("reading relations only never decodes them") {
+        osmium::io::Reader reader{corrupted_filename, osmium::osm_entity_bits::relation};
+        CountHandler handler;
+        osmium::apply(reader, handler);
+        reader.close();
+
+        REQUIRE(handler.nodes == 0);
+        REQUIRE(handler.ways == 0);
+        REQUIRE(handler.relations == 1);
+    }
+}
@@ -0,0 +1,189 @@
+#include "catch.hpp"
+#include "utils.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+
+static osmium::memory::Buffer create_test_buffer() {
+    using namespace osmium::builder::attr;
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    // more nodes than fit into one block
+    for (osmium::object_id_type id = 1; id <= 10000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(id * 0.001, 1.0), _tag("n", std::to_string(id % 100)));
+    }
+    osmium::builder::add_way(buffer, _id(20), _version(1), _nodes({1, 2, 3}), _tag("highway", "primary"));
+    osmium::builder::add_way(buffer, _id(21), _version(1), _nodes({3, 4}));
+    osmium::builder::add_relation(buffer, _id(30), _version(1), _member(osmium::item_type::way, 20, "outer"));
+    osmium::builder::add_node(buffer, _id(10001), _version(1), _location(2.0, 3.0));
+
+    return buffer;
+}
+
+static std::string write_file(const std::string& filename, const char* format) {
+    osmium::io::Header header;
+    osmium::io::Writer writer{osmium::io::File{filename, format}, header, osmium::io::overwrite::allow};
+    writer(create_test_buffer());
+    writer.close();
+
+    std::ifstream file{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Write PBF with parallel encoding gives same result as sequential encoding") {
+    std::string format_sequential;
+    std::string format_parallel;
+
+    SECTION("compressed") {
+        format_sequential = "pbf";
+        format_parallel = "pbf,pbf_parallel_encoding=true";
+    }
+
+    SECTION("uncompressed without dense nodes") {
+        format_sequential = "pbf,pbf_compression=none,pbf_dense_nodes=false";
+        format_parallel = "pbf,pbf_compression=none,pbf_dense_nodes=false,pbf_parallel_encoding=true";
+    }
+
+    const auto sequential = write_file("test-pbf-output-sequential.osm.pbf", format_sequential.c_str());
+    const auto parallel = write_file("test-pbf-output-parallel.osm.pbf", format_parallel.c_str());
+
+    REQUIRE_FALSE(sequential.empty());
+    REQUIRE(sequential == parallel);
+}
+
+TEST_CASE("Read PBF written with parallel encoding") {
+    write_file("test-pbf-output-parallel.osm.pbf", "pbf,pbf_parallel_encoding=true");
+
+    const auto expected = create_test_buffer();
+
+    osmium::io::Reader reader{"test-pbf-output-parallel.osm.pbf"};
+    auto it = expected.select<osmium::OSMObject>().cbegin();
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            REQUIRE(it != expected.select<osmium::OSMObject>().cend());
+            REQUIRE(object.type() == it->type());
+            REQUIRE(object.id() == it->id());
+            REQUIRE(object.tags().size() == it->tags().size());
+            ++it;
+        }
+    }
+    reader.close();
+
+    REQUIRE(it == expected.select<osmium::OSMObject>().cend());
+}
+
+static void check_read_back(const std::string& filename) {
+    osmium::io::Reader reader{filename};
+    std::size_t count = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        count += static_cast<std::size_t>(std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend()));
+    }
+    reader.close();
+    REQUIRE(count == 10004);
+}
+
+TEST_CASE("Write PBF with different compression settings") {
+    std::string format;
+
+    SECTION("zlib default level") {
+        format = "pbf,pbf_compression=zlib";
+    }
+
+    SECTION("zlib fastest") {
+        format = "pbf,pbf_compression=zlib,pbf_compression_level=1";
+    }
+
+    SECTION("zlib best") {
+        format = "pbf,pbf_compression_level=9";
+    }
+
+    SECTION("none") {
+        format = "pbf,pbf_compression=none";
+    }
+
+#ifdef OSMIUM_WITH_LZ4
+    SECTION("lz4") {
+        format = "pbf,pbf_compression=lz4";
+    }
+
+    SECTION("lz4 high compression") {
+        format = "pbf,pbf_compression=lz4,pbf_compression_level=9";
+    }
+#endif
+
+#ifdef OSMIUM_WITH_ZSTD
+    SECTION("zstd") {
+        format = "pbf,pbf_compression=zstd";
+    }
+
+    SECTION("zstd with level") {
+        format = "pbf,pbf_compression=zstd,pbf_compression_level=19";
+    }
+#endif
+
+    write_file("test-pbf-output-compression.osm.pbf", format.c_str());
+    check_read_back("test-pbf-output-compression.osm.pbf");
+}
+
+TEST_CASE("PBF compression levels are checked for each compression") {
+    namespace oid = osmium::io::detail;
+
+    REQUIRE(oid::get_pbf_compression_level("", oid::pbf_compression::zlib) == oid::pbf_default_compression_level);
+    REQUIRE(oid::get_pbf_compression_level("0", oid::pbf_compression::zlib) == 0);
+    REQUIRE(oid::get_pbf_compression_level("9", oid::pbf_compression::zlib) == 9);
+    REQUIRE_THROWS_AS(oid::get_pbf_compression_level("10", oid::pbf_compression::zlib), const osmium::io_error&);
+
+    REQUIRE_THROWS_AS(oid::get_pbf_compression_level("0", oid::pbf_compression::lz4), const osmium::io_error&);
+    REQUIRE(oid::get_pbf_compression_level("1", oid::pbf_compression::lz4) == 1);
+    REQUIRE(oid::get_pbf_compression_level("12", oid::pbf_compression::lz4) == 12);
+    REQUIRE_THROWS_AS(oid::get_pbf_compression_level("13", oid::pbf_compression::lz4), const osmium::io_error&);
+
+    REQUIRE_THROWS_AS(oid::get_pbf_compression_level("0", oid::pbf_compression::zstd), const osmium::io_error&);
+    REQUIRE(oid::get_pbf_compression_level("1", oid::pbf_compression::zstd) == 1);
+    REQUIRE(oid::get_pbf_compression_level("22", oid::pbf_compression::zstd) == 22);
+    REQUIRE_THROWS_AS(oid::get_pbf_compression_level("23", oid::pbf_compression::zstd), const osmium::io_error&);
+    REQUIRE_THROWS_AS(oid::get_pbf_compression_level("99", oid::pbf_compression::zstd), const osmium::io_error&);
+}
+
+TEST_CASE("Writing PBF with invalid compression settings fails") {
+    osmium::io::Header header;
+
+    SECTION("unknown compression") {
+        REQUIRE_THROWS_AS((osmium::io::Writer{osmium::io::File{"test-pbf-output-invalid.osm.pbf", "pbf,pbf_compression=foo"}, header, osmium::io::overwrite::allow}), const osmium::io_error&);
+    }
+
+    SECTION("invalid level") {
+        REQUIRE_THROWS_AS((osmium::io::Writer{osmium::io::File{"test-pbf-output-invalid.osm.pbf", "pbf,pbf_compression_level=x"}, header, osmium::io::overwrite::allow}), const osmium::io_error&);
+    }
+
+    SECTION("level out of range for zlib") {
+        REQUIRE_THROWS_AS((osmium::io::Writer{osmium::io::File{"test-pbf-output-invalid.osm.pbf", "pbf,pbf_compression_level=10"}, header, osmium::io::overwrite::allow}), const osmium::io_error&);
+    }
+
+#ifdef OSMIUM_WITH_LZ4
+    SECTION("level out of range for lz4") {
+        REQUIRE_THROWS_AS((osmium::io::Writer{osmium::io::File{"test-pbf-output-invalid.osm.pbf", "pbf,pbf_compression=lz4,pbf_compression_level=13"}, header, osmium::io::overwrite::allow}), const osmium::io_error&);
+    }
+#endif
+
+#ifdef OSMIUM_WITH_ZSTD
+    SECTION("level out of range for zstd") {
+        REQUIRE_THROWS_AS((osmium::io::Writer{osmium::io::File{"test-pbf-output-invalid.osm.pbf", "pbf,pbf_compression=zstd,pbf_compression_level=23"}, header, osmium::io::overwrite::allow}), const osmium::io_error&);
+    }
+#endif
+
+#ifndef OSMIUM_WITH_ZSTD
+    SECTION("zstd not compiled in") {
+        REQUIRE_THROWS_AS((osmium::io::Writer{osmium::io::File{"test-pbf-output-invalid.osm.pbf", "pbf,pbf_compression=zstd"}, header, osmium::io::overwrite::allow}), const osmium::io_error&);
+    }
+#endif
+}
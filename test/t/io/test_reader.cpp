@@ -177,6 +177,30 @@ TEST_CASE("Reader should decode zero node positions in history (PBF)") {
     REQUIRE(handler.total_count == 2);
 }
 
+TEST_CASE("Reader should decode zero node positions in history (memory mapped PBF)") {
+    osmium::io::File file{with_data_dir("t/io/deleted_nodes.osh.pbf"), "pbf,pbf_mmap=true"};
+    osmium::io::Reader reader{file, osmium::osm_entity_bits::node};
+    ZeroPositionNodeCountHandler handler;
+
+    REQUIRE(reader.file_size() > 0);
+    REQUIRE(reader.header().has_multiple_object_versions());
+
+    osmium::apply(reader, handler);
+
+    REQUIRE(handler.count == 0);
+    REQUIRE(handler.total_count == 2);
+    REQUIRE(reader.offset() == reader.file_size());
+}
+
+TEST_CASE("Reader can be closed early on memory mapped PBF") {
+    osmium::io::File file{with_data_dir("t/io/deleted_nodes.osh.pbf"), "pbf,pbf_mmap=true"};
+    osmium::io::Reader reader{file};
+
+    reader.close();
+    REQUIRE(reader.eof());
+    REQUIRE_THROWS_AS(reader.read(), const osmium::io_error&);
+}
+
 TEST_CASE("Reader should fail with nonexistent file") {
     REQUIRE_THROWS(osmium::io::Reader{with_data_dir("t/io/nonexistent-file.osm")});
 }
@@ -0,0 +1,42 @@
+#include "catch.hpp"
+
+#include <osmium/io/detail/string_scan.hpp>
+
+#include <string>
+
+namespace oid = osmium::io::detail;
+
+TEST_CASE("Find first of characters or end of string") {
+    // Test with all positions of the character relative to the block
+    // boundaries used by the vectorized code.
+    for (std::size_t start = 0; start < 40; ++start) {
+        for (std::size_t pos = start; pos < 100; ++pos) {
+            std::string str(100, 'a');
+            str[pos] = '=';
+            const char* s = str.c_str() + start;
+            REQUIRE((oid::find_first_of_or_end<' ', '='>(s) == str.c_str() + pos));
+            REQUIRE((oid::find_first_of_or_end_scalar<' ', '='>(s) == str.c_str() + pos));
+            REQUIRE((oid::find_first_of_or_end<' ', ','>(s) == str.c_str() + str.size()));
+        }
+    }
+}
+
+TEST_CASE("Find first of characters in range") {
+    for (std::size_t start = 0; start < 40; ++start) {
+        for (std::size_t pos = start; pos < 100; ++pos) {
+            std::string str(100, 'a');
+            str[pos] = '\r';
+            const char* begin = str.data() + start;
+            const char* end = str.data() + str.size();
+            REQUIRE((oid::find_first_of_in_range<'\n', '\r'>(begin, end) == str.data() + pos));
+            REQUIRE((oid::find_first_of_in_range_scalar<'\n', '\r'>(begin, end) == str.data() + pos));
+            REQUIRE((oid::find_first_of_in_range<'\n', '\r'>(begin, str.data() + pos) == str.data() + pos));
+        }
+    }
+}
+
+TEST_CASE("Find first of characters in range does not find the null character") {
+    const std::string str{"abc\0def\nghi", 11};
+    REQUIRE((oid::find_first_of_in_range<'\n'>(str.data(), str.data() + str.size()) == str.data() + 7));
+    REQUIRE((oid::find_first_of_or_end<'\n'>(str.data()) == str.data() + 3));
+}
@@ -0,0 +1,185 @@
+
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "utils.hpp"
+
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+namespace oid = osmium::io::detail;
+
+static oid::xml_split_point split(const std::string& data, std::size_t pos = 0, bool last = true) {
+    return oid::find_xml_split_point(data, pos, last);
+}
+
+TEST_CASE("Find split points in XML data") {
+    REQUIRE(split("").type == oid::xml_split_type::none);
+    REQUIRE(split("<osm version=\"0.6\">").type == oid::xml_split_type::none);
+
+    const std::string data{"<osm>\n <node id=\"1\"/>\n <way id=\"1\">\n  <nd ref=\"1\"/>\n </way>\n</osm>\n"};
+    auto sp = split(data);
+    REQUIRE(sp.type == oid::xml_split_type::object);
+    REQUIRE(sp.pos == 7);
+    sp = split(data, sp.pos + 1);
+    REQUIRE(sp.type == oid::xml_split_type::object);
+    REQUIRE(sp.pos == 23);
+    sp = split(data, sp.pos + 1);
+    REQUIRE(sp.type == oid::xml_split_type::root_end);
+    REQUIRE(data.substr(sp.pos) == "</osm>\n");
+}
+
+TEST_CASE("Split points are only found at complete element names") {
+    REQUIRE(split("<nodes><wayx><relations/>").type == oid::xml_split_type::none);
+    REQUIRE(split("<osmChange></osmChange>").type == oid::xml_split_type::none);
+    REQUIRE(split("<changeset\n id=\"1\">").type == oid::xml_split_type::object);
+    REQUIRE(split("<relation>").type == oid::xml_split_type::object);
+}
+
+TEST_CASE("Split points are not found in comments, CDATA, and processing instructions") {
+    REQUIRE(split("<!-- <node id=\"1\"/> -->").type == oid::xml_split_type::none);
+    REQUIRE(split("<![CDATA[<node id=\"1\"/>]]>").type == oid::xml_split_type::none);
+    REQUIRE(split("<?foo <node id=\"1\"/> ?>").type == oid::xml_split_type::none);
+
+    const auto sp = split("<!-- x --><node/>");
+    REQUIRE(sp.type == oid::xml_split_type::object);
+    REQUIRE(sp.pos == 10);
+}
+
+TEST_CASE("Finding split points needs more data if the data ends too early") {
+    auto sp = split("<osm version=\"0.6\"><no", 0, false);
+    REQUIRE(sp.type == oid::xml_split_type::need_more);
+    REQUIRE(sp.pos == 19);
+
+    sp = split("<osm version=\"0.6\">  ", 0, false);
+    REQUIRE(sp.type == oid::xml_split_type::need_more);
+    REQUIRE(sp.pos == 21);
+
+    sp = split("<!-- <node id=\"1\"/>  ", 0, false);
+    REQUIRE(sp.type == oid::xml_split_type::need_more);
+    REQUIRE(sp.pos == 0);
+
+    REQUIRE(split("<osm><no").type == oid::xml_split_type::none);
+    REQUIRE(split("<osm><node").type == oid::xml_split_type::none);
+    REQUIRE(split("</osm>").type == oid::xml_split_type::root_end);
+}
+
+TEST_CASE("Check XML header for parallel parsing") {
+    REQUIRE(oid::is_plain_osm_xml_header("<osm version=\"0.6\">"));
+    REQUIRE(oid::is_plain_osm_xml_header("<?xml version='1.0' encoding='UTF-8'?>\n<osm version=\"0.6\">\n  <bounds/>\n"));
+    REQUIRE(oid::is_plain_osm_xml_header("<?xml version=\"1.0\" encoding=\"utf-8\"?><osm>"));
+
+    REQUIRE_FALSE(oid::is_plain_osm_xml_header(""));
+    REQUIRE_FALSE(oid::is_plain_osm_xml_header("<osmChange version=\"0.6\">"));
+    REQUIRE_FALSE(oid::is_plain_osm_xml_header("<?xml version='1.0' encoding='ISO-8859-1'?>\n<osm>"));
+    REQUIRE_FALSE(oid::is_plain_osm_xml_header("<?xml version='1.0' encoding='utf-16'?>\n<osm>"));
+    REQUIRE_FALSE(oid::is_plain_osm_xml_header("<!DOCTYPE osm [<!ENTITY x \"y\">]>\n<osm>"));
+    REQUIRE_FALSE(oid::is_plain_osm_xml_header("<osm xmlns:x=\"http://example.com/\">"));
+}
+
+static std::string large_xml(int num_nodes, int error_node = -1) {
+    std::string data{"<?xml version='1.0' encoding='UTF-8'?>\n<osm version=\"0.6\" generator=\"test\">\n  <bounds minlat=\"1\" minlon=\"2\" maxlat=\"3\" maxlon=\"4\"/>\n"};
+    for (int i = 1; i <= num_nodes; ++i) {
+        if (i == error_node) {
+            data += "  <node id=\"x\"\n";
+        }
+        data += "  <node id=\"" + std::to_string(i) + "\" version=\"1\" timestamp=\"2017-01-01T00:00:00Z\" lat=\"2.5\" lon=\"1.5\">\n";
+        data += "    <tag k=\"name\" v=\"&lt;node&gt;\"/>\n";
+        data += "  </node>\n";
+    }
+    data += "  <!-- <node id=\"0\"/> -->\n";
+    data += "  <way id=\"1\" version=\"1\">\n    <nd ref=\"1\"/>\n    <nd ref=\"2\"/>\n  </way>\n";
+    data += "</osm>\n";
+    return data;
+}
+
+static std::vector<osmium::object_id_type> read_ids(const std::string& data, const char* format, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::all) {
+    std::vector<osmium::object_id_type> ids;
+    osmium::io::File file{data.data(), data.size(), format};
+    osmium::io::Reader reader{file, entities};
+    REQUIRE(reader.header().get("generator") == "test");
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            if (object.type() == osmium::item_type::node) {
+                const auto& node = static_cast<const osmium::Node&>(object);
+                REQUIRE(node.location() == osmium::Location(1.5, 2.5));
+                REQUIRE(std::string{node.tags().get_value_by_key("name")} == "<node>");
+            }
+            ids.push_back(object.type() == osmium::item_type::way ? -object.id() : object.id());
+        }
+    }
+    reader.close();
+    return ids;
+}
+
+TEST_CASE("Parse large XML file in parallel") {
+    const std::string data = large_xml(30000);
+
+    const auto ids = read_ids(data, "osm,xml_parallel=true");
+    REQUIRE(ids.size() == 30001);
+    for (int i = 0; i < 30000; ++i) {
+        REQUIRE(ids[i] == i + 1);
+    }
+    REQUIRE(ids.back() == -1);
+
+    REQUIRE(ids == read_ids(data, "osm"));
+}
+
+TEST_CASE("Parse large XML file in parallel reading only ways") {
+    const std::string data = large_xml(30000);
+
+    const auto ids = read_ids(data, "osm,xml_parallel=true", osmium::osm_entity_bits::way);
+    REQUIRE(ids.size() == 1);
+    REQUIRE(ids.front() == -1);
+}
+
+TEST_CASE("Parse XML file in parallel reading only the header") {
+    const std::string data = large_xml(10);
+    osmium::io::File file{data.data(), data.size(), "osm,xml_parallel=true"};
+    osmium::io::Reader reader{file, osmium::osm_entity_bits::nothing};
+    const auto header = reader.header();
+    REQUIRE(header.get("generator") == "test");
+    REQUIRE(header.box() == osmium::Box(2, 1, 4, 3));
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
+
+TEST_CASE("Errors in parallel XML parsing report the right line") {
+    const std::string data = large_xml(30000, 20000);
+
+    for (const char* format : {"osm", "osm,xml_parallel=true"}) {
+        osmium::io::File file{data.data(), data.size(), format};
+        osmium::io::Reader reader{file};
+        try {
+            while (reader.read()) {
+            }
+            REQUIRE(false);
+        } catch (const osmium::xml_error& e) {
+            REQUIRE(e.line == 3 + 3 * 19999 + 2);
+        }
+    }
+}
+
+TEST_CASE("Change files are parsed in one thread with xml_parallel set") {
+    const std::string data{"<osmChange version=\"0.6\" generator=\"test\">\n"
+                           "<create><node id=\"1\" version=\"1\" lat=\"2.5\" lon=\"1.5\"><tag k=\"name\" v=\"&lt;node&gt;\"/></node></create>\n"
+                           "<delete><node id=\"2\" version=\"2\"/></delete>\n"
+                           "</osmChange>\n"};
+    osmium::io::File file{data.data(), data.size(), "osc,xml_parallel=true"};
+    osmium::io::Reader reader{file};
+    const osmium::memory::Buffer buffer = reader.read();
+    REQUIRE(buffer);
+    auto it = buffer.select<osmium::Node>().cbegin();
+    REQUIRE(it->id() == 1);
+    REQUIRE(it->visible());
+    ++it;
+    REQUIRE(it->id() == 2);
+    REQUIRE_FALSE(it->visible());
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
+
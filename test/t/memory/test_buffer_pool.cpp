@@ -0,0 +1,146 @@
+#include "catch.hpp"
+
+#include <string>
+#include <utility>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/memory/callback_buffer.hpp>
+
+using namespace osmium::builder::attr;
+
+TEST_CASE("Buffer pool allocates buffers if it is empty") {
+    osmium::memory::BufferPool pool;
+    REQUIRE(pool.size() == 0);
+
+    const auto buffer = pool.get(1000);
+    REQUIRE(buffer);
+    REQUIRE(buffer.capacity() >= 1000);
+    REQUIRE(buffer.committed() == 0);
+    REQUIRE(pool.stats().allocated == 1);
+    REQUIRE(pool.stats().reused == 0);
+}
+
+TEST_CASE("Buffer pool reuses buffers put back") {
+    osmium::memory::BufferPool pool;
+
+    auto buffer = pool.get(1000);
+    osmium::builder::add_node(buffer, _id(1));
+    const auto data = buffer.data();
+    pool.put(std::move(buffer));
+    REQUIRE(pool.size() == 1);
+
+    auto buffer2 = pool.get(500, osmium::memory::Buffer::auto_grow::no);
+    REQUIRE(pool.size() == 0);
+    REQUIRE(buffer2.data() == data);
+    REQUIRE(buffer2.committed() == 0);
+    REQUIRE(buffer2.written() == 0);
+
+    // auto_grow was set to no
+    REQUIRE_THROWS_AS(buffer2.reserve_space(2000), const osmium::buffer_is_full&);
+
+    const auto stats = pool.stats();
+    REQUIRE(stats.allocated == 1);
+    REQUIRE(stats.reused == 1);
+    REQUIRE(stats.returned == 1);
+    REQUIRE(stats.dropped == 0);
+}
+
+TEST_CASE("Buffer pool doesn't hand out buffers that are too small") {
+    osmium::memory::BufferPool pool;
+
+    pool.put(osmium::memory::Buffer{1000});
+    REQUIRE(pool.size() == 1);
+
+    const auto buffer = pool.get(5000);
+    REQUIRE(buffer.capacity() >= 5000);
+    REQUIRE(pool.size() == 0);
+    REQUIRE(pool.stats().allocated == 1);
+    REQUIRE(pool.stats().dropped == 1);
+}
+
+TEST_CASE("Buffer pool keeps only the maximum number of buffers") {
+    osmium::memory::BufferPool pool{2};
+
+    pool.put(osmium::memory::Buffer{1000});
+    pool.put(osmium::memory::Buffer{1000});
+    pool.put(osmium::memory::Buffer{1000});
+    REQUIRE(pool.size() == 2);
+    REQUIRE(pool.stats().dropped == 1);
+
+    pool.clear();
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("Buffer pool ignores invalid and externally managed buffers") {
+    osmium::memory::BufferPool pool;
+
+    pool.put(osmium::memory::Buffer{});
+
+    alignas(osmium::memory::align_bytes) unsigned char data[64];
+    pool.put(osmium::memory::Buffer{data, sizeof(data), 0});
+
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("Shared buffers are put back into the pool") {
+    osmium::memory::BufferPool pool;
+
+    {
+        const auto shared = pool.share(pool.get(1000));
+        const auto copy = shared;
+        REQUIRE(pool.size() == 0);
+    }
+
+    REQUIRE(pool.size() == 1);
+}
+
+TEST_CASE("Callback buffer with buffer pool") {
+    osmium::memory::BufferPool pool;
+    pool.put(osmium::memory::Buffer{1000});
+    pool.put(osmium::memory::Buffer{1000});
+
+    osmium::memory::CallbackBuffer cb{[&](osmium::memory::Buffer&& buffer) {
+        pool.put(std::move(buffer));
+    }, 1000, 10};
+    cb.set_buffer_pool(&pool);
+
+    osmium::builder::add_node(cb.buffer(), _id(1));
+    cb.possibly_flush();
+    osmium::builder::add_node(cb.buffer(), _id(2));
+    cb.possibly_flush();
+
+    REQUIRE(pool.stats().allocated == 0);
+    REQUIRE(pool.stats().reused == 2);
+    REQUIRE(pool.size() == 2);
+}
+
+TEST_CASE("Reader and Writer with buffer pool") {
+    std::string data;
+    for (int i = 1; i <= 10000; ++i) {
+        data += "n" + std::to_string(i) + " v1 dV c1 t2017-01-01T00:00:00Z i1 uuser Tname=foo x1.5 y2.5\n";
+    }
+
+    osmium::memory::BufferPool pool;
+    int count = 0;
+    {
+        osmium::io::File input{data.data(), data.size(), "opl"};
+        osmium::io::Reader reader{input, pool};
+        osmium::io::Writer writer{osmium::io::File{"test-buffer-pool.opl"}, pool, osmium::io::overwrite::allow};
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            count += static_cast<int>(std::distance(buffer.select<osmium::Node>().begin(), buffer.select<osmium::Node>().end()));
+            writer(std::move(buffer));
+        }
+        writer.close();
+        reader.close();
+    }
+
+    REQUIRE(count == 10000);
+    REQUIRE(pool.size() > 0);
+    REQUIRE(pool.stats().returned > 0);
+}
+
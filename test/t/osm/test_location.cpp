@@ -182,6 +182,10 @@ void C(const char* s, long v, const char* r = "") {
     data = &x;
     REQUIRE(osmium::detail::string_to_location_coordinate(data) == -v);
     REQUIRE(std::string{*data} == r);
+    x = strm.c_str();
+    data = &x;
+    REQUIRE(osmium::detail::general_string_to_location_coordinate(data) == -v);
+    REQUIRE(std::string{*data} == r);
 }
 
 void F(const char* s) {
@@ -334,6 +338,26 @@ TEST_CASE("Parsing coordinates from strings") {
     C("1.1e2:", 1100000000, ":");
 }
 
+TEST_CASE("Fast and general parsing of coordinates give the same results") {
+    const char* const inputs[] = {
+        "0", "1", "12", "123", "1234", "1.", ".1", "0.5", "-0.5", "1.2345678",
+        "1.23456789", "1.234567891", "179.99999995", "-179.99999995", "214.7483647",
+        "214.7483648", "999.99999999", "1.5e1", "1.5,", "12 ", "-", "1.x"
+    };
+
+    for (const char* input : inputs) {
+        const char* fast = input;
+        int32_t fast_value = 0;
+        if (osmium::detail::fast_string_to_location_coordinate(&fast, &fast_value)) {
+            const char* general = input;
+            REQUIRE(osmium::detail::general_string_to_location_coordinate(&general) == fast_value);
+            REQUIRE(fast == general);
+        } else {
+            REQUIRE(fast == input);
+        }
+    }
+}
+
 TEST_CASE("Parsing min coordinate from string") {
     const char* minval = "-214.7483648";
     const char** data = &minval;
@@ -1,5 +1,8 @@
 #include "catch.hpp"
 
+#include <ctime>
+#include <iterator>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -117,3 +120,41 @@ TEST_CASE("Invalid timestamps") {
     REQUIRE_THROWS_AS(osmium::Timestamp{"2000-03-32T00:00:00Z"}, const std::invalid_argument&);
 }
 
+
+static_assert(osmium::detail::days_from_civil(1970, 1, 1) == 0, "epoch");
+static_assert(osmium::detail::days_from_civil(2000, 3, 1) == 11017, "after leap day");
+static_assert(osmium::detail::seconds_from_civil(2017, 8, 25, 12, 0, 0) == 1503662400, "seconds");
+static_assert(osmium::detail::civil_year(11016) == 2000 &&
+              osmium::detail::civil_month_from_days(11016) == 2 &&
+              osmium::detail::civil_day(11016) == 29, "leap day");
+
+TEST_CASE("Timestamp parsing and formatting agree with libc") {
+    for (uint32_t t = 1; t < std::numeric_limits<uint32_t>::max() - 9876543u; t += 9876543u) {
+        const time_t sse = t;
+        struct tm tm;
+#ifndef _WIN32
+        gmtime_r(&sse, &tm);
+#else
+        gmtime_s(&tm, &sse);
+#endif
+        char buffer[21];
+        strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+        const osmium::Timestamp timestamp{t};
+        REQUIRE(timestamp.to_iso() == buffer);
+        REQUIRE(osmium::Timestamp{buffer} == timestamp);
+    }
+}
+
+TEST_CASE("Timestamp with leap second is normalized") {
+    REQUIRE(osmium::Timestamp{"2016-12-31T23:59:60Z"}.to_iso() == "2017-01-01T00:00:00Z");
+}
+
+TEST_CASE("Timestamp can be written to output iterator") {
+    std::string out{"t="};
+    osmium::Timestamp{"2016-02-29T12:34:56Z"}.to_iso(std::back_inserter(out));
+    REQUIRE(out == "t=2016-02-29T12:34:56Z");
+
+    osmium::Timestamp{}.to_iso(std::back_inserter(out));
+    REQUIRE(out == "t=2016-02-29T12:34:56Z");
+}
@@ -0,0 +1,107 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <osmium/thread/bounded_queue.hpp>
+#include <osmium/thread/queue.hpp>
+
+TEST_CASE("bounded queue keeps order") {
+    osmium::thread::BoundedQueue<std::string> queue{3, "test"};
+    REQUIRE(queue.empty());
+
+    queue.push("a");
+    queue.push("b");
+    queue.push("c");
+    REQUIRE(queue.size() == 3);
+
+    std::string value;
+    queue.wait_and_pop(value);
+    REQUIRE(value == "a");
+    queue.push("d");
+
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == "b");
+    queue.wait_and_pop(value);
+    REQUIRE(value == "c");
+    queue.wait_and_pop(value);
+    REQUIRE(value == "d");
+
+    REQUIRE(queue.empty());
+    REQUIRE_FALSE(queue.try_pop(value));
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.push_count == 4);
+    REQUIRE(stats.pop_count == 5);
+    REQUIRE(stats.empty_count == 1);
+    REQUIRE(stats.largest_size == 3);
+    REQUIRE(stats.full_count == 0);
+}
+
+TEST_CASE("bounded queue blocks producer when full") {
+    osmium::thread::BoundedQueue<int> queue{2};
+
+    std::thread producer{[&queue] {
+        for (int i = 0; i < 1000; ++i) {
+            queue.push(i);
+        }
+    }};
+
+    for (int i = 0; i < 1000; ++i) {
+        int value = -1;
+        queue.wait_and_pop(value);
+        REQUIRE(value == i);
+    }
+
+    producer.join();
+    REQUIRE(queue.empty());
+    REQUIRE(queue.stats().largest_size <= 2);
+}
+
+TEST_CASE("bounded queue with several producers and consumers") {
+    osmium::thread::BoundedQueue<int> queue{5};
+    std::atomic<long> sum{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 4; ++p) {
+        threads.emplace_back([&queue] {
+            for (int i = 1; i <= 1000; ++i) {
+                queue.push(i);
+            }
+        });
+    }
+    for (int c = 0; c < 4; ++c) {
+        threads.emplace_back([&queue, &sum] {
+            for (int i = 0; i < 1000; ++i) {
+                int value = 0;
+                queue.wait_and_pop(value);
+                sum += value;
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(sum == 4 * 500500);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("queue has statistics") {
+    osmium::thread::Queue<int> queue{10};
+
+    queue.push(1);
+    queue.push(2);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.push_count == 2);
+    REQUIRE(stats.pop_count == 1);
+    REQUIRE(stats.largest_size == 2);
+}
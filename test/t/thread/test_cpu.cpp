@@ -0,0 +1,50 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <osmium/thread/cpu.hpp>
+
+TEST_CASE("parse CPU list") {
+    using v = std::vector<int>;
+    REQUIRE(osmium::thread::detail::parse_cpu_list("") == v{});
+    REQUIRE(osmium::thread::detail::parse_cpu_list("0") == v{0});
+    REQUIRE(osmium::thread::detail::parse_cpu_list("0-3") == (v{0, 1, 2, 3}));
+    REQUIRE(osmium::thread::detail::parse_cpu_list("0-1,4,6-7") == (v{0, 1, 4, 6, 7}));
+    REQUIRE(osmium::thread::detail::parse_cpu_list("6-7,0-1,1") == (v{0, 1, 6, 7}));
+    REQUIRE(osmium::thread::detail::parse_cpu_list("x,3-1,2") == v{2});
+}
+
+TEST_CASE("CPU limit from cgroup quota") {
+    REQUIRE(osmium::thread::detail::cpu_limit_from_quota(-1, 100000) == 0);
+    REQUIRE(osmium::thread::detail::cpu_limit_from_quota(100000, 100000) == 1);
+    REQUIRE(osmium::thread::detail::cpu_limit_from_quota(150000, 100000) == 2);
+    REQUIRE(osmium::thread::detail::cpu_limit_from_quota(400000, 100000) == 4);
+    REQUIRE(osmium::thread::detail::cpu_limit_from_quota(50000, 0) == 0);
+}
+
+TEST_CASE("parse cgroup v2 cpu.max") {
+    REQUIRE(osmium::thread::detail::parse_cgroup_cpu_max("max 100000") == 0);
+    REQUIRE(osmium::thread::detail::parse_cgroup_cpu_max("200000 100000") == 2);
+    REQUIRE(osmium::thread::detail::parse_cgroup_cpu_max("250000 100000") == 3);
+    REQUIRE(osmium::thread::detail::parse_cgroup_cpu_max("") == 0);
+}
+
+TEST_CASE("available CPUs") {
+    const auto cpus = osmium::thread::available_cpus();
+    REQUIRE_FALSE(cpus.empty());
+
+    const int count = osmium::thread::available_cpu_count();
+    REQUIRE(count >= 1);
+    REQUIRE(count <= static_cast<int>(cpus.size()));
+}
+
+TEST_CASE("NUMA nodes only contain available CPUs") {
+    const auto cpus = osmium::thread::available_cpus();
+    for (const auto& node : osmium::thread::numa_node_cpus(cpus)) {
+        REQUIRE_FALSE(node.empty());
+        for (const int cpu : node) {
+            REQUIRE(std::find(cpus.begin(), cpus.end(), cpu) != cpus.end());
+        }
+    }
+}
@@ -1,8 +1,12 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <future>
 #include <stdexcept>
 #include <thread>
+#include <vector>
 
 #include <osmium/thread/pool.hpp>
 #include <osmium/util/compatibility.hpp>
@@ -116,3 +120,124 @@ TEST_CASE("thread (user-provided pool)") {
 
 }
 
+
+TEST_CASE("maximum number of threads in pool can be changed") {
+    REQUIRE(osmium::thread::detail::get_pool_size(1000, 0, 16, 96) == 96);
+    REQUIRE(osmium::thread::detail::get_pool_size(  64, 0, 16, 96) == 64);
+    REQUIRE(osmium::thread::detail::get_pool_size(   0, 0, 128, 96) == 96);
+}
+
+TEST_CASE("thread pool runs many jobs with small queue") {
+    osmium::thread::Pool pool{4, 2};
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(pool.submit([i] {
+            return i * 2;
+        }));
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(futures[i].get() == i * 2);
+    }
+
+    REQUIRE(pool.queue_empty());
+}
+
+TEST_CASE("jobs in thread pool can submit more jobs") {
+    osmium::thread::Pool pool{2, 2};
+
+    auto future = pool.submit([&pool] {
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 100; ++i) {
+            futures.push_back(pool.submit([i] {
+                return i;
+            }));
+        }
+        int sum = 0;
+        for (auto& f : futures) {
+            sum += f.get();
+        }
+        return sum;
+    });
+
+    REQUIRE(future.get() == 4950);
+}
+
+TEST_CASE("all jobs are done when thread pool is destructed") {
+    std::atomic<int> count{0};
+
+    {
+        osmium::thread::Pool pool{4, 1000};
+        for (int i = 0; i < 500; ++i) {
+            pool.submit([&count] {
+                ++count;
+            });
+        }
+    }
+
+    REQUIRE(count == 500);
+}
+
+TEST_CASE("thread pool with options") {
+    osmium::thread::pool_options options;
+    options.num_threads = 2;
+    options.max_queue_size = 4;
+
+    osmium::thread::Pool pool{options};
+    REQUIRE(pool.num_threads() == 2);
+    REQUIRE(pool.worker_cpus(0).empty());
+
+    auto future = pool.submit(test_job_with_result{});
+    REQUIRE(future.get() == 42);
+}
+
+TEST_CASE("thread pool size is limited by available CPUs") {
+    osmium::thread::pool_options options;
+    options.num_threads = -1;
+
+    osmium::thread::Pool pool{options};
+    REQUIRE(pool.num_threads() >= 1);
+    REQUIRE(pool.num_threads() <= std::max(osmium::thread::available_cpu_count() - 1, 1));
+}
+
+TEST_CASE("thread pool with workers pinned to CPUs") {
+    const auto cpus = osmium::thread::available_cpus();
+
+    osmium::thread::pool_options options;
+    options.num_threads = 3;
+
+    SECTION("cores") {
+        options.pinning = osmium::thread::pool_pinning::cores;
+        osmium::thread::Pool pool{options};
+        for (int i = 0; i < pool.num_threads(); ++i) {
+            REQUIRE(pool.worker_cpus(i).size() == 1);
+            REQUIRE(pool.worker_cpus(i)[0] == cpus[std::size_t(i) % cpus.size()]);
+        }
+        REQUIRE(pool.submit(test_job_with_result{}).get() == 42);
+    }
+
+    SECTION("numa nodes") {
+        options.pinning = osmium::thread::pool_pinning::numa_nodes;
+        osmium::thread::Pool pool{options};
+        for (int i = 0; i < pool.num_threads(); ++i) {
+            REQUIRE_FALSE(pool.worker_cpus(i).empty());
+            for (const int cpu : pool.worker_cpus(i)) {
+                REQUIRE(std::find(cpus.begin(), cpus.end(), cpu) != cpus.end());
+            }
+        }
+        REQUIRE(pool.submit(test_job_with_result{}).get() == 42);
+    }
+}
+
+TEST_CASE("pinned thread pools can be destroyed right after creating them") {
+    osmium::thread::pool_options options;
+    options.num_threads = 4;
+    options.pinning = osmium::thread::pool_pinning::cores;
+
+    // Workers might only start when the pool is already being destroyed.
+    for (int i = 0; i < 200; ++i) {
+        osmium::thread::Pool pool{options};
+        REQUIRE(pool.num_threads() == 4);
+    }
+}
@@ -69,6 +69,10 @@ TEST_CASE("get_max_queue_size") {
     REQUIRE(osmium::config::get_max_queue_size("NAME", 7) == 7);
     env = "0";
     REQUIRE(osmium::config::get_max_queue_size("NAME", 7) == 7);
+    env = "-1";
+    REQUIRE(osmium::config::get_max_queue_size("NAME", 7) == 7);
+    env = "x";
+    REQUIRE(osmium::config::get_max_queue_size("NAME", 7) == 7);
     env = "3";
     REQUIRE(osmium::config::get_max_queue_size("NAME", 7) == 3);
 }
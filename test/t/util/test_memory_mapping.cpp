@@ -2,6 +2,7 @@
 
 #include <cstdlib>
 #include <limits>
+#include <system_error>
 #include <utility>
 
 #include <osmium/util/file.hpp>
@@ -408,3 +409,87 @@ TEST_CASE("Anonymous memory mapping class: remapping to smaller size should work
 }
 #endif
 
+TEST_CASE("Anonymous memory mapping class: default options") {
+    const osmium::util::AnonymousMemoryMapping mapping{1000};
+    REQUIRE(mapping.options().huge_pages == osmium::util::mapping_options::huge_pages_mode::none);
+    REQUIRE(mapping.options().access == osmium::util::mapping_options::access_mode::normal);
+    REQUIRE_FALSE(mapping.options().populate);
+}
+
+TEST_CASE("Anonymous memory mapping class: mapping with options should work") {
+    osmium::util::mapping_options options;
+    options.huge_pages = osmium::util::mapping_options::huge_pages_mode::transparent;
+    options.access = osmium::util::mapping_options::access_mode::random;
+    options.populate = true;
+
+    osmium::util::AnonymousMemoryMapping mapping{4 * 1024 * 1024, options};
+    REQUIRE(mapping.options().huge_pages == osmium::util::mapping_options::huge_pages_mode::transparent);
+    REQUIRE(mapping.options().access == osmium::util::mapping_options::access_mode::random);
+    REQUIRE(mapping.options().populate);
+
+    int* addr1 = mapping.get_addr<int>();
+    *addr1 = 42;
+
+#ifdef __linux__
+    mapping.resize(8 * 1024 * 1024);
+    REQUIRE(mapping.options().populate);
+
+    const int* addr2 = mapping.get_addr<int>();
+    REQUIRE(*addr2 == 42);
+#endif
+
+    osmium::util::AnonymousMemoryMapping mapping2{std::move(mapping)};
+    REQUIRE(mapping2.options().populate);
+    REQUIRE(*mapping2.get_addr<int>() == 42);
+}
+
+TEST_CASE("Anonymous memory mapping class: mapping with hugetlb pages") {
+    osmium::util::mapping_options options;
+    options.huge_pages = osmium::util::mapping_options::huge_pages_mode::hugetlb;
+
+    // This only works if the system has huge pages reserved, otherwise
+    // the mapping fails.
+    try {
+        osmium::util::AnonymousMemoryMapping mapping{1000, options};
+        REQUIRE(mapping.size() == 1000);
+
+        int* addr1 = mapping.get_addr<int>();
+        *addr1 = 42;
+
+#ifdef __linux__
+        mapping.resize(osmium::util::get_huge_pagesize() * 2);
+        const int* addr2 = mapping.get_addr<int>();
+        REQUIRE(*addr2 == 42);
+#endif
+
+        mapping.unmap();
+        REQUIRE(!mapping);
+    } catch (const std::system_error&) {
+        // no huge pages available on this system
+    }
+}
+
+TEST_CASE("File-based mapping: mapping with options should work") {
+    char filename[] = "test_mmap_options_XXXXXX";
+    const int fd = mkstemp(filename);
+    REQUIRE(fd > 0);
+
+    osmium::util::mapping_options options;
+    options.access = osmium::util::mapping_options::access_mode::sequential;
+    options.populate = true;
+
+    {
+        osmium::util::MemoryMapping mapping{100, osmium::util::MemoryMapping::mapping_mode::write_shared, fd, 0, options};
+        REQUIRE(mapping.options().access == osmium::util::mapping_options::access_mode::sequential);
+        *mapping.get_addr<int>() = 1234;
+
+        mapping.resize(8000);
+        REQUIRE(*mapping.get_addr<int>() == 1234);
+        REQUIRE(mapping.options().populate);
+    }
+
+    REQUIRE(osmium::util::file_size(fd) == 8000);
+
+    REQUIRE(0 == close(fd));
+    REQUIRE(0 == unlink(filename));
+}